@@ -0,0 +1,87 @@
+#include "candlewick/core/Camera.h"
+#include "candlewick/core/Components.h"
+#include "candlewick/core/Culling.h"
+#include "candlewick/core/FrustumCuller.h"
+
+#include <benchmark/benchmark.h>
+#include <entt/entity/registry.hpp>
+#include <random>
+
+using namespace candlewick;
+
+/// \p n random boxes of size up to 1, in a 200 x 200 x 20 slab in front of
+/// the camera of frustum().
+static std::vector<AABBf> randomBoxes(size_t n) {
+  std::mt19937 rng{42};
+  std::uniform_real_distribution<float> xy{-100.f, 100.f}, z{-20.f, 0.f},
+      size{0.1f, 1.f};
+  std::vector<AABBf> boxes;
+  boxes.reserve(n);
+  for (size_t i = 0; i < n; i++) {
+    const Float3 lo{xy(rng), xy(rng), z(rng)};
+    boxes.emplace_back(lo, lo + Float3{size(rng), size(rng), size(rng)});
+  }
+  return boxes;
+}
+
+static FrustumPlanes frustum() {
+  const Mat4f proj =
+      perspectiveFromFov(deg2rad(55.f), 16.f / 9.f, 0.1f, 500.f);
+  const Mat4f view =
+      lookAt({0.f, -60.f, 30.f}, Float3::Zero(), Float3::UnitZ());
+  return FrustumPlanes::fromClipMatrix(proj * view);
+}
+
+/// Baseline: one box at a time.
+static void BM_cullScalar(benchmark::State &state) {
+  const auto boxes = randomBoxes(size_t(state.range(0)));
+  const FrustumPlanes planes = frustum();
+  std::vector<Uint8> visible(boxes.size());
+  for (auto _ : state) {
+    for (size_t i = 0; i < boxes.size(); i++)
+      visible[i] = planes.intersectsBox(boxes[i]);
+    benchmark::DoNotOptimize(visible.data());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+/// AabbBatch::cull(), with the batch filled once.
+static void BM_cullBatch(benchmark::State &state) {
+  const auto boxes = randomBoxes(size_t(state.range(0)));
+  const FrustumPlanes planes = frustum();
+  AabbBatch batch;
+  for (const AABBf &box : boxes)
+    batch.push(box);
+  std::vector<Uint8> visible;
+  for (auto _ : state) {
+    batch.cull(planes, visible);
+    benchmark::DoNotOptimize(visible.data());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+/// FrustumCuller::cull() over registry entities: gathering the world bounds
+/// into the batch, the test and the compaction of the visible entities.
+static void BM_cullEntities(benchmark::State &state) {
+  const auto boxes = randomBoxes(size_t(state.range(0)));
+  const FrustumPlanes planes = frustum();
+  entt::registry registry;
+  for (const AABBf &box : boxes) {
+    auto ent = registry.create();
+    registry.emplace<TransformComponent>(ent, Mat4f::Identity());
+    registry.emplace<WorldBoundsComponent>(ent, box);
+  }
+  auto view = registry.view<const TransformComponent>();
+  FrustumCuller culler;
+  size_t numVisible = 0;
+  for (auto _ : state) {
+    numVisible = culler.cull(registry, view, planes).size();
+    benchmark::DoNotOptimize(numVisible);
+  }
+  state.counters["visible"] = double(numVisible);
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK(BM_cullScalar)->Arg(10000)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_cullBatch)->Arg(10000)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_cullEntities)->Arg(10000)->Unit(benchmark::kMicrosecond);
@@ -0,0 +1,53 @@
+#include "candlewick/multibody/LoadPinocchioGeometry.h"
+
+#include <benchmark/benchmark.h>
+#include <robot_descriptions_cpp/robot_load.hpp>
+#include <pinocchio/multibody/geometry.hpp>
+
+#include <algorithm>
+#include <thread>
+
+using namespace candlewick;
+using namespace candlewick::multibody;
+
+/// Build a large geometry model by replicating the geometry objects of a
+/// robot description, to mimic robots with many high-poly links.
+static pin::GeometryModel makeGeometryModel(Uint32 num_copies) {
+  pin::Model model;
+  pin::GeometryModel base_model;
+  robot_descriptions::loadModelsFromToml("ur.toml", "ur5_gripper", model,
+                                         &base_model, NULL);
+  pin::GeometryModel geom_model;
+  for (Uint32 k = 0; k < num_copies; k++) {
+    for (auto gobj : base_model.geometryObjects) {
+      gobj.name += "_" + std::to_string(k);
+      geom_model.addGeometryObject(gobj);
+    }
+  }
+  return geom_model;
+}
+
+static void BM_loadGeometryModel(benchmark::State &state) {
+  const Uint32 num_threads = Uint32(state.range(0));
+  const pin::GeometryModel geom_model = makeGeometryModel(4);
+  for (auto _ : state) {
+    auto meshDatas = loadGeometryModel(geom_model, num_threads);
+    benchmark::DoNotOptimize(meshDatas);
+  }
+  state.counters["ngeoms"] = double(geom_model.ngeoms);
+  state.counters["geoms/s"] = benchmark::Counter(
+      double(geom_model.ngeoms), benchmark::Counter::kIsIterationInvariantRate);
+}
+
+static void threadCountArgs(benchmark::internal::Benchmark *b) {
+  const int max_threads =
+      std::max(1, int(std::thread::hardware_concurrency()));
+  for (int n = 1; n < max_threads; n *= 2)
+    b->Arg(n);
+  b->Arg(max_threads);
+}
+
+BENCHMARK(BM_loadGeometryModel)
+    ->Apply(threadCountArgs)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
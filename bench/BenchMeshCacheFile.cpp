@@ -0,0 +1,39 @@
+#include "candlewick/utils/LoadMesh.h"
+#include "candlewick/utils/MeshCacheFile.h"
+#include "candlewick/utils/MeshData.h"
+
+#include <benchmark/benchmark.h>
+
+using namespace candlewick;
+
+static const char *meshFilename = CANDLEWICK_ASSETS_DIR "/meshes/teapot.obj";
+
+static void BM_loadSceneMeshes_cold(benchmark::State &state) {
+  setMeshCacheFileEnabled(false);
+  for (auto _ : state) {
+    std::vector<MeshData> meshData;
+    loadSceneMeshes(meshFilename, meshData);
+    benchmark::DoNotOptimize(meshData);
+  }
+}
+
+static void BM_loadSceneMeshes_warm(benchmark::State &state) {
+  const auto cacheDir =
+      std::filesystem::temp_directory_path() / "candlewick-bench-mesh-cache";
+  setMeshCacheDirectory(cacheDir);
+  setMeshCacheFileEnabled(true);
+  {
+    // first import writes the cache file
+    std::vector<MeshData> meshData;
+    loadSceneMeshes(meshFilename, meshData);
+  }
+  for (auto _ : state) {
+    std::vector<MeshData> meshData;
+    loadSceneMeshes(meshFilename, meshData);
+    benchmark::DoNotOptimize(meshData);
+  }
+  std::filesystem::remove_all(cacheDir);
+}
+
+BENCHMARK(BM_loadSceneMeshes_cold)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_loadSceneMeshes_warm)->Unit(benchmark::kMillisecond);
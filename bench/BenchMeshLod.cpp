@@ -0,0 +1,165 @@
+#include "candlewick/core/CommandBuffer.h"
+#include "candlewick/core/DefaultVertex.h"
+#include "candlewick/core/DepthAndShadowPass.h"
+#include "candlewick/core/Device.h"
+#include "candlewick/core/Mesh.h"
+#include "candlewick/core/Shader.h"
+#include "candlewick/utils/MeshData.h"
+#include "candlewick/utils/MeshTransforms.h"
+
+#include <benchmark/benchmark.h>
+#include <entt/entity/entity.hpp>
+#include <SDL3/SDL_init.h>
+
+using namespace candlewick;
+
+static Device &benchDevice() {
+  static Device device = [] {
+    SDL_Init(SDL_INIT_VIDEO);
+    return Device{auto_detect_shader_format_subset()};
+  }();
+  return device;
+}
+
+/// Bumpy sphere with \p n x \p n vertices, standing in for a high-poly visual
+/// mesh.
+static MeshData makeSphere(Uint32 n) {
+  std::vector<PosNormalVertex> vertices;
+  vertices.reserve(n * n);
+  for (Uint32 j = 0; j < n; j++) {
+    const float theta = constants::Pif * float(j) / float(n - 1);
+    for (Uint32 i = 0; i < n; i++) {
+      const float phi = 2.f * constants::Pif * float(i) / float(n - 1);
+      const Float3 dir{std::sin(theta) * std::cos(phi),
+                       std::sin(theta) * std::sin(phi), std::cos(theta)};
+      const float r =
+          1.f + 0.05f * std::sin(8.f * phi) * std::sin(6.f * theta);
+      vertices.push_back({r * dir, dir});
+    }
+  }
+  std::vector<Uint32> indices;
+  indices.reserve(6 * (n - 1) * (n - 1));
+  for (Uint32 j = 0; j + 1 < n; j++) {
+    for (Uint32 i = 0; i + 1 < n; i++) {
+      const Uint32 v = j * n + i;
+      indices.insert(indices.end(), {v, v + n + 1, v + 1});
+      indices.insert(indices.end(), {v, v + n, v + n + 1});
+    }
+  }
+  return MeshData{SDL_GPU_PRIMITIVETYPE_TRIANGLELIST, std::move(vertices),
+                  std::move(indices)};
+}
+
+/// Cost of building the LOD chain at import. range(0): sphere resolution.
+static void BM_generateLodChain(benchmark::State &state) {
+  const MeshData source = makeSphere(Uint32(state.range(0)));
+  for (auto _ : state) {
+    MeshData data = MeshData::copy(source);
+    generateLodChain(data);
+    benchmark::DoNotOptimize(data.indexData.data());
+  }
+  state.counters["triangles"] = double(source.numIndices() / 3);
+  state.counters["triangles/s"] =
+      benchmark::Counter(double(source.numIndices() / 3),
+                         benchmark::Counter::kIsIterationInvariantRate);
+}
+
+BENCHMARK(BM_generateLodChain)
+    ->Arg(64)
+    ->Arg(256)
+    ->Arg(1024)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+/// Frame time and triangle count of a depth-only pass over a row of receding
+/// high-poly meshes. range(0): LOD pixel error threshold (0 disables LOD
+/// selection).
+static void BM_depthPassLod(benchmark::State &state) {
+  const Device &device = benchDevice();
+  constexpr Uint32 width = 1920, height = 1080;
+  constexpr Uint32 numObjects = 64;
+
+  MeshData data = makeSphere(512);
+  generateLodChain(data);
+  Mesh mesh = createMesh(device, data, true);
+
+  SDL_GPUTextureCreateInfo texInfo{
+      .type = SDL_GPU_TEXTURETYPE_2D,
+      .format = SDL_GPU_TEXTUREFORMAT_D32_FLOAT,
+      .usage = SDL_GPU_TEXTUREUSAGE_DEPTH_STENCIL_TARGET,
+      .width = width,
+      .height = height,
+      .layer_count_or_depth = 1,
+      .num_levels = 1,
+      .sample_count = SDL_GPU_SAMPLECOUNT_1,
+      .props = 0,
+  };
+  SDL_GPUTexture *depthTexture = SDL_CreateGPUTexture(device, &texInfo);
+
+  auto vertexShader = Shader::fromMetadata(device, "ShadowCast.vert");
+  auto fragmentShader = Shader::fromMetadata(device, "ShadowCast.frag");
+  SDL_GPUGraphicsPipelineCreateInfo pipeline_desc{
+      .vertex_shader = vertexShader,
+      .fragment_shader = fragmentShader,
+      .vertex_input_state = mesh.layout().toVertexInputState(),
+      .primitive_type = SDL_GPU_PRIMITIVETYPE_TRIANGLELIST,
+      .depth_stencil_state{.compare_op = SDL_GPU_COMPAREOP_LESS,
+                           .enable_depth_test = true,
+                           .enable_depth_write = true},
+      .target_info{.num_color_targets = 0,
+                   .depth_stencil_format = texInfo.format,
+                   .has_depth_stencil_target = true},
+  };
+
+  DepthPassInfo passInfo;
+  passInfo.depthTexture = depthTexture;
+  passInfo.pipeline = SDL_CreateGPUGraphicsPipeline(device, &pipeline_desc);
+  passInfo.lodPixelError = float(state.range(0));
+  passInfo.lodViewportHeight = float(height);
+
+  const Camera camera{
+      .projection = perspectiveFromFov(deg2rad(55.f),
+                                       float(width) / float(height), 0.1f,
+                                       500.f),
+      .view = Eigen::Isometry3f{
+          lookAt({0.f, 2.f, 0.f}, {0.f, 0.f, -10.f}, Float3::UnitY())},
+  };
+  std::vector<OpaqueCastable> castables;
+  for (Uint32 i = 0; i < numObjects; i++) {
+    Mat4f tr = Mat4f::Identity();
+    tr.topRightCorner<3, 1>() = Float3{(i % 2) ? 2.f : -2.f, 0.f,
+                                       -3.f - 3.f * float(i / 2)};
+    castables.push_back({entt::null, mesh, tr});
+  }
+
+  double triangles = 0.;
+  for (const OpaqueCastable &cs : castables) {
+    const Uint32 lod = selectLod(mesh, camera.viewProj(), cs.transform,
+                                 passInfo.lodViewportHeight,
+                                 passInfo.lodPixelError);
+    for (const MeshView &view : mesh.lodViews(lod))
+      triangles += view.indexCount / 3;
+  }
+
+  for (auto _ : state) {
+    CommandBuffer command_buffer{device};
+    renderDepthOnlyPass(command_buffer, passInfo, camera.viewProj(),
+                        castables);
+    command_buffer.submit();
+    SDL_WaitForGPUIdle(device);
+  }
+  state.counters["triangles"] = triangles;
+  state.counters["full_triangles"] = double(numObjects) *
+                                     double(data.baseIndexCount() / 3);
+
+  SDL_ReleaseGPUGraphicsPipeline(device, passInfo.pipeline);
+  SDL_ReleaseGPUTexture(device, depthTexture);
+}
+
+BENCHMARK(BM_depthPassLod)
+    ->Arg(0)
+    ->Arg(1)
+    ->Arg(4)
+    ->ArgName("pixel_error")
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
@@ -0,0 +1,59 @@
+#include "candlewick/core/CommandBuffer.h"
+#include "candlewick/core/DefaultVertex.h"
+#include "candlewick/core/Device.h"
+#include "candlewick/core/Mesh.h"
+#include "candlewick/utils/MeshData.h"
+
+#include <benchmark/benchmark.h>
+#include <SDL3/SDL_init.h>
+
+using namespace candlewick;
+
+static Device &benchDevice() {
+  static Device device = [] {
+    SDL_Init(SDL_INIT_VIDEO);
+    return Device{auto_detect_shader_format_subset()};
+  }();
+  return device;
+}
+
+static MeshData makeMeshData(Uint32 numVertices) {
+  std::vector<DefaultVertex> vertices(numVertices);
+  for (Uint32 i = 0; i < numVertices; i++) {
+    vertices[i].pos = {float(i), 0.f, 0.f};
+    vertices[i].normal = {0.f, 0.f, 1.f};
+    vertices[i].color = {1.f, 1.f, 1.f, 1.f};
+  }
+  return MeshData{SDL_GPU_PRIMITIVETYPE_TRIANGLELIST, std::move(vertices)};
+}
+
+/// Sustained throughput of per-frame vertex updates, one command buffer per
+/// update. range(0): number of vertices in the mesh, range(1): fraction of the
+/// mesh updated, in percent.
+static void BM_updateMeshVertices(benchmark::State &state) {
+  const Device &device = benchDevice();
+  const Uint32 numVertices = Uint32(state.range(0));
+  const Uint32 count = Uint32(numVertices * state.range(1) / 100);
+  MeshData data = makeMeshData(numVertices);
+  Mesh mesh = createMesh(device, data, true);
+  std::span<const DefaultVertex> vertices =
+      data.viewAs<DefaultVertex>().subspan(0, count);
+
+  Uint32 frame = 0;
+  for (auto _ : state) {
+    // emulate a deforming mesh
+    data.viewAs<DefaultVertex>()[0].pos.z() = float(frame++);
+    CommandBuffer command_buffer{device};
+    updateMeshVertices(device, command_buffer, mesh, 0, vertices);
+    device.uploadRing().submit(command_buffer);
+  }
+  SDL_WaitForGPUIdle(device);
+  state.SetBytesProcessed(Sint64(state.iterations()) * Sint64(count) *
+                          Sint64(sizeof(DefaultVertex)));
+}
+
+BENCHMARK(BM_updateMeshVertices)
+    ->ArgsProduct({{1 << 12, 1 << 16, 1 << 20}, {100, 25}})
+    ->ArgNames({"vertices", "percent"})
+    ->Unit(benchmark::kMicrosecond)
+    ->UseRealTime();
@@ -6,6 +6,7 @@
 #include "candlewick/utils/MeshData.h"
 #include "candlewick/utils/LoadMesh.h"
 #include "candlewick/core/CameraControls.h"
+#include "candlewick/core/DepthAndShadowPass.h"
 #include "candlewick/core/LightUniforms.h"
 #include "candlewick/core/TransformUniforms.h"
 
@@ -211,7 +212,7 @@ int main() {
       SDL_BindGPUGraphicsPipeline(render_pass, pipeline);
       SDL_BindGPUVertexBuffers(render_pass, 0, &vertex_binding, 1);
       SDL_BindGPUIndexBuffer(render_pass, &index_binding,
-                             SDL_GPU_INDEXELEMENTSIZE_32BIT);
+                             meshes[0].indexElementSize);
 
       TransformUniformData cameraUniform{
           .modelView = modelView.matrix(),
@@ -232,6 +233,10 @@ int main() {
                                      sizeof(materialUbo));
       SDL_PushGPUFragmentUniformData(command_buffer, 1, &lightUbo,
                                      sizeof(lightUbo));
+      // no shadow map: no cascades
+      const ShadowCascadeUniforms shadowUbo{};
+      SDL_PushGPUFragmentUniformData(command_buffer, 3, &shadowUbo,
+                                     sizeof(shadowUbo));
       SDL_DrawGPUIndexedPrimitives(render_pass, meshes[0].indexCount, 1, 0, 0,
                                    0);
 
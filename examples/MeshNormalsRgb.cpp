@@ -211,7 +211,7 @@ int main() {
       SDL_BindGPUGraphicsPipeline(render_pass, pipeline);
       SDL_BindGPUVertexBuffers(render_pass, 0, &vertex_binding, 1);
       SDL_BindGPUIndexBuffer(render_pass, &index_binding,
-                             SDL_GPU_INDEXELEMENTSIZE_32BIT);
+                             meshes[0].indexElementSize);
 
       TransformUniformData cameraUniform{
           projViewMat,
@@ -258,9 +258,6 @@ int main(int argc, char **argv) {
   robot_debug.addFrameTriad(debug_scene, ee_frame_id);
   robot_debug.addFrameVelocityArrow(debug_scene, ee_frame_id);
 
-  auto depthPassInfo =
-      DepthPassInfo::create(renderer, plane_obj.mesh.layout(), NULL,
-                            {SDL_GPU_CULLMODE_NONE, 0.05f, 0.f, true, false});
   auto &shadowPassInfo = robot_scene.shadowPass;
   auto shadowDebugPass =
       DepthDebugPass::create(renderer, shadowPassInfo.depthTexture);
@@ -399,11 +396,12 @@ int main(int argc, char **argv) {
     if (renderer.waitAndAcquireSwapchain(command_buffer)) {
       const GpuMat4 viewProj = g_camera.camera.viewProj();
       robot_scene.updateTransforms();
+      robot_scene.uploadObjectData(command_buffer);
       robot_scene.collectOpaqueCastables();
       auto &castables = robot_scene.castables();
       renderShadowPassFromAABB(command_buffer, shadowPassInfo, sceneLight,
-                               castables, worldSpaceBounds);
-      renderDepthOnlyPass(command_buffer, depthPassInfo, viewProj, castables);
+                               castables, worldSpaceBounds,
+                               FrustumPlanes::fromClipMatrix(viewProj));
       switch (g_showDebugViz) {
       case FULL_RENDER:
         robot_scene.render(command_buffer, g_camera);
@@ -412,6 +410,8 @@ int main(int argc, char **argv) {
           frustumBoundsDebug.render(command_buffer, g_camera);
         break;
       case DEPTH_DEBUG:
+        // render() draws the depth pre-pass in the full render
+        robot_scene.renderDepthPrepass(command_buffer, g_camera);
         renderDepthDebug(renderer, command_buffer, depthDebugPass,
                          {depth_mode, nearZ, farZ});
         break;
@@ -439,7 +439,6 @@ int main(int argc, char **argv) {
 
   SDL_WaitForGPUIdle(renderer.device);
   frustumBoundsDebug.release();
-  depthPassInfo.release();
   shadowDebugPass.release(renderer.device);
   depthDebugPass.release(renderer.device);
   robot_scene.release();
@@ -13,7 +13,8 @@ void exposeVisualizer() {
   eigenpy::OptionalConverter<ConstVectorRef, std::optional>::registration();
   bp::class_<Visualizer::Config>("VisualizerConfig", bp::init<>())
       .def_readwrite("width", &Visualizer::Config::width)
-      .def_readwrite("height", &Visualizer::Config::height);
+      .def_readwrite("height", &Visualizer::Config::height)
+      .def_readwrite("async_loading", &Visualizer::Config::async_loading);
   bp::class_<Visualizer, boost::noncopyable>("Visualizer", bp::no_init)
       .def(bp::init<Visualizer::Config, const pin::Model &,
                     const pin::GeometryModel &>(
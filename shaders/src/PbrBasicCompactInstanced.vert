@@ -0,0 +1,64 @@
+#version 450
+
+// Variant of PbrBasicCompact.vert which reads the transforms and materials
+// from the per-frame object buffer, see PbrBasicInstanced.vert.
+layout(location=0) in vec3 inPosition;
+layout(location=1) in vec2 inNormal;
+
+// world-space position-normal
+layout(location=0) out vec3 fragViewPos;
+layout(location=1) out vec3 fragViewNormal;
+layout(location=2) out vec3 fragLightPos;
+layout(location=3) flat out uint fragMaterial;
+
+struct ObjectData {
+    mat4 model;
+    mat4 normalMatrix;
+};
+
+layout(std430, set=0, binding=0) readonly buffer ObjectBlock {
+    ObjectData objects[];
+};
+
+// object and material index of each instance
+layout(std430, set=0, binding=1) readonly buffer InstanceBlock {
+    uvec2 instances[];
+};
+
+// set=1 is required, for some reason
+layout(set=1, binding=0) uniform PassBlock
+{
+    mat4 view;
+    mat4 viewProj;
+    mat4 lightViewProj;
+};
+
+layout(set=1, binding=1) uniform DrawBlock
+{
+    uint firstInstance;
+};
+
+out gl_PerVertex {
+    invariant vec4 gl_Position;
+};
+
+vec3 octDecode(vec2 e) {
+    vec3 v = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-v.z, 0.0);
+    v.xy += mix(vec2(t), vec2(-t), greaterThanEqual(v.xy, vec2(0.0)));
+    return normalize(v);
+}
+
+void main() {
+    uvec2 instance = instances[firstInstance + gl_InstanceIndex];
+    ObjectData obj = objects[instance.x];
+    fragMaterial = instance.y;
+    vec4 worldPos = obj.model * vec4(inPosition, 1.0);
+    fragViewPos = vec3(view * worldPos);
+    fragViewNormal =
+        normalize(mat3(view) * mat3(obj.normalMatrix) * octDecode(inNormal));
+    gl_Position = viewProj * worldPos;
+
+    vec4 flps = lightViewProj * worldPos;
+    fragLightPos = flps.xyz / flps.w;
+}
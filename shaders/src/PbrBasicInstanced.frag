@@ -0,0 +1,41 @@
+#version 450
+#define HAS_SHADOW_MAPS
+#define HAS_G_BUFFER
+#define HAS_SSAO
+
+// Variant of PbrBasic.frag for PbrBasicInstanced.vert: the material is read
+// from the object buffer, at the index given by the vertex shader.
+#include "tone_mapping.glsl"
+#include "pbr_material.glsl"
+
+layout(location=3) flat in uint fragMaterial;
+
+// storage buffers follow the samplers in set=2
+layout(std430, set=2, binding=2) readonly buffer MaterialBlock {
+    PbrMaterial materials[];
+};
+#define material materials[fragMaterial]
+
+layout(set=3, binding=0) uniform LightBlock {
+    vec3 direction;
+    vec3 color;
+    float intensity;
+    // direction in NDC space
+    mat4 camProjection;
+} light;
+
+layout(set=3, binding=1) uniform EffectParams {
+    uint useSsao;
+} params;
+
+layout(set=3, binding=2) uniform ShadowBlock {
+    // from view space to the NDC of each cascade of the shadow map
+    mat4 viewToLight[4];
+    // region (offset, size) of each cascade in the shadow map
+    vec4 atlasRects[4];
+    // view distance up to which each cascade is used
+    vec4 splits;
+    uint numCascades;
+} shadows;
+
+#include "pbr_shading.glsl"
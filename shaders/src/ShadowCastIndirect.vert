@@ -0,0 +1,31 @@
+#version 450
+
+// Variant of ShadowCastInstanced.vert for the indirect draws of a
+// GpuDrawList. The object of the draw is a per-instance vertex attribute.
+layout(location=0) in vec3 inPosition;
+// per-draw attribute, see VertexAttrib::DrawObject
+layout(location=8) in uint inObject;
+
+struct ObjectData {
+    // model matrix, including the position dequantization
+    mat4 model;
+    mat4 normalMatrix;
+};
+
+layout(std430, set=0, binding=0) readonly buffer ObjectBlock {
+    ObjectData objects[];
+};
+
+layout(set=1, binding=0) uniform CameraBlock {
+    mat4 viewProj;
+};
+
+out gl_PerVertex {
+    invariant vec4 gl_Position;
+};
+
+void main() {
+    vec4 worldPos = objects[inObject].model * vec4(inPosition, 1.0);
+    // same expression as the main pass, for matching depths
+    gl_Position = viewProj * worldPos;
+}
@@ -0,0 +1,40 @@
+#version 450
+
+// Variant of ShadowCast.vert which reads the model matrices from the
+// per-frame object buffer. Each instance of a draw is an object, at the
+// instance index offset by the current draw's first instance.
+layout(location=0) in vec3 inPosition;
+
+struct ObjectData {
+    // model matrix, including the position dequantization
+    mat4 model;
+    mat4 normalMatrix;
+};
+
+layout(std430, set=0, binding=0) readonly buffer ObjectBlock {
+    ObjectData objects[];
+};
+
+// object index of each instance
+layout(std430, set=0, binding=1) readonly buffer InstanceBlock {
+    uint instanceObjects[];
+};
+
+layout(set=1, binding=0) uniform CameraBlock {
+    mat4 viewProj;
+};
+
+layout(set=1, binding=1) uniform DrawBlock {
+    uint firstInstance;
+};
+
+out gl_PerVertex {
+    invariant vec4 gl_Position;
+};
+
+void main() {
+    uint object = instanceObjects[firstInstance + gl_InstanceIndex];
+    vec4 worldPos = objects[object].model * vec4(inPosition, 1.0);
+    // same expression as the main pass, for matching depths
+    gl_Position = viewProj * worldPos;
+}
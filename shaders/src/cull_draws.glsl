@@ -0,0 +1,180 @@
+// Culling of the draws of a GpuDrawList, included by CullDraws.comp and
+// CullDrawsOcclusion.comp. Writes one indexed indirect draw command per draw,
+// with one instance if its bounds, transformed by the model matrix of its
+// object, are visible, and none otherwise. For shadow casters, the bounds
+// extruded along the light rays must also reach the receiver volume. With
+// OCCLUSION_CULLING, the bounds are also tested against the hierarchical-Z
+// pyramid of an earlier frame.
+//
+// The buffer of the commands starts with counters of the culled draws, which
+// are zeroed before the dispatch.
+layout(local_size_x = 64) in;
+
+struct ObjectData {
+    // model matrix, including the position dequantization
+    mat4 model;
+    mat4 normalMatrix;
+};
+
+struct DrawRecord {
+    vec3 boundsMin;
+    uint object;
+    vec3 boundsMax;
+    uint material;
+    uint indexCount;
+    uint firstIndex;
+    int vertexOffset;
+    uint vertexCount;
+};
+
+// samplers come before the storage buffers of the set
+#ifdef OCCLUSION_CULLING
+layout(set=0, binding=0) uniform sampler2D hizPyramid;
+#define STORAGE_BINDING(i) (i + 1)
+#else
+#define STORAGE_BINDING(i) (i)
+#endif
+
+layout(std430, set=0, binding=STORAGE_BINDING(0)) readonly buffer ObjectBlock {
+    ObjectData objects[];
+};
+
+layout(std430, set=0, binding=STORAGE_BINDING(1)) readonly buffer RecordBlock {
+    DrawRecord records[];
+};
+
+// the counters, then SDL_GPUIndexedIndirectDrawCommand, five words each
+layout(std430, set=1, binding=0) buffer CommandBlock {
+    uint commands[];
+};
+
+layout(set=2, binding=0) uniform CullBlock {
+    // world-space planes (n, d), with dot(n, x) + d >= 0 inside
+    vec4 planes[6];
+    // view-projection matrix of the depths of the pyramid
+    mat4 hizViewProj;
+    // size of the depth texture the pyramid is built from, and the number of
+    // levels of the pyramid
+    vec2 depthSize;
+    uint hizLevels;
+    uint numDraws;
+    // world-space planes of the receiver volume of shadow casters
+    vec4 receiverPlanes[6];
+    // extrusion of the bounds along the light rays, receivers used if w > 0
+    vec4 receiverShift;
+};
+
+#define FRUSTUM_CULLED_COUNTER 0
+#define OCCLUDED_COUNTER 1
+#define RECEIVER_CULLED_COUNTER 2
+#define FIRST_COMMAND 3
+
+bool inFrustum(vec3 center, vec3 halfExtents) {
+    for (int i = 0; i < 6; i++) {
+        vec4 p = planes[i];
+        float radius = dot(abs(p.xyz), halfExtents);
+        if (dot(p.xyz, center) + p.w < -radius)
+            return false;
+    }
+    return true;
+}
+
+bool reachesReceivers(vec3 center, vec3 halfExtents) {
+    // the box and its translation along the light rays
+    vec3 shift = receiverShift.xyz;
+    center += 0.5 * shift;
+    halfExtents += 0.5 * abs(shift);
+    for (int i = 0; i < 6; i++) {
+        vec4 p = receiverPlanes[i];
+        float radius = dot(abs(p.xyz), halfExtents);
+        if (dot(p.xyz, center) + p.w < -radius)
+            return false;
+    }
+    return true;
+}
+
+#ifdef OCCLUSION_CULLING
+bool isOccluded(vec3 center, vec3 halfExtents) {
+    vec3 ndcMin = vec3(1e30);
+    vec3 ndcMax = vec3(-1e30);
+    for (int k = 0; k < 8; k++) {
+        vec3 signs = vec3((k & 1) != 0 ? 1.0 : -1.0,
+                          (k & 2) != 0 ? 1.0 : -1.0,
+                          (k & 4) != 0 ? 1.0 : -1.0);
+        vec4 clip = hizViewProj * vec4(center + signs * halfExtents, 1.0);
+        // boxes crossing the near plane are never occluded
+        if (clip.w <= 0.0)
+            return false;
+        vec3 ndc = clip.xyz / clip.w;
+        ndcMin = min(ndcMin, ndc);
+        ndcMax = max(ndcMax, ndc);
+    }
+    // texture coordinates go down, NDC up
+    vec2 uvMin = clamp(vec2(ndcMin.x, -ndcMax.y) * 0.5 + 0.5, 0.0, 1.0);
+    vec2 uvMax = clamp(vec2(ndcMax.x, -ndcMin.y) * 0.5 + 0.5, 0.0, 1.0);
+    ivec2 depthMax = ivec2(depthSize) - 1;
+    ivec2 lo = min(ivec2(uvMin * depthSize), depthMax);
+    ivec2 hi = min(ivec2(uvMax * depthSize), depthMax);
+    // the level where the rectangle spans at most 2x2 texels: a texel of
+    // level k covers 2^(k+1) depth texels along each axis
+    ivec2 extent = hi - lo;
+    int level = int(ceil(log2(float(max(extent.x, extent.y) + 1)))) - 1;
+    level = clamp(level, 0, int(hizLevels) - 1);
+    // texel coordinates from those of the depth texture, rather than from
+    // normalized coordinates: the level sizes are rounded down, and the last
+    // texels of a level also cover the leftover ones (see HiZDownsample.comp)
+    int scale = 2 << level;
+    ivec2 levelMax = max(ivec2(depthSize) / scale, ivec2(1)) - 1;
+    ivec2 t0 = min(lo / scale, levelMax);
+    ivec2 t1 = min(hi / scale, levelMax);
+    float farthest = max(
+        max(texelFetch(hizPyramid, t0, level).r,
+            texelFetch(hizPyramid, ivec2(t1.x, t0.y), level).r),
+        max(texelFetch(hizPyramid, ivec2(t0.x, t1.y), level).r,
+            texelFetch(hizPyramid, t1, level).r));
+    return ndcMin.z > farthest;
+}
+#endif
+
+bool isVisible(DrawRecord record) {
+    // empty bounds are never culled
+    if (any(greaterThan(record.boundsMin, record.boundsMax)))
+        return true;
+    mat4 model = objects[record.object].model;
+    vec3 center = 0.5 * (record.boundsMin + record.boundsMax);
+    vec3 halfExtents = 0.5 * (record.boundsMax - record.boundsMin);
+    // world-space box around the transformed box (Arvo's method)
+    vec3 worldCenter = (model * vec4(center, 1.0)).xyz;
+    vec3 worldExtents = abs(model[0].xyz) * halfExtents.x
+                      + abs(model[1].xyz) * halfExtents.y
+                      + abs(model[2].xyz) * halfExtents.z;
+    if (!inFrustum(worldCenter, worldExtents)) {
+        atomicAdd(commands[FRUSTUM_CULLED_COUNTER], 1);
+        return false;
+    }
+    if (receiverShift.w > 0.0 && !reachesReceivers(worldCenter, worldExtents)) {
+        atomicAdd(commands[RECEIVER_CULLED_COUNTER], 1);
+        return false;
+    }
+#ifdef OCCLUSION_CULLING
+    if (isOccluded(worldCenter, worldExtents)) {
+        atomicAdd(commands[OCCLUDED_COUNTER], 1);
+        return false;
+    }
+#endif
+    return true;
+}
+
+void main() {
+    uint i = gl_GlobalInvocationID.x;
+    if (i >= numDraws)
+        return;
+    DrawRecord record = records[i];
+    uint base = FIRST_COMMAND + 5 * i;
+    commands[base + 0] = record.indexCount;
+    commands[base + 1] = isVisible(record) ? 1 : 0;
+    commands[base + 2] = record.firstIndex;
+    commands[base + 3] = uint(record.vertexOffset);
+    // the vertex shaders read the draw record of this instance
+    commands[base + 4] = i;
+}
@@ -3,12 +3,14 @@
 
 namespace candlewick {
 
-CommandBuffer::CommandBuffer(const Device &device) {
+CommandBuffer::CommandBuffer(const Device &device)
+    : _uploadRing(device ? &device.uploadRing() : nullptr) {
   _cmdBuf = SDL_AcquireGPUCommandBuffer(device);
 }
 
 CommandBuffer::CommandBuffer(CommandBuffer &&other) noexcept
-    : _cmdBuf(other._cmdBuf) {
+    : _cmdBuf(other._cmdBuf), _uploadRing(other._uploadRing),
+      _uploadTicket(std::move(other._uploadTicket)) {
   other._cmdBuf = nullptr;
 }
 
@@ -17,8 +19,26 @@ CommandBuffer &CommandBuffer::operator=(CommandBuffer &&other) noexcept {
     this->cancel();
   }
   _cmdBuf = other._cmdBuf;
+  _uploadRing = other._uploadRing;
+  _uploadTicket = std::move(other._uploadTicket);
   other._cmdBuf = nullptr;
   return *this;
 }
 
+bool CommandBuffer::submit() noexcept {
+  if (!active())
+    return false;
+  if (_uploadRing)
+    return _uploadRing->submit(*this);
+  return submitUnguarded();
+}
+
+bool CommandBuffer::cancel() noexcept {
+  if (!active())
+    return false;
+  if (_uploadRing)
+    return _uploadRing->cancel(*this);
+  return cancelUnguarded();
+}
+
 } // namespace candlewick
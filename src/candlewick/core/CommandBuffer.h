@@ -4,12 +4,45 @@
 #include <SDL3/SDL_gpu.h>
 #include <SDL3/SDL_log.h>
 #include <cassert>
+#include <memory>
 #include <utility>
 
 namespace candlewick {
 
 class CommandBuffer {
   SDL_GPUCommandBuffer *_cmdBuf;
+  /// Staging memory of the device, guarded on submit(). \sa UploadRing
+  UploadRing *_uploadRing;
+  /// Staging memory allocated for this command buffer, null if none.
+  std::shared_ptr<UploadTicket> _uploadTicket;
+
+  friend class UploadRing;
+  /// \brief Submit without going through the upload ring.
+  bool submitUnguarded() noexcept {
+    if (!(active() && SDL_SubmitGPUCommandBuffer(_cmdBuf)))
+      return false;
+    _cmdBuf = nullptr;
+    return true;
+  }
+
+  /// \brief Cancel without going through the upload ring.
+  bool cancelUnguarded() noexcept {
+    if (!(active() && SDL_CancelGPUCommandBuffer(_cmdBuf)))
+      return false;
+    _cmdBuf = nullptr;
+    return true;
+  }
+
+  /// \brief Submit the command buffer, and acquire a fence which is signaled
+  /// once the GPU has completed it. The fence must be released with
+  /// SDL_ReleaseGPUFence().
+  SDL_GPUFence *submitAndAcquireFence() noexcept {
+    if (!active())
+      return nullptr;
+    SDL_GPUFence *fence = SDL_SubmitGPUCommandBufferAndAcquireFence(_cmdBuf);
+    _cmdBuf = nullptr;
+    return fence;
+  }
 
 public:
   CommandBuffer(const Device &device);
@@ -31,21 +64,20 @@ public:
 
   friend void swap(CommandBuffer &lhs, CommandBuffer &rhs) noexcept {
     std::swap(lhs._cmdBuf, rhs._cmdBuf);
+    std::swap(lhs._uploadRing, rhs._uploadRing);
+    std::swap(lhs._uploadTicket, rhs._uploadTicket);
   }
 
-  bool submit() noexcept {
-    if (!(active() && SDL_SubmitGPUCommandBuffer(_cmdBuf)))
-      return false;
-    _cmdBuf = nullptr;
-    return true;
-  }
+  /// \brief Submit the command buffer.
+  ///
+  /// This goes through the device's UploadRing, which guards the staging
+  /// memory allocated for this command buffer with a fence, and recycles that
+  /// of completed submissions.
+  bool submit() noexcept;
 
-  bool cancel() noexcept {
-    if (!(active() && SDL_CancelGPUCommandBuffer(_cmdBuf)))
-      return false;
-    _cmdBuf = nullptr;
-    return true;
-  }
+  /// \brief Cancel the command buffer, recycling the staging memory allocated
+  /// for it.
+  bool cancel() noexcept;
 
   bool active() const noexcept { return _cmdBuf; }
 
@@ -54,8 +86,7 @@ public:
       SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION,
                   "CommandBuffer object is being destroyed while still active! "
                   "It will be cancelled.");
-      SDL_CancelGPUCommandBuffer(_cmdBuf);
-      _cmdBuf = nullptr;
+      cancel();
       assert(false);
     }
   }
@@ -72,9 +103,11 @@ public:
     SDL_PushGPUFragmentUniformData(_cmdBuf, slot_index, data, length);
     return *this;
   }
-
-  SDL_GPUFence *submitAndAcquireFence() {
-    return SDL_SubmitGPUCommandBufferAndAcquireFence(_cmdBuf);
+  /// \brief Push uniform data to the compute shader.
+  CommandBuffer &pushComputeUniform(Uint32 slot_index, const void *data,
+                                    Uint32 length) {
+    SDL_PushGPUComputeUniformData(_cmdBuf, slot_index, data, length);
+    return *this;
   }
 };
 
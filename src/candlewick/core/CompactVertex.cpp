@@ -0,0 +1,172 @@
+#include "CompactVertex.h"
+#include "errors.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace candlewick {
+
+PositionQuantization PositionQuantization::fromBounds(const Float3 &min,
+                                                      const Float3 &max) {
+  PositionQuantization q;
+  q.center = 0.5f * (min + max);
+  // avoid dividing by zero for flat meshes
+  q.halfExtents = (0.5f * (max - min)).cwiseMax(1e-6f);
+  return q;
+}
+
+Mat4f PositionQuantization::dequantMatrix() const {
+  Mat4f m = Mat4f::Identity();
+  m.topLeftCorner<3, 3>() = halfExtents.asDiagonal();
+  m.topRightCorner<3, 1>() = center;
+  return m;
+}
+
+Float2 octahedralEncode(const Float3 &n) {
+  const float l1 = n.lpNorm<1>();
+  if (l1 == 0.f)
+    return Float2::Zero();
+  Float3 v = n / l1;
+  if (v.z() >= 0.f)
+    return v.head<2>();
+  // fold the lower hemisphere over the diagonals
+  return {(1.f - std::abs(v.y())) * (v.x() >= 0.f ? 1.f : -1.f),
+          (1.f - std::abs(v.x())) * (v.y() >= 0.f ? 1.f : -1.f)};
+}
+
+Float3 octahedralDecode(const Float2 &e) {
+  Float3 v{e.x(), e.y(), 1.f - std::abs(e.x()) - std::abs(e.y())};
+  const float t = std::max(-v.z(), 0.f);
+  v.x() += v.x() >= 0.f ? -t : t;
+  v.y() += v.y() >= 0.f ? -t : t;
+  return v.normalized();
+}
+
+bool isNormalizedFormat(SDL_GPUVertexElementFormat format) {
+  switch (format) {
+  case SDL_GPU_VERTEXELEMENTFORMAT_BYTE2_NORM:
+  case SDL_GPU_VERTEXELEMENTFORMAT_BYTE4_NORM:
+  case SDL_GPU_VERTEXELEMENTFORMAT_UBYTE2_NORM:
+  case SDL_GPU_VERTEXELEMENTFORMAT_UBYTE4_NORM:
+  case SDL_GPU_VERTEXELEMENTFORMAT_SHORT2_NORM:
+  case SDL_GPU_VERTEXELEMENTFORMAT_SHORT4_NORM:
+  case SDL_GPU_VERTEXELEMENTFORMAT_USHORT2_NORM:
+  case SDL_GPU_VERTEXELEMENTFORMAT_USHORT4_NORM:
+    return true;
+  default:
+    return false;
+  }
+}
+
+namespace {
+  Sint16 packSnorm16(float x) {
+    return Sint16(std::lround(std::clamp(x, -1.f, 1.f) * 32767.f));
+  }
+  float unpackSnorm16(Sint16 x) { return std::max(float(x) / 32767.f, -1.f); }
+  Uint8 packUnorm8(float x) {
+    return Uint8(std::lround(std::clamp(x, 0.f, 1.f) * 255.f));
+  }
+  float unpackUnorm8(Uint8 x) { return float(x) / 255.f; }
+
+  template <typename T, typename F>
+  void writeComponents(char *dst, int n, const Float4 &value, F pack) {
+    for (int i = 0; i < n; i++) {
+      T x = pack(value[i]);
+      SDL_memcpy(dst + i * sizeof(T), &x, sizeof(T));
+    }
+  }
+
+  template <typename T, typename F>
+  Float4 readComponents(const char *src, int n, F unpack) {
+    Float4 value = Float4::Zero();
+    for (int i = 0; i < n; i++) {
+      T x;
+      SDL_memcpy(&x, src + i * sizeof(T), sizeof(T));
+      value[i] = unpack(x);
+    }
+    return value;
+  }
+
+  const auto identity = [](float x) { return x; };
+} // namespace
+
+void writeVertexElement(char *dst, SDL_GPUVertexElementFormat format,
+                        const Float4 &value) {
+  switch (format) {
+  case SDL_GPU_VERTEXELEMENTFORMAT_FLOAT:
+  case SDL_GPU_VERTEXELEMENTFORMAT_FLOAT2:
+  case SDL_GPU_VERTEXELEMENTFORMAT_FLOAT3:
+  case SDL_GPU_VERTEXELEMENTFORMAT_FLOAT4:
+    writeComponents<float>(dst, int(vertexElementSize(format) / sizeof(float)),
+                           value, identity);
+    return;
+  case SDL_GPU_VERTEXELEMENTFORMAT_SHORT2_NORM:
+    writeComponents<Sint16>(dst, 2, value, packSnorm16);
+    return;
+  case SDL_GPU_VERTEXELEMENTFORMAT_SHORT4_NORM:
+    writeComponents<Sint16>(dst, 4, value, packSnorm16);
+    return;
+  case SDL_GPU_VERTEXELEMENTFORMAT_UBYTE4_NORM:
+    writeComponents<Uint8>(dst, 4, value, packUnorm8);
+    return;
+  default:
+    terminate_with_message("Unsupported vertex element format.");
+  }
+}
+
+Float4 readVertexElement(const char *src, SDL_GPUVertexElementFormat format) {
+  switch (format) {
+  case SDL_GPU_VERTEXELEMENTFORMAT_FLOAT:
+  case SDL_GPU_VERTEXELEMENTFORMAT_FLOAT2:
+  case SDL_GPU_VERTEXELEMENTFORMAT_FLOAT3:
+  case SDL_GPU_VERTEXELEMENTFORMAT_FLOAT4:
+    return readComponents<float>(
+        src, int(vertexElementSize(format) / sizeof(float)), identity);
+  case SDL_GPU_VERTEXELEMENTFORMAT_SHORT2_NORM:
+    return readComponents<Sint16>(src, 2, unpackSnorm16);
+  case SDL_GPU_VERTEXELEMENTFORMAT_SHORT4_NORM:
+    return readComponents<Sint16>(src, 4, unpackSnorm16);
+  case SDL_GPU_VERTEXELEMENTFORMAT_UBYTE4_NORM:
+    return readComponents<Uint8>(src, 4, unpackUnorm8);
+  default:
+    terminate_with_message("Unsupported vertex element format.");
+  }
+}
+
+namespace {
+  bool isOctahedral(const SDL_GPUVertexAttribute &attr) {
+    const auto loc = VertexAttrib(attr.location);
+    return (loc == VertexAttrib::Normal || loc == VertexAttrib::Tangent) &&
+           attr.format == SDL_GPU_VERTEXELEMENTFORMAT_SHORT2_NORM;
+  }
+} // namespace
+
+void encodeVertexAttribute(char *vertex, const SDL_GPUVertexAttribute &attr,
+                           const Float4 &value,
+                           const PositionQuantization &quant) {
+  Float4 encoded = value;
+  if (VertexAttrib(attr.location) == VertexAttrib::Position &&
+      isNormalizedFormat(attr.format)) {
+    encoded << quant.quantize(value.head<3>()), 0.f;
+  } else if (isOctahedral(attr)) {
+    encoded << octahedralEncode(value.head<3>()), 0.f, 0.f;
+  }
+  writeVertexElement(vertex + attr.offset, attr.format, encoded);
+}
+
+Float4 decodeVertexAttribute(const char *vertex,
+                             const SDL_GPUVertexAttribute &attr,
+                             const Mat4f &positionDequant) {
+  Float4 value = readVertexElement(vertex + attr.offset, attr.format);
+  if (VertexAttrib(attr.location) == VertexAttrib::Position &&
+      isNormalizedFormat(attr.format)) {
+    value.w() = 1.f;
+    value = positionDequant * value;
+    value.w() = 0.f;
+  } else if (isOctahedral(attr)) {
+    value << octahedralDecode(value.head<2>()), 0.f;
+  }
+  return value;
+}
+
+} // namespace candlewick
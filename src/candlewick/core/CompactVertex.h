@@ -0,0 +1,130 @@
+#pragma once
+
+#include "math_types.h"
+#include "MeshLayout.h"
+
+namespace candlewick {
+
+/// \brief Compact vertex, with quantized attributes (16 bytes).
+///
+/// - the position is stored as snorm16 in the [-1, 1]^3 box of the mesh, see
+///   PositionQuantization;
+/// - the normal is octahedral-encoded as two snorm16 values;
+/// - the color is stored as unorm8.
+///
+/// Shaders consuming this layout must decode the normal, see the
+/// `PbrBasicCompact.vert` shader.
+struct alignas(16) CompactVertex {
+  Sint16 pos[4];
+  Sint16 normal[2];
+  Uint8 color[4];
+};
+static_assert(IsVertexType<CompactVertex>, "");
+static_assert(sizeof(CompactVertex) == 16, "");
+
+template <> struct VertexTraits<CompactVertex> {
+  static auto layout() {
+    return MeshLayout{}
+        .addBinding(0, sizeof(CompactVertex))
+        .addAttribute(VertexAttrib::Position, 0,
+                      SDL_GPU_VERTEXELEMENTFORMAT_SHORT4_NORM,
+                      offsetof(CompactVertex, pos))
+        .addAttribute(VertexAttrib::Normal, 0,
+                      SDL_GPU_VERTEXELEMENTFORMAT_SHORT2_NORM,
+                      offsetof(CompactVertex, normal))
+        .addAttribute(VertexAttrib::Color0, 0,
+                      SDL_GPU_VERTEXELEMENTFORMAT_UBYTE4_NORM,
+                      offsetof(CompactVertex, color));
+  }
+};
+
+/// \brief Compact vertex with a tangent frame instead of a color (16 bytes).
+/// The tangent is octahedral-encoded like the normal.
+/// \sa CompactVertex
+struct alignas(16) CompactTangentVertex {
+  Sint16 pos[4];
+  Sint16 normal[2];
+  Sint16 tangent[2];
+};
+static_assert(IsVertexType<CompactTangentVertex>, "");
+static_assert(sizeof(CompactTangentVertex) == 16, "");
+
+template <> struct VertexTraits<CompactTangentVertex> {
+  static auto layout() {
+    return MeshLayout{}
+        .addBinding(0, sizeof(CompactTangentVertex))
+        .addAttribute(VertexAttrib::Position, 0,
+                      SDL_GPU_VERTEXELEMENTFORMAT_SHORT4_NORM,
+                      offsetof(CompactTangentVertex, pos))
+        .addAttribute(VertexAttrib::Normal, 0,
+                      SDL_GPU_VERTEXELEMENTFORMAT_SHORT2_NORM,
+                      offsetof(CompactTangentVertex, normal))
+        .addAttribute(VertexAttrib::Tangent, 0,
+                      SDL_GPU_VERTEXELEMENTFORMAT_SHORT2_NORM,
+                      offsetof(CompactTangentVertex, tangent));
+  }
+};
+
+/// \brief Maps positions in an axis-aligned box to the [-1, 1]^3 range of
+/// normalized integer formats.
+///
+/// The inverse mapping, dequantMatrix(), is folded into the model transform
+/// when drawing, so shaders read quantized positions as-is.
+struct PositionQuantization {
+  Float3 center = Float3::Zero();
+  Float3 halfExtents = Float3::Ones();
+
+  static PositionQuantization fromBounds(const Float3 &min, const Float3 &max);
+
+  Float3 quantize(const Float3 &p) const {
+    return (p - center).cwiseQuotient(halfExtents);
+  }
+
+  /// \brief Affine transform from quantized to actual positions.
+  Mat4f dequantMatrix() const;
+};
+
+/// \brief Octahedral encoding of a unit vector to the [-1, 1]^2 square.
+Float2 octahedralEncode(const Float3 &n);
+
+/// \brief Decode an octahedral-encoded unit vector.
+Float3 octahedralDecode(const Float2 &e);
+
+/// \brief Whether the vertex attribute format is a normalized integer format,
+/// i.e. a quantized attribute.
+bool isNormalizedFormat(SDL_GPUVertexElementFormat format);
+
+/// \brief Write the components of \p value to a vertex attribute, in the given
+/// element format. Extra components of \p value are dropped.
+///
+/// Only float, snorm16 and unorm8 formats are supported.
+void writeVertexElement(char *dst, SDL_GPUVertexElementFormat format,
+                        const Float4 &value);
+
+/// \brief Read a vertex attribute to a vector; missing components are zero.
+/// \sa writeVertexElement()
+Float4 readVertexElement(const char *src, SDL_GPUVertexElementFormat format);
+
+/// \brief Encode the value of a vertex attribute to the attribute's format.
+///
+/// Positions are quantized with \p quant if the format is normalized, and
+/// normals and tangents are octahedral-encoded if it has two components.
+void encodeVertexAttribute(char *vertex, const SDL_GPUVertexAttribute &attr,
+                           const Float4 &value,
+                           const PositionQuantization &quant = {});
+
+/// \brief Decode a vertex attribute. This is the inverse of
+/// encodeVertexAttribute(), with quantized positions dequantized by
+/// \p positionDequant.
+Float4 decodeVertexAttribute(const char *vertex,
+                             const SDL_GPUVertexAttribute &attr,
+                             const Mat4f &positionDequant = Mat4f::Identity());
+
+/// \brief Whether the layout stores normals octahedral-encoded, which calls for
+/// the `*Compact` variants of the vertex shaders.
+inline bool hasOctahedralNormals(const MeshLayout &layout) {
+  auto attr = layout.getAttribute(VertexAttrib::Normal);
+  return attr && attr->format == SDL_GPU_VERTEXELEMENTFORMAT_SHORT2_NORM;
+}
+
+} // namespace candlewick
@@ -19,6 +19,14 @@ struct TransformComponent : Mat4f {
   using Mat4f::operator=;
 };
 
+/// \brief World-space bounds of an entity's mesh, for frustum culling.
+/// \sa updateWorldBounds()
+struct WorldBoundsComponent : AABBf {
+  using AABBf::AABBf;
+  using AABBf::operator=;
+  WorldBoundsComponent(const AABBf &box) : AABBf(box) {}
+};
+
 struct MeshMaterialComponent {
   Mesh mesh;
   std::vector<PbrMaterial> materials;
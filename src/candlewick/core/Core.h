@@ -8,11 +8,14 @@ class CommandBuffer;
 struct Device;
 struct Texture;
 class Mesh;
+class MeshArena;
 class MeshView;
 class MeshLayout;
 struct Shader;
 struct Renderer;
 struct Window;
+class UploadRing;
+struct UploadTicket;
 
 using coal::AABB;
 
@@ -0,0 +1,63 @@
+#include "Culling.h"
+
+#include <cmath>
+#include <limits>
+
+namespace candlewick {
+
+void AabbBatch::clear() {
+  for (auto *v : {&m_cx, &m_cy, &m_cz, &m_ex, &m_ey, &m_ez})
+    v->clear();
+  m_size = 0;
+}
+
+void AabbBatch::push(const AABBf &box) {
+  // grow a full batch at a time; the padding lanes hold unbounded boxes
+  if (m_size % kLanes == 0) {
+    for (auto *v : {&m_cx, &m_cy, &m_cz})
+      v->resize(m_size + kLanes, 0.f);
+    for (auto *v : {&m_ex, &m_ey, &m_ez})
+      v->resize(m_size + kLanes, 0.f);
+  }
+  Float3 center = Float3::Zero();
+  // large but finite: 0 * inf would give NaNs for axis-aligned planes
+  Float3 halfExtents = Float3::Constant(1e30f);
+  if (!box.isEmpty()) {
+    center = box.center();
+    halfExtents = 0.5f * box.sizes();
+  }
+  m_cx[m_size] = center.x();
+  m_cy[m_size] = center.y();
+  m_cz[m_size] = center.z();
+  m_ex[m_size] = halfExtents.x();
+  m_ey[m_size] = halfExtents.y();
+  m_ez[m_size] = halfExtents.z();
+  m_size++;
+}
+
+void AabbBatch::cull(const FrustumPlanes &frustum,
+                     std::vector<Uint8> &visible) const {
+  using Lanes = Eigen::Array<float, kLanes, 1>;
+  using LanesMap = Eigen::Map<const Lanes>;
+  const size_t padded = m_cx.size();
+  visible.resize(padded);
+
+  for (size_t i = 0; i < padded; i += kLanes) {
+    const LanesMap cx{&m_cx[i]}, cy{&m_cy[i]}, cz{&m_cz[i]};
+    const LanesMap ex{&m_ex[i]}, ey{&m_ey[i]}, ez{&m_ez[i]};
+    // signed distance of each box to the outside of the frustum: the box is
+    // culled if it is fully behind any plane
+    Lanes margin = Lanes::Constant(std::numeric_limits<float>::max());
+    for (const Float4 &p : frustum.planes) {
+      const Lanes dist = p.x() * cx + p.y() * cy + p.z() * cz + p.w();
+      const Lanes radius = std::abs(p.x()) * ex + std::abs(p.y()) * ey +
+                           std::abs(p.z()) * ez;
+      margin = margin.min(dist + radius);
+    }
+    for (size_t k = 0; k < kLanes; k++)
+      visible[i + k] = margin[k] >= 0.f;
+  }
+  visible.resize(m_size);
+}
+
+} // namespace candlewick
@@ -0,0 +1,123 @@
+#pragma once
+
+#include "math_types.h"
+#include <Eigen/Geometry>
+#include <array>
+#include <vector>
+
+namespace candlewick {
+
+/// \brief Axis-aligned bounding box, in single precision. A default-constructed
+/// box is empty, which the culling routines treat as unbounded.
+using AABBf = Eigen::AlignedBox3f;
+
+/// \brief Bounds of an axis-aligned box \p box after an affine transform
+/// \p tr (Arvo's method). Empty boxes stay empty.
+inline AABBf transformBox(const AABBf &box, const Mat4f &tr) {
+  if (box.isEmpty())
+    return box;
+  const auto R = tr.topLeftCorner<3, 3>();
+  const Float3 center = R * box.center() + tr.topRightCorner<3, 1>();
+  const Float3 halfExtents = R.cwiseAbs() * (0.5f * box.sizes());
+  return {center - halfExtents, center + halfExtents};
+}
+
+/// \brief Planes of a view frustum, as vectors \f$ (n, d) \f$ such that
+/// \f$ n \cdot x + d \geq 0 \f$ for points \f$ x \f$ inside the frustum, with
+/// unit normals \f$ n \f$.
+struct FrustumPlanes {
+  std::array<Float4, 6> planes;
+
+  /// \brief Extract the planes of a clip matrix (Gribb-Hartmann), with the
+  /// [0, 1] depth range of SDL GPU.
+  ///
+  /// The planes are expressed in the frame the matrix maps from, e.g. the
+  /// model frame for a model-view-projection matrix.
+  static FrustumPlanes fromClipMatrix(const Mat4f &clip) {
+    FrustumPlanes out;
+    out.planes = {
+        clip.row(3) + clip.row(0), clip.row(3) - clip.row(0),
+        clip.row(3) + clip.row(1), clip.row(3) - clip.row(1),
+        clip.row(2),               clip.row(3) - clip.row(2),
+    };
+    for (Float4 &p : out.planes)
+      p /= p.head<3>().norm();
+    return out;
+  }
+
+  /// \brief Planes of the hexahedron with the given corners, ordered as in
+  /// frustumFromCameraProjection() (bit 0 of the index for x, 1 for y and 2
+  /// for z), in the same order as fromClipMatrix().
+  static FrustumPlanes fromCorners(const FrustumCornersType &corners) {
+    constexpr int faces[6][3] = {{0, 2, 4}, {1, 3, 5}, {0, 1, 4},
+                                 {2, 3, 6}, {0, 1, 2}, {4, 5, 6}};
+    Float3 centroid = Float3::Zero();
+    for (const Float3 &c : corners)
+      centroid += c / 8.f;
+    FrustumPlanes out;
+    for (size_t i = 0; i < 6; i++) {
+      const Float3 &a = corners[faces[i][0]];
+      const Float3 n = (corners[faces[i][1]] - a)
+                           .cross(corners[faces[i][2]] - a)
+                           .normalized();
+      out.planes[i] << n, -n.dot(a);
+      // point the normal inside
+      if (n.dot(centroid) + out.planes[i][3] < 0.f)
+        out.planes[i] = -out.planes[i];
+    }
+    return out;
+  }
+
+  /// \brief Whether a sphere is at least partly inside the frustum. This is
+  /// conservative: spheres close to the frustum's edges may be reported
+  /// inside.
+  bool intersectsSphere(const Float3 &center, float radius) const {
+    for (const Float4 &p : planes) {
+      if (p.head<3>().dot(center) + p[3] < -radius)
+        return false;
+    }
+    return true;
+  }
+
+  /// \brief Whether a box is at least partly inside the frustum. Conservative
+  /// like intersectsSphere(); empty boxes are always inside.
+  bool intersectsBox(const AABBf &box) const {
+    if (box.isEmpty())
+      return true;
+    const Float3 center = box.center();
+    const Float3 halfExtents = 0.5f * box.sizes();
+    for (const Float4 &p : planes) {
+      const float radius = p.head<3>().cwiseAbs().dot(halfExtents);
+      if (p.head<3>().dot(center) + p[3] < -radius)
+        return false;
+    }
+    return true;
+  }
+};
+
+/// \brief Batch of axis-aligned bounding boxes, in a structure-of-arrays
+/// layout, which are tested against a frustum \ref kLanes boxes at a time.
+///
+/// Boxes are stored as their centers and half-extents. The storage is padded
+/// to a multiple of \ref kLanes, so that the test runs on full SIMD registers
+/// (through Eigen's vectorized arrays) without a scalar remainder loop.
+class AabbBatch {
+public:
+  static constexpr size_t kLanes = 8;
+
+  void clear();
+  /// \brief Append a box. Empty boxes are never culled.
+  void push(const AABBf &box);
+  size_t size() const { return m_size; }
+
+  /// \brief Test all boxes against a frustum.
+  /// \param[out] visible Resized to size(), receives 1 for the boxes which
+  /// intersect the frustum, 0 for the others.
+  void cull(const FrustumPlanes &frustum, std::vector<Uint8> &visible) const;
+
+private:
+  std::vector<float> m_cx, m_cy, m_cz, m_ex, m_ey, m_ez;
+  size_t m_size = 0;
+};
+
+} // namespace candlewick
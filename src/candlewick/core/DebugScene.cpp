@@ -6,6 +6,8 @@
 #include "../primitives/Arrow.h"
 #include "../primitives/Grid.h"
 
+#include <iterator>
+
 namespace candlewick {
 
 DebugScene::DebugScene(entt::registry &reg, const Renderer &renderer)
@@ -18,15 +20,22 @@ DebugScene::DebugScene(entt::registry &reg, const Renderer &renderer)
 std::tuple<entt::entity, DebugMeshComponent &> DebugScene::addTriad() {
   auto triad_datas = loadTriadSolid();
   std::vector<GpuVec4> triad_colors(3);
-  Mesh triad = createMeshFromBatch(device(), triad_datas, true);
   for (size_t i = 0; i < 3; i++) {
     triad_colors[i] = triad_datas[i].material.baseColor;
   }
+  // moved into the optimizing overload
+  Mesh triad = createMeshFromBatch(
+      device(),
+      std::vector(std::make_move_iterator(triad_datas.begin()),
+                  std::make_move_iterator(triad_datas.end())),
+      true);
   setupPipelines(triad.layout());
   auto entity = _registry.create();
   auto &item = _registry.emplace<DebugMeshComponent>(
       entity, DebugPipelines::TRIANGLE_FILL, std::move(triad), triad_colors);
   _registry.emplace<TransformComponent>(entity, Mat4f::Identity());
+  _registry.emplace<WorldBoundsComponent>(
+      entity, worldBounds(item.mesh, Mat4f::Identity()));
   return {entity, item};
 }
 
@@ -41,6 +50,8 @@ DebugScene::addLineGrid(std::optional<Float4> color) {
   auto &item = _registry.emplace<DebugMeshComponent>(
       entity, DebugPipelines::LINE, std::move(grid), std::vector{grid_color});
   _registry.emplace<TransformComponent>(entity, Mat4f::Identity());
+  _registry.emplace<WorldBoundsComponent>(
+      entity, worldBounds(item.mesh, Mat4f::Identity()));
   return {entity, item};
 }
 
@@ -52,28 +63,48 @@ void DebugScene::renderMeshComponents(CommandBuffer &cmdBuf,
   auto view =
       _registry.view<const DebugMeshComponent, const TransformComponent>(
           entt::exclude<Disable>);
-  view.each([&](auto &cmd, auto &tr) {
+  const auto frustum = FrustumPlanes::fromClipMatrix(viewProj);
+  _renderQueue.clear();
+  const auto visible = _culler.cull(_registry, view, frustum);
+  for (Uint32 k = 0; k < visible.size(); k++) {
+    const auto &[cmd, tr] = view.get(visible[k]);
     if (!cmd.enable)
-      return;
+      continue;
 
+    SDL_GPUGraphicsPipeline *pipeline = nullptr;
     switch (cmd.pipeline_type) {
     case DebugPipelines::TRIANGLE_FILL:
-      SDL_BindGPUGraphicsPipeline(render_pass, _trianglePipeline);
+      pipeline = _trianglePipeline;
       break;
     case DebugPipelines::LINE:
-      SDL_BindGPUGraphicsPipeline(render_pass, _linePipeline);
+      pipeline = _linePipeline;
       break;
     }
+    const float depth = -(camera.view * Float3{tr.topRightCorner<3, 1>()}).z();
+    for (Uint32 i = 0; i < cmd.mesh.numViews(); i++) {
+      const PbrMaterial color{.baseColor = cmd.colors[i]};
+      _renderQueue.push(pipeline, cmd.mesh, 0, i, color, k, depth);
+    }
+  }
 
-    const GpuMat4 mvp = viewProj * tr;
-    cmdBuf.pushVertexUniform(TRANSFORM_SLOT, &mvp, sizeof(mvp));
-    rend::bindMesh(render_pass, cmd.mesh);
-    for (size_t i = 0; i < cmd.mesh.numViews(); i++) {
-      const auto &color = cmd.colors[i];
+  _renderQueue.sort();
+  _renderStats = {};
+  DrawStateTracker state{render_pass, _renderStats};
+  for (const DrawPacket &packet : _renderQueue.packets()) {
+    state.bindPipeline(packet.pipeline);
+    if (state.changeObject(packet.object)) {
+      const GpuMat4 mvp =
+          viewProj * view.get<const TransformComponent>(visible[packet.object]);
+      cmdBuf.pushVertexUniform(TRANSFORM_SLOT, &mvp, sizeof(mvp));
+    }
+    state.bindMesh(*packet.mesh);
+    if (state.changeMaterial(packet.materialId)) {
+      const auto &color = _renderQueue.material(packet.materialId).baseColor;
       cmdBuf.pushFragmentUniform(COLOR_SLOT, &color, sizeof(color));
-      rend::drawView(render_pass, cmd.mesh.view(i));
     }
-  });
+    state.countDraw();
+    rend::drawView(render_pass, packet.mesh->view(packet.viewIndex));
+  }
 }
 
 void DebugScene::setupPipelines(const MeshLayout &layout) {
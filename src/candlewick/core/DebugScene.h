@@ -3,6 +3,8 @@
 #include "Scene.h"
 #include "Mesh.h"
 #include "Renderer.h"
+#include "FrustumCuller.h"
+#include "RenderQueue.h"
 #include "math_types.h"
 
 #include <optional>
@@ -46,6 +48,9 @@ class DebugScene {
   SDL_GPUGraphicsPipeline *_linePipeline;
   SDL_GPUTextureFormat _swapchainTextureFormat, _depthFormat;
   std::vector<std::unique_ptr<IDebugSubSystem>> _systems;
+  mutable FrustumCuller _culler;
+  mutable RenderQueue _renderQueue;
+  mutable RenderQueueStats _renderStats;
 
   void renderMeshComponents(CommandBuffer &cmdBuf,
                             SDL_GPURenderPass *render_pass,
@@ -84,10 +89,15 @@ public:
     for (auto &system : _systems) {
       system->update(*this);
     }
+    updateWorldBounds<DebugMeshComponent>(_registry);
   }
 
   void render(CommandBuffer &cmdBuf, const Camera &camera) const;
 
+  /// \brief State changes of the draws of the last render(), and those the
+  /// sorted render queue saved.
+  const RenderQueueStats &renderStats() const { return _renderStats; }
+
   void release();
 
   ~DebugScene() { release(); }
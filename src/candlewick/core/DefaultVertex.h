@@ -32,4 +32,25 @@ template <> struct VertexTraits<DefaultVertex> {
   }
 };
 
+/// \brief Vertex with only a position and a normal, which is all the PBR and
+/// depth-only shaders read (32 bytes, half the size of DefaultVertex).
+struct alignas(16) PosNormalVertex {
+  GpuVec3 pos;
+  alignas(16) GpuVec3 normal;
+};
+static_assert(IsVertexType<PosNormalVertex>, "");
+
+template <> struct VertexTraits<PosNormalVertex> {
+  static auto layout() {
+    return MeshLayout{}
+        .addBinding(0, sizeof(PosNormalVertex))
+        .addAttribute(VertexAttrib::Position, 0,
+                      SDL_GPU_VERTEXELEMENTFORMAT_FLOAT3,
+                      offsetof(PosNormalVertex, pos))
+        .addAttribute(VertexAttrib::Normal, 0,
+                      SDL_GPU_VERTEXELEMENTFORMAT_FLOAT3,
+                      offsetof(PosNormalVertex, normal));
+  }
+};
+
 } // namespace candlewick
@@ -4,20 +4,23 @@
 #include "Collision.h"
 #include "Camera.h"
 
+#include <algorithm>
+#include <cmath>
 #include <stdexcept>
 #include <format>
+#include <limits>
+#include <tuple>
+#include <vector>
 #include <SDL3/SDL_log.h>
 
 namespace candlewick {
 
-DepthPassInfo DepthPassInfo::create(const Renderer &renderer,
-                                    const MeshLayout &layout,
-                                    SDL_GPUTexture *depth_texture,
-                                    Config config) {
-  if (depth_texture == nullptr)
-    depth_texture = renderer.depth_texture;
+static SDL_GPUGraphicsPipeline *
+createDepthPipeline(const Renderer &renderer, const MeshLayout &layout,
+                    const DepthPassInfo::Config &config,
+                    const char *vertex_shader_name) {
   const Device &device = renderer.device;
-  auto vertexShader = Shader::fromMetadata(device, "ShadowCast.vert");
+  auto vertexShader = Shader::fromMetadata(device, vertex_shader_name);
   auto fragmentShader = Shader::fromMetadata(device, "ShadowCast.frag");
   SDL_GPUGraphicsPipelineCreateInfo pipeline_desc{
       .vertex_shader = vertexShader,
@@ -39,11 +42,35 @@ DepthPassInfo DepthPassInfo::create(const Renderer &renderer,
                    .depth_stencil_format = renderer.depthFormat(),
                    .has_depth_stencil_target = true},
   };
-  auto *pipeline = SDL_CreateGPUGraphicsPipeline(device, &pipeline_desc);
+  return SDL_CreateGPUGraphicsPipeline(device, &pipeline_desc);
+}
+
+DepthPassInfo DepthPassInfo::create(const Renderer &renderer,
+                                    const MeshLayout &layout,
+                                    SDL_GPUTexture *depth_texture,
+                                    Config config) {
+  if (depth_texture == nullptr)
+    depth_texture = renderer.depth_texture;
+  const Device &device = renderer.device;
   DepthPassInfo out;
   out.depthTexture = depth_texture;
-  out.pipeline = pipeline;
+  out.pipeline =
+      createDepthPipeline(renderer, layout, config, "ShadowCast.vert");
+  out.positionOnly = isPositionOnlyLayout(layout);
+  out.depthClip = config.enable_depth_clip;
   out._device = device;
+  if (config.enable_instancing) {
+    out.instancedPipeline = createDepthPipeline(renderer, layout, config,
+                                                "ShadowCastInstanced.vert");
+    out.instanceBuffer = std::make_shared<InstanceBuffer>(device);
+  }
+  if (config.enable_gpu_culling) {
+    out.indirectPipeline =
+        createDepthPipeline(renderer, drawRecordLayout(layout), config,
+                            "ShadowCastIndirect.vert");
+    out.drawRecordSlot = layout.numBuffers();
+    out.cullOutput = std::make_shared<GpuCullOutput>(device);
+  }
   return out;
 }
 
@@ -53,22 +80,37 @@ void DepthPassInfo::release() {
     SDL_ReleaseGPUGraphicsPipeline(_device, pipeline);
     pipeline = nullptr;
   }
+  if (_device && instancedPipeline) {
+    SDL_ReleaseGPUGraphicsPipeline(_device, instancedPipeline);
+    instancedPipeline = nullptr;
+  }
+  if (_device && indirectPipeline) {
+    SDL_ReleaseGPUGraphicsPipeline(_device, indirectPipeline);
+    indirectPipeline = nullptr;
+  }
+  instanceBuffer.reset();
+  cullOutput.reset();
+  hiz.reset();
 }
 
 ShadowPassInfo ShadowPassInfo::create(const Renderer &renderer,
                                       const MeshLayout &layout,
                                       const ShadowPassConfig &config) {
   const Device &device = renderer.device;
+  const Uint32 numCascades =
+      std::clamp(config.num_cascades, 1u, kMaxShadowCascades);
 
   // TEXTURE
-  // 2k x 2k texture
+  // 2k x 2k texture, per cascade, the cascades in a 2x1 or 2x2 grid
+  const Uint32 width = numCascades > 1 ? 2 * config.width : config.width;
+  const Uint32 height = numCascades > 2 ? 2 * config.height : config.height;
   SDL_GPUTextureCreateInfo texInfo{
       .type = SDL_GPU_TEXTURETYPE_2D,
       .format = renderer.depthFormat(),
       .usage = SDL_GPU_TEXTUREUSAGE_DEPTH_STENCIL_TARGET |
                SDL_GPU_TEXTUREUSAGE_SAMPLER,
-      .width = config.width,
-      .height = config.height,
+      .width = width,
+      .height = height,
       .layer_count_or_depth = 1,
       .num_levels = 1,
       .sample_count = SDL_GPU_SAMPLECOUNT_1,
@@ -79,7 +121,7 @@ ShadowPassInfo ShadowPassInfo::create(const Renderer &renderer,
   SDL_SetGPUTextureName(device, shadowMap, "Shadow map");
   if (!shadowMap) {
     auto msg =
-        std::format("Failed to create shadow map texture: %s", SDL_GetError());
+        std::format("Failed to create shadow map texture: {}", SDL_GetError());
     throw std::runtime_error(msg);
   }
 
@@ -91,13 +133,19 @@ ShadowPassInfo ShadowPassInfo::create(const Renderer &renderer,
                                 .depth_bias_slope_factor = 0.f,
                                 .enable_depth_bias = false,
                                 .enable_depth_clip = false,
+                                .enable_instancing = config.enable_instancing,
+                                .enable_gpu_culling = config.enable_gpu_culling,
                             });
   if (!passInfo.pipeline) {
     SDL_ReleaseGPUTexture(device, shadowMap);
     auto msg =
-        std::format("Failed to create shadow map pipeline: %s", SDL_GetError());
+        std::format("Failed to create shadow map pipeline: {}", SDL_GetError());
     throw std::runtime_error(msg);
   }
+  passInfo.lodPixelError = config.lod_pixel_error;
+  passInfo.lodViewportHeight = float(config.height);
+  if (config.enable_gpu_culling && config.enable_occlusion_culling)
+    passInfo.hiz = std::make_shared<HiZPyramid>(device, width, height);
 
   SDL_GPUSamplerCreateInfo sample_desc{
       .min_filter = SDL_GPU_FILTER_LINEAR,
@@ -109,7 +157,26 @@ ShadowPassInfo ShadowPassInfo::create(const Renderer &renderer,
       .compare_op = SDL_GPU_COMPAREOP_LESS,
       .enable_compare = true,
   };
-  return ShadowPassInfo{passInfo, SDL_CreateGPUSampler(device, &sample_desc)};
+  ShadowPassInfo out{passInfo, SDL_CreateGPUSampler(device, &sample_desc)};
+  out.width = width;
+  out.height = height;
+  out.maxCascades = numCascades;
+  out.cascadeWidth = config.width;
+  out.cascadeHeight = config.height;
+  out.splitLambda = config.cascade_split_lambda;
+  out.maxShadowDistance = config.max_shadow_distance;
+  // the cascades follow the camera: their depths are not cached
+  if (config.enable_caching && numCascades == 1) {
+    out.cache.staticLayer = SDL_CreateGPUTexture(device, &texInfo);
+    if (!out.cache.staticLayer) {
+      out.release();
+      auto msg = std::format("Failed to create static shadow layer: {}",
+                             SDL_GetError());
+      throw std::runtime_error(msg);
+    }
+    SDL_SetGPUTextureName(device, out.cache.staticLayer, "Static shadow layer");
+  }
+  return out;
 }
 
 void ShadowPassInfo::release() {
@@ -122,14 +189,79 @@ void ShadowPassInfo::release() {
     SDL_ReleaseGPUSampler(_device, sampler);
     sampler = nullptr;
   }
+  if (cache.staticLayer) {
+    SDL_ReleaseGPUTexture(_device, cache.staticLayer);
+    cache.staticLayer = nullptr;
+  }
+  cache.invalidate();
+}
+
+/// Bounds of the region a box shadows: the box, swept along the light rays.
+static AABBf shadowBounds(const AABBf &box, const Float3 &lightDirection,
+                          float castDistance) {
+  AABBf out = box;
+  out.extend(box.translated(castDistance * lightDirection));
+  return out;
 }
 
-void renderDepthOnlyPass(CommandBuffer &cmdBuf, const DepthPassInfo &passInfo,
-                         const Mat4f &viewProj,
-                         std::span<const OpaqueCastable> castables) {
+namespace {
+  /// A castable which passed culling, with its level of detail.
+  struct DepthDraw {
+    Uint32 castable;
+    Uint32 lod;
+    /// Clip-space depth of the castable, for front-to-back ordering.
+    float depth;
+  };
+
+  /// Clip-space depth (before the perspective division) of the center of a
+  /// castable, increasing away from the camera.
+  float clipDepth(const OpaqueCastable &cs, const Mat4f &viewProj) {
+    const AABBf bounds = worldBounds(cs.mesh, cs.transform);
+    const Float3 center = bounds.isEmpty()
+                              ? Float3{cs.transform.topRightCorner<3, 1>()}
+                              : Float3{bounds.center()};
+    return viewProj.row(2).head<3>().dot(center) + viewProj(2, 3);
+  }
+
+  /// Order runs of draws, as grouped by \p same, by their nearest draw.
+  template <typename Same>
+  void sortGroupsByDepth(std::span<DepthDraw> draws, Same same) {
+    struct Group {
+      size_t begin, end;
+      float depth;
+    };
+    std::vector<Group> groups;
+    for (size_t begin = 0, end; begin < draws.size(); begin = end) {
+      float depth = draws[begin].depth;
+      end = begin + 1;
+      while (end < draws.size() && same(draws[begin], draws[end]))
+        depth = std::min(depth, draws[end++].depth);
+      groups.push_back({begin, end, depth});
+    }
+    std::ranges::stable_sort(groups, {}, &Group::depth);
+    std::vector<DepthDraw> sorted;
+    sorted.reserve(draws.size());
+    for (const Group &g : groups)
+      sorted.insert(sorted.end(), draws.begin() + g.begin,
+                    draws.begin() + g.end);
+    std::ranges::copy(sorted, draws.begin());
+  }
+
+  /// Identity of a mesh view, as drawn by a depth-only pass.
+  auto viewKey(const MeshView &view) {
+    return std::tuple{view.vertexBuffers[0], view.positionBuffer,
+                      view.indexBuffer,      view.vertexOffset,
+                      view.vertexCount,      view.indexOffset,
+                      view.indexCount};
+  }
+} // namespace
+
+static SDL_GPURenderPass *beginDepthPass(CommandBuffer &cmdBuf,
+                                         const DepthPassInfo &passInfo) {
   SDL_GPUDepthStencilTargetInfo depth_info;
   SDL_zero(depth_info);
-  depth_info.load_op = SDL_GPU_LOADOP_CLEAR;
+  depth_info.load_op =
+      passInfo.clearDepth ? SDL_GPU_LOADOP_CLEAR : SDL_GPU_LOADOP_LOAD;
   depth_info.store_op = SDL_GPU_STOREOP_STORE;
   depth_info.stencil_load_op = SDL_GPU_LOADOP_DONT_CARE;
   depth_info.stencil_store_op = SDL_GPU_STOREOP_DONT_CARE;
@@ -137,24 +269,387 @@ void renderDepthOnlyPass(CommandBuffer &cmdBuf, const DepthPassInfo &passInfo,
   // depth texture may be the renderer shared depth texture,
   // or a specially created texture.
   depth_info.texture = passInfo.depthTexture;
-
   SDL_GPURenderPass *render_pass =
       SDL_BeginGPURenderPass(cmdBuf, nullptr, 0, &depth_info);
+  const SDL_Rect &rect = passInfo.viewport;
+  if (rect.w > 0 && rect.h > 0) {
+    const SDL_GPUViewport viewport{float(rect.x), float(rect.y),
+                                   float(rect.w), float(rect.h),
+                                   0.f,           1.f};
+    SDL_SetGPUViewport(render_pass, &viewport);
+    // keep the primitives clamped onto the near plane within the region
+    SDL_SetGPUScissor(render_pass, &rect);
+  }
+  return render_pass;
+}
 
-  assert(passInfo.pipeline);
-  SDL_BindGPUGraphicsPipeline(render_pass, passInfo.pipeline);
+/// Cull the pass's draw list on the GPU, then draw it with indirect draws.
+static DepthPassStats renderIndirect(CommandBuffer &cmdBuf,
+                                     const DepthPassInfo &passInfo,
+                                     const Mat4f &viewProj,
+                                     FrustumPlanes volume,
+                                     const ShadowReceiverVolume *receivers) {
+  DepthPassStats stats;
+  const GpuDrawList &drawList = *passInfo.drawList;
+  stats.numGpuCulled = drawList.size();
+  if (!passInfo.cullCastables) {
+    volume.planes.fill({0.f, 0.f, 0.f, std::numeric_limits<float>::max()});
+    receivers = nullptr;
+  }
+  drawList.cull(cmdBuf, *passInfo.objectBuffer, volume, *passInfo.cullOutput,
+                passInfo.hiz.get(), receivers);
+  const GpuCullStats &cullStats = passInfo.cullOutput->stats();
+  if (passInfo.hiz)
+    stats.numGpuOccluded = cullStats.numOccluded;
+  if (receivers)
+    stats.numGpuReceiverCulled = cullStats.numReceiverCulled;
+
+  SDL_GPURenderPass *render_pass = beginDepthPass(cmdBuf, passInfo);
+  SDL_BindGPUGraphicsPipeline(render_pass, passInfo.indirectPipeline);
+  passInfo.objectBuffer->bindVertex(render_pass, 0);
+  const GpuMat4 vp = viewProj;
+  cmdBuf.pushVertexUniform(DepthPassInfo::TRANSFORM_SLOT, &vp, sizeof(vp));
+  drawList.draw(render_pass, *passInfo.cullOutput, passInfo.drawRecordSlot,
+                passInfo.positionOnly);
+  SDL_EndGPURenderPass(render_pass);
+  if (passInfo.hiz)
+    passInfo.hiz->build(cmdBuf, passInfo.depthTexture, viewProj);
+  return stats;
+}
+
+DepthPassStats
+renderDepthOnlyPass(CommandBuffer &cmdBuf, const DepthPassInfo &passInfo,
+                    const Mat4f &viewProj,
+                    std::span<const OpaqueCastable> castables,
+                    const ShadowReceiverVolume *receivers) {
+  DepthPassStats stats;
+  stats.numCastables = Uint32(castables.size());
+  FrustumPlanes volume = FrustumPlanes::fromClipMatrix(viewProj);
+  if (!passInfo.depthClip) {
+    // casters in front of the near plane are clamped onto it
+    volume.planes[4] = {0.f, 0.f, 0.f, std::numeric_limits<float>::max()};
+  }
+  if (passInfo.drawList && passInfo.indirectPipeline && passInfo.objectBuffer &&
+      !passInfo.drawList->empty()) {
+    stats = renderIndirect(cmdBuf, passInfo, viewProj, volume, receivers);
+    stats.numCastables = Uint32(castables.size());
+    return stats;
+  }
+
+  std::vector<DepthDraw> draws;
+  draws.reserve(castables.size());
+  for (Uint32 i = 0; i < castables.size(); i++) {
+    const OpaqueCastable &cs = castables[i];
+    assert(validateMesh(cs.mesh));
+    if (passInfo.cullCastables) {
+      const AABBf bounds = worldBounds(cs.mesh, cs.transform);
+      if (!volume.intersectsBox(bounds)) {
+        stats.numCulledVolume++;
+        continue;
+      }
+      if (receivers && !bounds.isEmpty() &&
+          !receivers->frustum.intersectsBox(shadowBounds(
+              bounds, receivers->lightDirection, receivers->castDistance))) {
+        stats.numCulledReceivers++;
+        continue;
+      }
+    }
+    const Uint32 lod =
+        selectLod(cs.mesh, viewProj, cs.transform, passInfo.lodViewportHeight,
+                  passInfo.lodPixelError);
+    const float depth =
+        passInfo.sortFrontToBack ? clipDepth(cs, viewProj) : 0.f;
+    draws.push_back({i, lod, depth});
+  }
+  stats.numDrawn = Uint32(draws.size());
 
+  // the castables in the object buffer come first, grouped by views; each
+  // draw is then the instance of the same index
+  const bool fromObjects = passInfo.instancedPipeline &&
+                           passInfo.instanceBuffer && passInfo.objectBuffer &&
+                           !passInfo.objectBuffer->empty();
+  auto views = [&](const DepthDraw &d) {
+    return castables[d.castable].mesh.lodViews(d.lod);
+  };
+  auto sameViews = [&](const DepthDraw &a, const DepthDraw &b) {
+    return std::ranges::equal(views(a), views(b), {}, viewKey, viewKey);
+  };
+  std::vector<Uint32> instanceObjects;
+  if (fromObjects) {
+    auto rest = std::ranges::stable_partition(draws, [&](const DepthDraw &d) {
+      return castables[d.castable].object != ObjectBuffer::kNoObject;
+    });
+    std::stable_sort(draws.begin(), rest.begin(),
+                     [&](const DepthDraw &a, const DepthDraw &b) {
+                       return std::ranges::lexicographical_compare(
+                           views(a), views(b), {}, viewKey, viewKey);
+                     });
+    if (passInfo.sortFrontToBack) {
+      sortGroupsByDepth(std::span{draws.begin(), rest.begin()}, sameViews);
+      std::ranges::stable_sort(rest, {}, &DepthDraw::depth);
+    }
+    for (auto it = draws.begin(); it != rest.begin(); ++it)
+      instanceObjects.push_back(castables[it->castable].object);
+    passInfo.instanceBuffer->upload(cmdBuf, std::span{instanceObjects});
+  } else if (passInfo.sortFrontToBack) {
+    std::ranges::stable_sort(draws, {}, &DepthDraw::depth);
+  }
+  const size_t numInstanced = instanceObjects.size();
+
+  SDL_GPURenderPass *render_pass = beginDepthPass(cmdBuf, passInfo);
+
+  rend::MeshBinder binder{render_pass};
+  auto bind = [&](const Mesh &mesh) {
+    if (passInfo.positionOnly)
+      binder.bindPositions(mesh);
+    else
+      binder.bind(mesh);
+  };
+
+  if (numInstanced > 0) {
+    SDL_BindGPUGraphicsPipeline(render_pass, passInfo.instancedPipeline);
+    passInfo.objectBuffer->bindVertex(render_pass, 0);
+    passInfo.instanceBuffer->bindVertex(render_pass, 1);
+    const GpuMat4 vp = viewProj;
+    cmdBuf.pushVertexUniform(DepthPassInfo::TRANSFORM_SLOT, &vp, sizeof(vp));
+  }
+  for (size_t begin = 0, end; begin < numInstanced; begin = end) {
+    end = begin + 1;
+    while (end < numInstanced && sameViews(draws[begin], draws[end]))
+      end++;
+    const Uint32 count = Uint32(end - begin);
+    const Uint32 firstInstance = Uint32(begin);
+    bind(castables[draws[begin].castable].mesh);
+    cmdBuf.pushVertexUniform(DepthPassInfo::DRAW_SLOT, &firstInstance,
+                             sizeof(firstInstance));
+    rend::drawViews(render_pass, views(draws[begin]), count);
+    if (count > 1)
+      stats.numInstanced += count;
+  }
+
+  // then the others, with their transforms as uniforms
+  if (numInstanced < draws.size()) {
+    assert(passInfo.pipeline);
+    SDL_BindGPUGraphicsPipeline(render_pass, passInfo.pipeline);
+  }
   Mat4f mvp;
-  for (auto &cs : castables) {
-    auto &[ent, mesh, tr] = cs;
-    assert(validateMesh(mesh));
-    rend::bindMesh(render_pass, mesh);
-    mvp.noalias() = viewProj * tr;
+  for (size_t k = numInstanced; k < draws.size(); k++) {
+    const OpaqueCastable &cs = castables[draws[k].castable];
+    bind(cs.mesh);
+    mvp.noalias() = viewProj * cs.transform * cs.mesh.positionDequant;
     cmdBuf.pushVertexUniform(DepthPassInfo::TRANSFORM_SLOT, &mvp, sizeof(mvp));
-    rend::draw(render_pass, mesh);
+    rend::drawViews(render_pass, views(draws[k]));
   }
 
   SDL_EndGPURenderPass(render_pass);
+  return stats;
+}
+
+/// Record the meshes and transforms of the castables of \p castables which
+/// are static, or not, in \p cached.
+/// \returns Whether they changed.
+static bool
+updateCachedCasters(std::vector<ShadowPassInfo::CachedCaster> &cached,
+                    std::span<const OpaqueCastable> castables, bool isStatic) {
+  bool changed = false;
+  size_t n = 0;
+  for (const OpaqueCastable &cs : castables) {
+    if (cs.isStatic != isStatic)
+      continue;
+    if (n == cached.size()) {
+      cached.push_back({&cs.mesh, cs.transform});
+      changed = true;
+    } else if (ShadowPassInfo::CachedCaster &c = cached[n];
+               c.mesh != &cs.mesh || c.transform != cs.transform) {
+      c = {&cs.mesh, cs.transform};
+      changed = true;
+    }
+    n++;
+  }
+  if (n < cached.size()) {
+    cached.resize(n);
+    changed = true;
+  }
+  return changed;
+}
+
+void ShadowPassInfo::Cache::update(const Mat4f &lightViewProj,
+                                   std::span<const OpaqueCastable> castables) {
+  if (lightViewProj != viewProj) {
+    viewProj = lightViewProj;
+    invalidate();
+  }
+  if (updateCachedCasters(staticCasters, castables, true))
+    staticValid = false;
+  if (updateCachedCasters(dynamicCasters, castables, false))
+    valid = false;
+}
+
+/// Render a shadow map from its cached layers, drawing only the layers whose
+/// casters changed.
+static DepthPassStats
+renderCachedShadowPass(CommandBuffer &cmdBuf, ShadowPassInfo &passInfo,
+                       const Mat4f &viewProj,
+                       std::span<const OpaqueCastable> castables) {
+  ShadowPassInfo::Cache &cache = passInfo.cache;
+  cache.update(viewProj, castables);
+
+  DepthPassStats stats;
+  auto add = [&stats](const DepthPassStats &layer) {
+    stats.numDrawn += layer.numDrawn;
+    stats.numCulledVolume += layer.numCulledVolume;
+    stats.numInstanced += layer.numInstanced;
+  };
+  stats.numCastables = Uint32(castables.size());
+  if (cache.staticValid && cache.valid) {
+    stats.numCached = stats.numCastables;
+    return stats;
+  }
+
+  std::vector<OpaqueCastable> staticCasters, dynamicCasters;
+  for (const OpaqueCastable &cs : castables)
+    (cs.isStatic ? staticCasters : dynamicCasters).push_back(cs);
+
+  // the layers are drawn from their castables, which the draw list mixes
+  DepthPassInfo layer = passInfo;
+  layer.drawList = nullptr;
+  layer.hiz = nullptr;
+  if (!cache.staticValid) {
+    layer.depthTexture = cache.staticLayer;
+    add(renderDepthOnlyPass(cmdBuf, layer, viewProj, staticCasters));
+    cache.staticValid = true;
+  } else {
+    stats.numCached = Uint32(staticCasters.size());
+  }
+
+  SDL_GPUCopyPass *copy_pass = SDL_BeginGPUCopyPass(cmdBuf);
+  const SDL_GPUTextureLocation from{.texture = cache.staticLayer};
+  const SDL_GPUTextureLocation to{.texture = passInfo.depthTexture};
+  // the whole shadow map is overwritten
+  SDL_CopyGPUTextureToTexture(copy_pass, &from, &to, passInfo.width,
+                              passInfo.height, 1, true);
+  SDL_EndGPUCopyPass(copy_pass);
+
+  layer.depthTexture = passInfo.depthTexture;
+  layer.clearDepth = false;
+  add(renderDepthOnlyPass(cmdBuf, layer, viewProj, dynamicCasters));
+  cache.valid = true;
+  return stats;
+}
+
+ShadowCascadeUniforms
+ShadowPassInfo::cascadeUniforms(const Camera &camera) const {
+  ShadowCascadeUniforms out{};
+  const Mat4f viewInverse = camera.pose().matrix();
+  for (Uint32 i = 0; i < numCascades; i++) {
+    const Cascade &cascade = cascades[i];
+    out.viewToLight[i] = cascade.cam.viewProj() * viewInverse;
+    out.atlasRects[i] = {float(cascade.rect.x) / float(width),
+                         float(cascade.rect.y) / float(height),
+                         float(cascade.rect.w) / float(width),
+                         float(cascade.rect.h) / float(height)};
+    out.splits[i] = cascade.splitFar;
+  }
+  out.numCascades = numCascades;
+  return out;
+}
+
+/// Make the whole shadow map the single cascade of the pass, with the
+/// pass's light camera.
+static void useSingleCascade(ShadowPassInfo &passInfo) {
+  passInfo.cascades[0] = {
+      .cam = passInfo.cam,
+      .rect = {0, 0, int(passInfo.width), int(passInfo.height)},
+      .splitFar = std::numeric_limits<float>::max(),
+  };
+  passInfo.numCascades = 1;
+}
+
+void renderShadowPassCascaded(CommandBuffer &cmdBuf, ShadowPassInfo &passInfo,
+                              const DirectionalLight &dirLight,
+                              std::span<const OpaqueCastable> castables,
+                              const Camera &camera) {
+  const Float3 lightDir = dirLight.direction.normalized();
+  const FrustumCornersType corners = frustumFromCamera(camera);
+  // view distances of the near and far planes
+  const float zNear = -camera.transformPoint(corners[0]).z();
+  const float zFar = -camera.transformPoint(corners[4]).z();
+  const float shadowFar = passInfo.maxShadowDistance > 0.f
+                              ? std::min(zFar, passInfo.maxShadowDistance)
+                              : zFar;
+  // the light cameras only differ by their translation
+  const Mat3f lightRotation =
+      lookAt(Float3::Zero(), lightDir).topLeftCorner<3, 3>();
+
+  DepthPassStats stats;
+  stats.numCastables = Uint32(castables.size());
+  const Uint32 numCascades = passInfo.maxCascades;
+  float splitNear = zNear;
+  for (Uint32 i = 0; i < numCascades; i++) {
+    // blend of the logarithmic and uniform splits
+    const float p = float(i + 1) / float(numCascades);
+    const float uniformSplit = zNear + (shadowFar - zNear) * p;
+    const float logSplit =
+        zNear > 0.f ? zNear * std::pow(shadowFar / zNear, p) : uniformSplit;
+    const float splitFar =
+        std::lerp(uniformSplit, logSplit, passInfo.splitLambda);
+
+    // corners of the part of the frustum between the splits; corners 0-3 are
+    // on the near plane, and 4-7 on the far plane
+    const float t0 = (splitNear - zNear) / (zFar - zNear);
+    const float t1 = (splitFar - zNear) / (zFar - zNear);
+    FrustumCornersType part;
+    for (size_t c = 0; c < 4; c++) {
+      const Float3 edge = corners[c + 4] - corners[c];
+      part[c] = corners[c] + t0 * edge;
+      part[c + 4] = corners[c] + t1 * edge;
+    }
+    auto [center, radius] = frustumBoundingSphereCenterRadius(part);
+    radius = std::ceil(radius * 16.f) / 16.f;
+    // snap the center to the texels of the cascade, across the light rays
+    Float3 lightCenter = lightRotation * center;
+    const float texelX = 2.f * radius / float(passInfo.cascadeWidth);
+    const float texelY = 2.f * radius / float(passInfo.cascadeHeight);
+    lightCenter.x() = std::floor(lightCenter.x() / texelX) * texelX;
+    lightCenter.y() = std::floor(lightCenter.y() / texelY) * texelY;
+    center = lightRotation.transpose() * lightCenter;
+
+    ShadowPassInfo::Cascade &cascade = passInfo.cascades[i];
+    cascade.cam.view = lookAt(center - radius * lightDir, center);
+    cascade.cam.projection = shadowOrthographicMatrix(
+        {2.f * radius, 2.f * radius}, -radius, radius);
+    cascade.rect = {
+        int((i % 2) * passInfo.cascadeWidth),
+        int((i / 2) * passInfo.cascadeHeight),
+        int(passInfo.cascadeWidth),
+        int(passInfo.cascadeHeight),
+    };
+    cascade.splitFar = splitFar;
+
+    // the first cascade clears the whole shadow map
+    DepthPassInfo pass = passInfo;
+    pass.viewport = cascade.rect;
+    pass.clearDepth = i == 0;
+    pass.lodViewportHeight = float(passInfo.cascadeHeight);
+    pass.hiz = nullptr;
+    const ShadowReceiverVolume receivers{
+        .frustum = FrustumPlanes::fromCorners(part),
+        .lightDirection = lightDir,
+        .castDistance = 2.f * radius,
+    };
+    const DepthPassStats cascadeStats = renderDepthOnlyPass(
+        cmdBuf, pass, cascade.cam.viewProj(), castables, &receivers);
+    stats.numDrawn += cascadeStats.numDrawn;
+    stats.numCulledVolume += cascadeStats.numCulledVolume;
+    stats.numCulledReceivers += cascadeStats.numCulledReceivers;
+    stats.numInstanced += cascadeStats.numInstanced;
+    stats.numGpuCulled += cascadeStats.numGpuCulled;
+    stats.numGpuReceiverCulled += cascadeStats.numGpuReceiverCulled;
+    splitNear = splitFar;
+  }
+  passInfo.numCascades = numCascades;
+  passInfo.cam = passInfo.cascades[0].cam;
+  passInfo.stats = stats;
 }
 
 void renderShadowPassFromFrustum(CommandBuffer &cmdBuf,
@@ -180,13 +675,28 @@ void renderShadowPassFromFrustum(CommandBuffer &cmdBuf,
                                float(bounds.min_.z()), float(bounds.max_.z()));
 
   Mat4f viewProj = passInfo.cam.viewProj();
-  renderDepthOnlyPass(cmdBuf, passInfo, viewProj, castables);
+  useSingleCascade(passInfo);
+  // the light volume follows the camera: the cache only holds while the
+  // camera does not move
+  if (passInfo.cache.staticLayer) {
+    passInfo.stats =
+        renderCachedShadowPass(cmdBuf, passInfo, viewProj, castables);
+    return;
+  }
+  const ShadowReceiverVolume receivers{
+      .frustum = FrustumPlanes::fromCorners(worldSpaceCorners),
+      .lightDirection = dirLight.direction.normalized(),
+      .castDistance = 2.f * radius,
+  };
+  passInfo.stats =
+      renderDepthOnlyPass(cmdBuf, passInfo, viewProj, castables, &receivers);
 }
 
-void renderShadowPassFromAABB(CommandBuffer &cmdBuf, ShadowPassInfo &passInfo,
-                              const DirectionalLight &dirLight,
-                              std::span<const OpaqueCastable> castables,
-                              const AABB &worldSceneBounds) {
+void renderShadowPassFromAABB(
+    CommandBuffer &cmdBuf, ShadowPassInfo &passInfo,
+    const DirectionalLight &dirLight, std::span<const OpaqueCastable> castables,
+    const AABB &worldSceneBounds,
+    const std::optional<FrustumPlanes> &cameraFrustum) {
   Float3 center = worldSceneBounds.center().cast<float>();
   float radius = 0.5f * float(worldSceneBounds.size());
   radius = std::ceil(radius * 16.f) / 16.f;
@@ -202,6 +712,21 @@ void renderShadowPassFromAABB(CommandBuffer &cmdBuf, ShadowPassInfo &passInfo,
                                float(bounds.min_.z()), float(bounds.max_.z()));
 
   Mat4f viewProj = lightProj * lightView.matrix();
-  renderDepthOnlyPass(cmdBuf, passInfo, viewProj, castables);
+  useSingleCascade(passInfo);
+  if (passInfo.cache.staticLayer) {
+    passInfo.stats =
+        renderCachedShadowPass(cmdBuf, passInfo, viewProj, castables);
+    return;
+  }
+  std::optional<ShadowReceiverVolume> receivers;
+  if (cameraFrustum) {
+    receivers = ShadowReceiverVolume{
+        .frustum = *cameraFrustum,
+        .lightDirection = dirLight.direction.normalized(),
+        .castDistance = 2.f * radius,
+    };
+  }
+  passInfo.stats = renderDepthOnlyPass(cmdBuf, passInfo, viewProj, castables,
+                                       receivers ? &*receivers : nullptr);
 }
 } // namespace candlewick
@@ -5,11 +5,13 @@
 /// passes.
 ///
 /// When using a depth pre-pass with `EQUAL` depth comparison in the main pass,
-/// ensure identical vertex transformations between passes by:
-/// 1. Computing the MVP matrix on CPU side
-/// 2. Using the same MVP matrix in both pre-pass and main pass shaders
-/// 3. Avoiding shader-side matrix multiplication that might cause precision
-/// differences.
+/// ensure identical vertex transformations between passes by either:
+/// 1. Computing the MVP matrix on CPU side, and using the same MVP matrix in
+/// both pre-pass and main pass shaders, or
+/// 2. Reading the model matrices from the same ObjectBuffer in both passes,
+/// with shaders computing the clip-space positions with the same expression
+/// and an `invariant` output (as `ShadowCastInstanced.vert` and
+/// `PbrBasicInstanced.vert` do).
 ///
 /// Failing to do this can result in z-fighting/Moiré patterns due to
 /// floating-point precision differences between CPU and GPU matrix
@@ -22,15 +24,50 @@
 
 #include "Core.h"
 #include "Camera.h"
+#include "Culling.h"
+#include "GpuDrawList.h"
+#include "HiZPyramid.h"
 #include "Mesh.h"
+#include "ObjectBuffer.h"
 #include "math_types.h"
 #include "LightUniforms.h"
 
 #include <entt/entity/fwd.hpp>
+#include <array>
+#include <memory>
+#include <optional>
 #include <span>
+#include <vector>
 
 namespace candlewick {
 
+/// \ingroup depth_pass
+/// \brief Number of castables drawn and culled by a depth-only pass.
+/// \sa renderDepthOnlyPass()
+struct DepthPassStats {
+  Uint32 numCastables = 0;
+  Uint32 numDrawn = 0;
+  /// Castables outside of the volume of the pass.
+  Uint32 numCulledVolume = 0;
+  /// Castables whose shadows cannot reach the receiver volume.
+  Uint32 numCulledReceivers = 0;
+  /// Castables drawn within instanced draws of several castables.
+  Uint32 numInstanced = 0;
+  /// Mesh views culled on the GPU, in place of the castables. How many of
+  /// them are drawn is not known on the CPU. \sa DepthPassInfo::drawList
+  Uint32 numGpuCulled = 0;
+  /// Castables whose depths were reused from the cached layers of a shadow
+  /// map, rather than drawn. \sa ShadowPassConfig::enable_caching
+  Uint32 numCached = 0;
+  /// Mesh views culled on the GPU as hidden behind the Hi-Z pyramid of the
+  /// pass, read back GpuCullOutput::kReadbackFrames passes late.
+  /// \sa DepthPassInfo::hiz
+  Uint32 numGpuOccluded = 0;
+  /// Mesh views culled on the GPU as their shadows cannot reach the receiver
+  /// volume, read back as late as \ref numGpuOccluded.
+  Uint32 numGpuReceiverCulled = 0;
+};
+
 /// \ingroup depth_pass
 /// \brief Helper struct for depth or light pre-passes.
 /// \warning The depth pre-pass is meant for _opaque_ geometries. Hence, the
@@ -39,6 +76,8 @@ namespace candlewick {
 struct DepthPassInfo {
   enum DepthPassSlots : Uint32 {
     TRANSFORM_SLOT = 0,
+    /// First instance of the draws of the instanced pipeline.
+    DRAW_SLOT = 1,
   };
   struct Config {
     SDL_GPUCullMode cull_mode;
@@ -46,23 +85,87 @@ struct DepthPassInfo {
     float depth_bias_slope_factor;
     bool enable_depth_bias;
     bool enable_depth_clip;
+    /// Also create the instanced pipeline, which reads the transforms from an
+    /// ObjectBuffer, and its instance buffer.
+    bool enable_instancing;
+    /// Also create the indirect pipeline, which draws a GpuDrawList, and the
+    /// buffer of its draw commands.
+    bool enable_gpu_culling;
   };
   SDL_GPUTexture *depthTexture = nullptr;
   SDL_GPUGraphicsPipeline *pipeline = nullptr;
+  /// Whether the pipeline reads the meshes' position-only streams, i.e. was
+  /// created with a positionStreamLayout().
+  bool positionOnly = false;
+  /// Largest simplification error, in pixels of the depth texture, of the
+  /// levels of detail drawn by the pass. If 0, meshes are drawn at full
+  /// detail. A depth pre-pass should use the same threshold as the main pass.
+  /// \sa selectLod()
+  float lodPixelError = 0.f;
+  /// Height of the depth texture, in pixels, for selecting levels of detail.
+  float lodViewportHeight = 0.f;
+  /// Whether to skip castables outside of the volume of the pass, on their
+  /// mesh bounds. \sa Mesh::bounds()
+  bool cullCastables = true;
+  /// Whether to draw the castables front to back, on the depth of the
+  /// centers of their bounds, so that the nearest surfaces are written first
+  /// and the farther fragments fail the depth test early. Instanced draws
+  /// are ordered by their nearest castable. Draws culled on the GPU keep
+  /// the order of the draw list.
+  bool sortFrontToBack = false;
+  /// Whether the pass clears the depth texture, or draws over its contents.
+  bool clearDepth = true;
+  /// Region of the depth texture drawn by the pass, e.g. a cascade of a
+  /// shadow map. If empty, the whole texture. Clearing the depth texture
+  /// still clears all of it.
+  SDL_Rect viewport{0, 0, 0, 0};
+  /// Whether the pipeline clips depth. If not, geometry in front of the near
+  /// plane is clamped to it and still drawn, so the near plane does not cull.
+  bool depthClip = true;
+  /// Per-frame transforms of the castables, e.g. RobotScene::objectBuffer().
+  /// \sa OpaqueCastable::object
+  const ObjectBuffer *objectBuffer = nullptr;
+  /// Pipeline drawing the castables of \ref objectBuffer, reading their model
+  /// matrices from it. Castables which share their mesh views are drawn with
+  /// one instanced draw. If null, the castables' transforms are pushed as
+  /// uniforms, for each draw.
+  SDL_GPUGraphicsPipeline *instancedPipeline = nullptr;
+  /// Object indices of the instances of the pass' draws. Shared by copies of
+  /// the pass.
+  std::shared_ptr<InstanceBuffer> instanceBuffer;
+  /// Draws of the objects of \ref objectBuffer, e.g.
+  /// RobotScene::gpuDrawList(). If set, and the pass has an indirect
+  /// pipeline, they are culled on the GPU and drawn in place of the
+  /// castables.
+  const GpuDrawList *drawList = nullptr;
+  /// Pipeline drawing \ref drawList, with the drawRecordLayout() of the
+  /// pass's layout.
+  SDL_GPUGraphicsPipeline *indirectPipeline = nullptr;
+  /// Vertex buffer slot of the draw records in \ref indirectPipeline.
+  Uint32 drawRecordSlot = 0;
+  /// Draw commands written by the culling of \ref drawList. Shared by copies
+  /// of the pass.
+  std::shared_ptr<GpuCullOutput> cullOutput;
+  /// Hi-Z pyramid of the depth texture, built after each pass, against which
+  /// the next pass culls the draws of \ref drawList. Its size must be that
+  /// of the depth texture. If null, the draws are only frustum-culled.
+  std::shared_ptr<HiZPyramid> hiz;
 
   /// \brief Create DepthPass (e.g. for a depth pre-pass) from a Renderer
   /// and specified MeshLayout.
   ///
   /// \param renderer The Renderer object.
   /// \param layout %Mesh layout used for the render pipeline's vertex input
-  /// state.
+  /// state. Pass the positionStreamLayout() of the meshes' layout to draw
+  /// from their position-only streams.
   /// \param depth_texture If null, we assume that the depth texture to use is
   /// the shared depth texture stored in \p renderer.
   /// \sa createShadowPass()
   [[nodiscard]] static DepthPassInfo
   create(const Renderer &renderer, const MeshLayout &layout,
          SDL_GPUTexture *depth_texture = NULL, Config config = {});
-  /// Release the pass pipeline.
+  /// Release the pass pipelines, the instance and command buffers, and the
+  /// Hi-Z pyramid.
   /// \warning We do not depth texture here, because it is assumed to be
   /// borrowed.
   void release();
@@ -74,14 +177,130 @@ protected:
 /// \brief Shadow pass configuration, to use in createShadowPass().
 struct ShadowPassConfig {
   // default is 2k x 2k texture
+  /// Size of the shadow map, or of each cascade of a cascaded shadow map.
   Uint32 width = 2048;
   Uint32 height = 2048;
+  /// Number of cascades of the shadow map, up to \ref kMaxShadowCascades,
+  /// drawn by renderShadowPassCascaded(). The cascades are the cells of a
+  /// 2x1 or 2x2 grid in a single texture: with 4 cascades, the shadow map
+  /// texture is twice as wide and high as \ref width and \ref height.
+  Uint32 num_cascades = 1;
+  /// Blend between logarithmic (1) and uniform (0) splits of the camera
+  /// frustum between the cascades.
+  float cascade_split_lambda = 0.75f;
+  /// View distance up to which the cascades cast shadows. If 0, the far
+  /// plane of the camera.
+  float max_shadow_distance = 0.f;
+  /// Largest simplification error, in shadow map texels, of the levels of
+  /// detail drawn to the shadow map. \sa DepthPassInfo::lodPixelError
+  float lod_pixel_error = 2.f;
+  /// Draw the casters from an ObjectBuffer, sharing their mesh views with
+  /// instanced draws. This needs the compiled `ShadowCastInstanced.vert`.
+  /// \sa DepthPassInfo::instancedPipeline
+  bool enable_instancing = false;
+  /// Cull the casters on the GPU and draw them with indirect draws, when the
+  /// pass is given a GpuDrawList. \sa DepthPassInfo::drawList
+  bool enable_gpu_culling = false;
+  /// With GPU culling, also cull the casters hidden from the light behind
+  /// the casters of the previous shadow map. \sa DepthPassInfo::hiz
+  bool enable_occlusion_culling = false;
+  /// Cache the shadow map: the static casters are drawn to a separate layer
+  /// only when they or the light change, and the shadow map is rebuilt from
+  /// that layer and the dynamic casters only when a caster moves. Shadows of
+  /// static scenes then cost a comparison of the casters' transforms per
+  /// frame. Caching needs the casters' meshes, so the GPU draw list is not
+  /// used, and the casters are not culled on the receiver volume, which
+  /// moves with the camera. Ignored with several cascades, whose light
+  /// cameras move with the camera. \sa OpaqueCastable::isStatic
+  bool enable_caching = false;
+};
+
+/// \brief Largest number of cascades of a shadow map.
+inline constexpr Uint32 kMaxShadowCascades = 4;
+
+/// \brief Uniforms of the cascades of a shadow map, as read by the PBR
+/// fragment shaders (the `ShadowBlock` of `PbrBasic.frag`).
+/// \sa ShadowPassInfo::cascadeUniforms()
+struct alignas(16) ShadowCascadeUniforms {
+  /// From the view space of the main camera to the NDC of each cascade.
+  GpuMat4 viewToLight[kMaxShadowCascades];
+  /// Region (offset, size) of each cascade in the shadow map, in texture
+  /// coordinates.
+  GpuVec4 atlasRects[kMaxShadowCascades];
+  /// View distance up to which each cascade is used.
+  GpuVec4 splits;
+  /// If 0, the fragments are not shadowed.
+  Uint32 numCascades;
 };
 
+struct OpaqueCastable;
+
 struct ShadowPassInfo : DepthPassInfo {
+  /// \brief A cascade of the shadow map: its light camera, and the region of
+  /// the shadow map it is drawn to.
+  struct Cascade {
+    Camera cam;
+    SDL_Rect rect;
+    /// View distance from the main camera up to which the cascade is used.
+    float splitFar;
+  };
+
+  /// Mesh and transform of a caster of the cached depths.
+  struct CachedCaster {
+    const Mesh *mesh;
+    Mat4f transform;
+  };
+  /// \brief Cached layers of the shadow map.
+  /// \sa ShadowPassConfig::enable_caching
+  struct Cache {
+    /// Depths of the static casters, copied to the shadow map before the
+    /// dynamic casters are drawn over them. Null unless caching is enabled,
+    /// for a shadow map with a single cascade.
+    SDL_GPUTexture *staticLayer = nullptr;
+    /// Light view-projection matrix of the cached depths.
+    Mat4f viewProj = Mat4f::Zero();
+    std::vector<CachedCaster> staticCasters;
+    std::vector<CachedCaster> dynamicCasters;
+    /// Whether the static layer, and the shadow map, hold the depths of the
+    /// current casters.
+    bool staticValid = false;
+    bool valid = false;
+
+    /// \brief Redraw both layers on the next render, e.g. after a change of
+    /// the casters' meshes which keeps their transforms.
+    void invalidate() { staticValid = valid = false; }
+
+    /// \brief Record the light and the casters of the next render, and
+    /// invalidate the layers whose casters changed: moved, added, removed or
+    /// swapped for another mesh. A change of light invalidates both.
+    void update(const Mat4f &lightViewProj,
+                std::span<const OpaqueCastable> castables);
+  };
+
   /// Sampler to use for main render passes.
   SDL_GPUSampler *sampler;
+  /// Light camera of the first cascade, i.e. of the whole shadow map unless
+  /// it is cascaded.
   Camera cam;
+  /// Statistics of the last render of the shadow map.
+  DepthPassStats stats;
+  Cache cache;
+  /// Size of the shadow map texture.
+  Uint32 width = 0;
+  Uint32 height = 0;
+  /// Number of cascades, and size of each, as configured.
+  Uint32 maxCascades = 1;
+  Uint32 cascadeWidth = 0;
+  Uint32 cascadeHeight = 0;
+  float splitLambda = 0.75f;
+  float maxShadowDistance = 0.f;
+  /// Cascades of the last render of the shadow map. A shadow map rendered
+  /// as a whole has one cascade, covering the texture.
+  std::array<Cascade, kMaxShadowCascades> cascades;
+  Uint32 numCascades = 0;
+
+  /// \brief Uniforms of the cascades, for the main pass of \p camera.
+  ShadowCascadeUniforms cascadeUniforms(const Camera &camera) const;
 
   /// \sa DepthPassInfo::create()
   [[nodiscard]] static ShadowPassInfo create(const Renderer &renderer,
@@ -100,13 +319,51 @@ struct OpaqueCastable {
   entt::entity ent;
   const Mesh &mesh;
   Mat4f transform;
+  /// Index of the castable in DepthPassInfo::objectBuffer, if any.
+  Uint32 object = ObjectBuffer::kNoObject;
+  /// Whether the castable never moves, e.g. an environment object. Static
+  /// castables are drawn to the static layer of cached shadow maps.
+  /// \sa ShadowPassConfig::enable_caching
+  bool isStatic = false;
+};
+
+/// \ingroup depth_pass
+/// \brief Volume in which the shadows of a shadow pass are received, e.g. the
+/// camera frustum. Casters whose shadows cannot fall inside it are culled.
+struct ShadowReceiverVolume {
+  /// World-space frustum of the receivers.
+  FrustumPlanes frustum;
+  /// Direction of the light rays.
+  Float3 lightDirection;
+  /// Distance along the light rays over which shadows are cast, e.g. the depth
+  /// of the light volume.
+  float castDistance;
 };
 
 /// \ingroup depth_pass
 /// \brief Render a depth-only pass, built from a set of OpaqueCastable.
-void renderDepthOnlyPass(CommandBuffer &cmdBuf, const DepthPassInfo &passInfo,
-                         const Mat4f &viewProj,
-                         std::span<const OpaqueCastable> castables);
+///
+/// Unless DepthPassInfo::cullCastables is false, castables whose world-space
+/// bounds are outside of the volume of \p viewProj are skipped, and so are
+/// those whose bounds, extruded along the light rays, miss \p receivers.
+/// Castables without bounds are always drawn.
+///
+/// If the pass has an instanced pipeline and an object buffer, the castables
+/// with an object index are drawn with transforms read from the object buffer,
+/// and those drawing the same mesh views at the same level of detail with one
+/// instanced draw. Their object indices are uploaded to the pass's instance
+/// buffer before the render pass begins.
+///
+/// If the pass has a draw list and an indirect pipeline, the castables are
+/// ignored: the draws of the list are culled against the volume of
+/// \p viewProj and against \p receivers by a compute pass, then drawn with
+/// indirect draws. If the pass has a Hi-Z pyramid, the draws hidden behind it
+/// are culled too, and it is rebuilt from the depths of the pass.
+DepthPassStats
+renderDepthOnlyPass(CommandBuffer &cmdBuf, const DepthPassInfo &passInfo,
+                    const Mat4f &viewProj,
+                    std::span<const OpaqueCastable> castables,
+                    const ShadowReceiverVolume *receivers = nullptr);
 
 /// \addtogroup depth_pass
 /// \section depth_testing Depth testing in modern APIs
@@ -122,18 +379,41 @@ void renderDepthOnlyPass(CommandBuffer &cmdBuf, const DepthPassInfo &passInfo,
 /// \{
 /// \brief Render shadow pass, using provided scene bounds.
 ///
-/// The scene bounds are in world-space.
-void renderShadowPassFromAABB(CommandBuffer &cmdBuf, ShadowPassInfo &passInfo,
+/// The scene bounds are in world-space. If provided, casters whose shadows
+/// cannot fall inside the world-space \p cameraFrustum are culled.
+///
+/// If the pass caches its shadow map, and neither the light, the scene
+/// bounds nor the casters changed since the last render, the shadow map is
+/// kept as is.
+void renderShadowPassFromAABB(
+    CommandBuffer &cmdBuf, ShadowPassInfo &passInfo,
+    const DirectionalLight &dirLight, std::span<const OpaqueCastable> castables,
+    const AABB &worldSceneBounds,
+    const std::optional<FrustumPlanes> &cameraFrustum = std::nullopt);
+
+/// \brief Render a cascaded shadow map, its cascades fit to splits of the
+/// camera frustum.
+///
+/// The frustum of \p camera, up to ShadowPassConfig::max_shadow_distance, is
+/// split along the view direction into ShadowPassInfo::maxCascades parts,
+/// and each cascade covers the bounding sphere of its part, its center
+/// snapped to the texels of the cascade so that the shadows do not shimmer
+/// as the camera moves. Each cascade culls the casters on its own light
+/// volume and receiver volume. Nearer cascades cover less of the scene,
+/// hence shadows near the camera get more texels.
+/// \warning The shadow map is not cached.
+void renderShadowPassCascaded(CommandBuffer &cmdBuf, ShadowPassInfo &passInfo,
                               const DirectionalLight &dirLight,
                               std::span<const OpaqueCastable> castables,
-                              const AABB &worldSceneBounds);
+                              const Camera &camera);
 
 /// \brief Render shadow pass, using a provided world-space frustum.
 ///
 /// This routine creates a bounding sphere around the frustum, and compute
 /// light-space view and projection matrices which will enclose this bounding
 /// sphere within the light volume. The frustum can be obtained from the
-/// world-space camera.
+/// world-space camera. Casters whose shadows cannot fall inside the frustum
+/// are culled.
 /// \sa frustumFromCameraProjection()
 void renderShadowPassFromFrustum(CommandBuffer &cmdBuf,
                                  ShadowPassInfo &passInfo,
@@ -28,6 +28,7 @@ void Device::create(SDL_GPUShaderFormat format_flags, bool debug_mode) {
     throw RAIIException(SDL_GetError());
   const char *driver = SDL_GetGPUDeviceDriver(_device);
   SDL_Log("Device driver: %s", driver);
+  _uploadRing = std::make_unique<UploadRing>(_device);
 }
 
 const char *Device::driverName() const noexcept {
@@ -35,6 +36,7 @@ const char *Device::driverName() const noexcept {
 }
 
 void Device::destroy() noexcept {
+  _uploadRing.reset();
   if (_device)
     SDL_DestroyGPUDevice(_device);
   _device = nullptr;
@@ -2,7 +2,10 @@
 
 #include "Core.h"
 #include "Tags.h"
+#include "UploadRing.h"
 #include <SDL3/SDL_gpu.h>
+#include <SDL3/SDL_assert.h>
+#include <memory>
 
 namespace candlewick {
 
@@ -33,10 +36,20 @@ struct Device {
     return SDL_GetGPUShaderFormats(_device);
   }
 
+  /// \brief Persistent staging memory for uploads to this device.
+  /// \warning The device must be initialized.
+  UploadRing &uploadRing() const {
+    SDL_assert(_uploadRing);
+    return *_uploadRing;
+  }
+
   /// \brief Release ownership of and return the \c SDL_GPUDevice handle.
+  /// The upload ring is released first.
   SDL_GPUDevice *release() noexcept {
-    return _device;
+    _uploadRing.reset();
+    SDL_GPUDevice *device = _device;
     _device = nullptr;
+    return device;
   }
   void destroy() noexcept;
 
@@ -46,12 +59,13 @@ struct Device {
 
 private:
   SDL_GPUDevice *_device;
+  std::unique_ptr<UploadRing> _uploadRing;
 };
 
 inline Device::Device(NoInitT) noexcept : _device(nullptr) {}
 
-inline Device::Device(Device &&other) noexcept {
-  _device = other._device;
+inline Device::Device(Device &&other) noexcept
+    : _device(other._device), _uploadRing(std::move(other._uploadRing)) {
   other._device = nullptr;
 }
 
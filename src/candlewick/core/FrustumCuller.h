@@ -0,0 +1,61 @@
+#pragma once
+
+#include "Components.h"
+#include "Culling.h"
+
+#include <span>
+#include <entt/entity/registry.hpp>
+
+namespace candlewick {
+
+/// \brief Recompute the WorldBoundsComponent of all entities with a
+/// TransformComponent and a \p MeshComponent (which holds a \c mesh member),
+/// after their transforms are updated. The bounds are those of Mesh::bounds():
+/// meshes whose vertices are rewritten on the GPU must have their bounds
+/// updated too, as updateMeshVertices() does.
+template <typename MeshComponent>
+void updateWorldBounds(entt::registry &registry) {
+  auto view = registry.view<const TransformComponent, const MeshComponent,
+                            WorldBoundsComponent>();
+  for (auto [ent, tr, comp, bounds] : view.each())
+    bounds = worldBounds(comp.mesh, tr);
+}
+
+/// \brief Frustum culling of the entities of a view, on their
+/// WorldBoundsComponent. The bounds are gathered in an AabbBatch and tested
+/// \ref AabbBatch::kLanes at a time.
+///
+/// Entities without a WorldBoundsComponent are never culled. The culler only
+/// holds scratch memory, reused from one call to the next.
+class FrustumCuller {
+public:
+  /// \brief Entities of \p view which intersect \p frustum (in world space),
+  /// in the order of the view. The span is valid until the next call.
+  template <typename View>
+  std::span<const entt::entity> cull(const entt::registry &registry,
+                                     const View &view,
+                                     const FrustumPlanes &frustum) {
+    m_candidates.clear();
+    m_batch.clear();
+    for (entt::entity ent : view) {
+      const auto *bounds = registry.try_get<WorldBoundsComponent>(ent);
+      m_candidates.push_back(ent);
+      m_batch.push(bounds ? AABBf{*bounds} : AABBf{});
+    }
+    m_batch.cull(frustum, m_mask);
+    m_visible.clear();
+    for (size_t i = 0; i < m_candidates.size(); i++) {
+      if (m_mask[i])
+        m_visible.push_back(m_candidates[i]);
+    }
+    return m_visible;
+  }
+
+private:
+  AabbBatch m_batch;
+  std::vector<Uint8> m_mask;
+  std::vector<entt::entity> m_candidates;
+  std::vector<entt::entity> m_visible;
+};
+
+} // namespace candlewick
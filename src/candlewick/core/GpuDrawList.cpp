@@ -0,0 +1,254 @@
+#include "GpuDrawList.h"
+#include "CommandBuffer.h"
+#include "DepthAndShadowPass.h"
+#include "Device.h"
+#include "HiZPyramid.h"
+#include "Mesh.h"
+#include "ObjectBuffer.h"
+#include "Renderer.h"
+#include "Shader.h"
+#include "errors.h"
+
+#include <cstddef>
+
+namespace candlewick {
+
+MeshLayout drawRecordLayout(const MeshLayout &layout) {
+  const Uint32 slot = layout.numBuffers();
+  MeshLayout out = layout;
+  out.addInstanceBinding(slot, sizeof(GpuDrawRecord))
+      .addAttribute(VertexAttrib::DrawObject, slot,
+                    SDL_GPU_VERTEXELEMENTFORMAT_UINT,
+                    offsetof(GpuDrawRecord, object))
+      .addAttribute(VertexAttrib::DrawMaterial, slot,
+                    SDL_GPU_VERTEXELEMENTFORMAT_UINT,
+                    offsetof(GpuDrawRecord, material));
+  return out;
+}
+
+/// Uniforms of `CullDraws.comp` and `CullDrawsOcclusion.comp`.
+struct alignas(16) CullUniforms {
+  GpuVec4 planes[6];
+  GpuMat4 hizViewProj;
+  GpuVec2 depthSize;
+  Uint32 hizLevels;
+  Uint32 numDraws;
+  GpuVec4 receiverPlanes[6];
+  /// Extrusion of the bounds along the light rays, and whether the receiver
+  /// planes are used (w > 0).
+  GpuVec4 receiverShift;
+};
+static_assert(sizeof(CullUniforms) == 288);
+
+/// Workgroup size of `CullDraws.comp`.
+static constexpr Uint32 kCullGroupSize = 64;
+
+GpuCullOutput::GpuCullOutput(const Device &device)
+    : m_device(&device),
+      m_commands(device, GpuDrawList::kCommandBufferUsage) {
+  SDL_GPUTransferBufferCreateInfo info{
+      .usage = SDL_GPU_TRANSFERBUFFERUSAGE_DOWNLOAD,
+      .size = kReadbackFrames * kCountersSize,
+      .props = 0,
+  };
+  m_readback = SDL_CreateGPUTransferBuffer(device, &info);
+  if (!m_readback)
+    throw RAIIException(SDL_GetError());
+}
+
+void GpuCullOutput::beginCull(CommandBuffer &command_buffer,
+                              Uint32 numDraws) {
+  const Uint32 slot = Uint32(m_numCulls % kReadbackFrames);
+  // the slot about to be reused holds the counters of the oldest cull, which
+  // the GPU completed frames ago
+  if (m_numCulls >= kReadbackFrames) {
+    auto *counters =
+        (const Uint32 *)SDL_MapGPUTransferBuffer(*m_device, m_readback, false);
+    if (counters) {
+      m_stats = {
+          .numDraws = m_slotDraws[slot],
+          .numFrustumCulled = counters[3 * slot],
+          .numOccluded = counters[3 * slot + 1],
+          .numReceiverCulled = counters[3 * slot + 2],
+      };
+      SDL_UnmapGPUTransferBuffer(*m_device, m_readback);
+    }
+  }
+  m_slotDraws[slot] = numDraws;
+
+  m_commands.reserve(kCountersSize + numDraws * GpuDrawList::kCommandSize);
+  // cycles the buffer: the commands are all rewritten by the cull
+  const Uint32 zeros[3]{0, 0, 0};
+  m_commands.upload(command_buffer, std::span<const Uint32>{zeros});
+}
+
+void GpuCullOutput::endCull(CommandBuffer &command_buffer) {
+  const Uint32 slot = Uint32(m_numCulls % kReadbackFrames);
+  SDL_GPUCopyPass *copy_pass = SDL_BeginGPUCopyPass(command_buffer);
+  const SDL_GPUBufferRegion src{
+      .buffer = m_commands.buffer(),
+      .offset = 0,
+      .size = kCountersSize,
+  };
+  const SDL_GPUTransferBufferLocation dst{
+      .transfer_buffer = m_readback,
+      .offset = slot * kCountersSize,
+  };
+  SDL_DownloadFromGPUBuffer(copy_pass, &src, &dst);
+  SDL_EndGPUCopyPass(copy_pass);
+  m_numCulls++;
+}
+
+void GpuCullOutput::release() noexcept {
+  m_commands.release();
+  if (m_readback) {
+    SDL_ReleaseGPUTransferBuffer(*m_device, m_readback);
+    m_readback = nullptr;
+  }
+}
+
+GpuDrawList::GpuDrawList(const Device &device)
+    : m_device(&device),
+      m_pipeline(createComputePipeline(device, "CullDraws.comp")),
+      m_occlusionPipeline(
+          createComputePipeline(device, "CullDrawsOcclusion.comp")),
+      m_recordBuffer(device, SDL_GPU_BUFFERUSAGE_VERTEX |
+                                 SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_READ) {}
+
+/// Whether two meshes are drawn with the same bindings.
+static bool sameBuffers(const Mesh &a, const Mesh &b) {
+  return a.vertexBuffers[0] == b.vertexBuffers[0] &&
+         a.positionBuffer == b.positionBuffer &&
+         a.indexBuffer == b.indexBuffer;
+}
+
+void GpuDrawList::addDraws(const Mesh &mesh, Uint32 object,
+                           Uint32 firstMaterial) {
+  const auto views = mesh.views();
+  for (size_t j = 0; j < views.size(); j++) {
+    const MeshView &view = views[j];
+    AABBf bounds = mesh.viewBounds(j);
+    if (bounds.isEmpty())
+      bounds = mesh.bounds();
+    const bool indexed = view.isIndexed();
+    if (m_batches.empty() || m_batches.back().indexed != indexed ||
+        !sameBuffers(*m_batches.back().mesh, mesh))
+      m_batches.push_back({&mesh, size(), 0, indexed});
+    m_batches.back().count++;
+    m_records.push_back({
+        .boundsMin = bounds.min(),
+        .object = object,
+        .boundsMax = bounds.max(),
+        .material = firstMaterial + Uint32(j),
+        .indexCount = view.indexCount,
+        .firstIndex = view.indexOffset,
+        .vertexOffset = Sint32(view.vertexOffset),
+        .vertexCount = view.vertexCount,
+    });
+  }
+}
+
+void GpuDrawList::upload(CommandBuffer &command_buffer) {
+  m_recordBuffer.upload(command_buffer, std::span{m_records});
+}
+
+void GpuDrawList::cull(CommandBuffer &command_buffer,
+                       const ObjectBuffer &objects,
+                       const FrustumPlanes &frustum, GpuCullOutput &output,
+                       const HiZPyramid *occlusion,
+                       const ShadowReceiverVolume *receivers) const {
+  if (empty())
+    return;
+  output.beginCull(command_buffer, size());
+  const bool occlusionCulling = occlusion && occlusion->ready();
+
+  // keep the counters zeroed by beginCull()
+  SDL_GPUStorageBufferReadWriteBinding binding{
+      .buffer = output.buffer(),
+      .cycle = false,
+  };
+  SDL_GPUComputePass *pass =
+      SDL_BeginGPUComputePass(command_buffer, nullptr, 0, &binding, 1);
+  SDL_BindGPUComputePipeline(pass, occlusionCulling ? m_occlusionPipeline
+                                                    : m_pipeline);
+  CullUniforms ubo{};
+  for (size_t i = 0; i < 6; i++)
+    ubo.planes[i] = frustum.planes[i];
+  if (receivers) {
+    for (size_t i = 0; i < 6; i++)
+      ubo.receiverPlanes[i] = receivers->frustum.planes[i];
+    ubo.receiverShift << receivers->castDistance * receivers->lightDirection,
+        1.f;
+  } else {
+    ubo.receiverShift.setZero();
+  }
+  if (occlusionCulling) {
+    const SDL_GPUTextureSamplerBinding pyramid{
+        .texture = occlusion->texture(),
+        .sampler = occlusion->sampler(),
+    };
+    SDL_BindGPUComputeSamplers(pass, 0, &pyramid, 1);
+    ubo.hizViewProj = occlusion->viewProj();
+    ubo.depthSize = GpuVec2(occlusion->depthWidth(), occlusion->depthHeight());
+    ubo.hizLevels = occlusion->numLevels();
+  }
+  objects.bindCompute(pass, 0);
+  m_recordBuffer.bindCompute(pass, 1);
+  ubo.numDraws = size();
+  command_buffer.pushComputeUniform(0, &ubo, sizeof(ubo));
+  SDL_DispatchGPUCompute(pass, (size() + kCullGroupSize - 1) / kCullGroupSize,
+                         1, 1);
+  SDL_EndGPUComputePass(pass);
+  output.endCull(command_buffer);
+}
+
+Uint32 GpuDrawList::draw(SDL_GPURenderPass *pass,
+                         const GpuCullOutput &output, Uint32 instanceSlot,
+                         bool positionsOnly) const {
+  if (empty())
+    return 0;
+  const SDL_GPUBufferBinding records{
+      .buffer = m_recordBuffer.buffer(),
+      .offset = 0,
+  };
+  SDL_BindGPUVertexBuffers(pass, instanceSlot, &records, 1);
+
+  rend::MeshBinder binder{pass};
+  Uint32 numCalls = 0;
+  for (const Batch &batch : m_batches) {
+    if (positionsOnly)
+      binder.bindPositions(*batch.mesh);
+    else
+      binder.bind(*batch.mesh);
+    if (batch.indexed) {
+      SDL_DrawGPUIndexedPrimitivesIndirect(pass, output.buffer(),
+                                           GpuCullOutput::kCountersSize +
+                                               batch.first * kCommandSize,
+                                           batch.count);
+      numCalls++;
+      continue;
+    }
+    // the first instance selects the draw record
+    for (Uint32 i = batch.first; i < batch.first + batch.count; i++) {
+      const GpuDrawRecord &record = m_records[i];
+      SDL_DrawGPUPrimitives(pass, record.vertexCount, 1,
+                            Uint32(record.vertexOffset), i);
+      numCalls++;
+    }
+  }
+  return numCalls;
+}
+
+void GpuDrawList::release() noexcept {
+  m_recordBuffer.release();
+  if (m_pipeline) {
+    SDL_ReleaseGPUComputePipeline(*m_device, m_pipeline);
+    m_pipeline = nullptr;
+  }
+  if (m_occlusionPipeline) {
+    SDL_ReleaseGPUComputePipeline(*m_device, m_occlusionPipeline);
+    m_occlusionPipeline = nullptr;
+  }
+}
+
+} // namespace candlewick
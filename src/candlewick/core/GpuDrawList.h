@@ -0,0 +1,201 @@
+#pragma once
+
+#include "Core.h"
+#include "Culling.h"
+#include "InstanceBuffer.h"
+#include "MeshLayout.h"
+#include "math_types.h"
+
+#include <array>
+#include <vector>
+
+namespace candlewick {
+
+class HiZPyramid;
+class ObjectBuffer;
+struct ShadowReceiverVolume;
+
+/// \brief A draw of a mesh view of an object, as recorded in a GpuDrawList.
+///
+/// This matches the `DrawRecord` struct of `CullDraws.comp`. The indirect
+/// pipelines also read the object and material as instance-rate vertex
+/// attributes, see drawRecordLayout().
+struct alignas(16) GpuDrawRecord {
+  /// Bounds of the view, in the frame of the Mesh's stored positions. Empty
+  /// bounds (min > max) are never culled.
+  GpuVec3 boundsMin;
+  Uint32 object; //< Index of the object in the ObjectBuffer.
+  GpuVec3 boundsMax;
+  /// Index of the material, see ObjectBuffer::materialIndex().
+  Uint32 material;
+  Uint32 indexCount;
+  Uint32 firstIndex;
+  Sint32 vertexOffset;
+  Uint32 vertexCount;
+};
+static_assert(sizeof(GpuDrawRecord) == 48);
+
+/// \brief Layout of the pipelines which draw a GpuDrawList: \p layout, with
+/// the draw records as an instance-rate binding after its own bindings. The
+/// object and material are at the locations of VertexAttrib::DrawObject and
+/// VertexAttrib::DrawMaterial.
+MeshLayout drawRecordLayout(const MeshLayout &layout);
+
+/// \brief Counters of the draws culled by a GpuDrawList::cull().
+struct GpuCullStats {
+  Uint32 numDraws = 0;
+  /// Draws outside of the frustum.
+  Uint32 numFrustumCulled = 0;
+  /// Draws inside of the frustum, but hidden behind the depths of the Hi-Z
+  /// pyramid.
+  Uint32 numOccluded = 0;
+  /// Draws inside of the frustum, whose shadows cannot reach the receiver
+  /// volume.
+  Uint32 numReceiverCulled = 0;
+};
+
+/// \brief Output of GpuDrawList::cull(): the buffer of indirect draw
+/// commands, and the counters of the culled draws.
+///
+/// The buffer starts with the counters, followed by the commands. After each
+/// cull, the counters are copied to a ring of \ref kReadbackFrames slots of a
+/// download transfer buffer, and read back that many frames later, once the
+/// GPU is done with them, so that stats() never waits on the GPU.
+class GpuCullOutput {
+public:
+  /// Number of culls after which the counters are read back.
+  static constexpr Uint32 kReadbackFrames = 4;
+  /// Size of the counters at the start of the buffer.
+  static constexpr Uint32 kCountersSize = 3 * sizeof(Uint32);
+
+  explicit GpuCullOutput(const Device &device);
+  GpuCullOutput(const GpuCullOutput &) = delete;
+  GpuCullOutput &operator=(const GpuCullOutput &) = delete;
+  ~GpuCullOutput() noexcept { release(); }
+
+  /// \brief Buffer of the counters and commands.
+  SDL_GPUBuffer *buffer() const { return m_commands.buffer(); }
+
+  /// \brief Counters of the last cull which was read back, i.e.
+  /// \ref kReadbackFrames culls ago.
+  const GpuCullStats &stats() const { return m_stats; }
+
+  void release() noexcept;
+
+private:
+  friend class GpuDrawList;
+  /// Grow the buffer for \p numDraws commands, and zero the counters.
+  void beginCull(CommandBuffer &command_buffer, Uint32 numDraws);
+  /// Copy the counters to the readback ring, and read those of an earlier
+  /// cull.
+  void endCull(CommandBuffer &command_buffer);
+
+  const Device *m_device;
+  InstanceBuffer m_commands;
+  SDL_GPUTransferBuffer *m_readback{nullptr};
+  /// Number of draws of the cull of each slot of the readback ring.
+  std::array<Uint32, kReadbackFrames> m_slotDraws{};
+  Uint64 m_numCulls = 0;
+  GpuCullStats m_stats;
+};
+
+/// \brief Draws of the views of a set of objects, culled on the GPU and
+/// submitted with indirect draws.
+///
+/// The draws are recorded on the CPU with addDraws(), then uploaded once per
+/// frame. For each pass, cull() runs a compute shader (`CullDraws.comp`)
+/// which tests the bounds of each draw, transformed by its object's model
+/// matrix from the ObjectBuffer, against the frustum of the pass and,
+/// optionally, against a HiZPyramid of the depths of an earlier frame
+/// (`CullDrawsOcclusion.comp`). It writes one indexed indirect draw command
+/// per draw, with one instance if the view is visible and none otherwise.
+/// draw() then issues one indirect draw call for each run of draws of meshes
+/// sharing their buffers: a single one when the meshes are allocated from a
+/// MeshArena.
+///
+/// The first instance of each command is the index of its draw, which the
+/// vertex shaders read through the instance-rate attributes, as the built-in
+/// instance index does not include it on all backends.
+///
+/// \warning Draws of non-indexed views are not culled, and are drawn one by
+/// one.
+class GpuDrawList {
+public:
+  /// Usage of the buffers of GpuCullOutput.
+  static constexpr SDL_GPUBufferUsageFlags kCommandBufferUsage =
+      SDL_GPU_BUFFERUSAGE_INDIRECT | SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_WRITE;
+  static constexpr Uint32 kCommandSize =
+      sizeof(SDL_GPUIndexedIndirectDrawCommand);
+
+  explicit GpuDrawList(const Device &device);
+  GpuDrawList(const GpuDrawList &) = delete;
+  GpuDrawList &operator=(const GpuDrawList &) = delete;
+  ~GpuDrawList() noexcept { release(); }
+
+  /// \brief Remove the draws, e.g. at the start of a frame.
+  void clear() {
+    m_records.clear();
+    m_batches.clear();
+  }
+
+  /// \brief Record a draw of each view of \p mesh, at full detail.
+  /// \param object Index of the object in the ObjectBuffer.
+  /// \param firstMaterial Index of the material of the first view, as given
+  /// by ObjectBuffer::materialIndex(). Views use consecutive materials.
+  /// \warning The Mesh must outlive the draws, until the next clear().
+  void addDraws(const Mesh &mesh, Uint32 object, Uint32 firstMaterial);
+
+  Uint32 size() const { return Uint32(m_records.size()); }
+  bool empty() const { return m_records.empty(); }
+  /// \brief Number of runs of draws sharing their buffers, i.e. of indirect
+  /// draw calls of draw().
+  Uint32 numBatches() const { return Uint32(m_batches.size()); }
+
+  /// \brief Upload the draw records.
+  /// \warning This records a copy pass: call it outside of render passes.
+  void upload(CommandBuffer &command_buffer);
+
+  /// \brief Cull the draws against \p frustum with a compute pass, and write
+  /// their commands to \p output.
+  /// \param occlusion If given and built, draws hidden behind its depths are
+  /// culled too. Its depths are those of an earlier frame: objects which
+  /// were hidden then, and are not anymore, show up one frame late.
+  /// \param receivers If given, draws whose bounds, extruded along the light
+  /// rays, miss the receiver volume are culled too, as shadow casters.
+  /// \warning Call it outside of render passes, after upload() and the
+  /// upload of \p objects.
+  void cull(CommandBuffer &command_buffer, const ObjectBuffer &objects,
+            const FrustumPlanes &frustum, GpuCullOutput &output,
+            const HiZPyramid *occlusion = nullptr,
+            const ShadowReceiverVolume *receivers = nullptr) const;
+
+  /// \brief Draw the views, from the commands written to \p output by
+  /// cull().
+  /// \param instanceSlot Vertex buffer slot of the draw records in the
+  /// pipeline's drawRecordLayout(), i.e. the number of bindings of the mesh
+  /// layout.
+  /// \param positionsOnly Bind the position-only streams of the meshes.
+  /// \returns The number of draw calls.
+  Uint32 draw(SDL_GPURenderPass *pass, const GpuCullOutput &output,
+              Uint32 instanceSlot, bool positionsOnly = false) const;
+
+  void release() noexcept;
+
+private:
+  /// A run of consecutive draws whose meshes share their buffers.
+  struct Batch {
+    const Mesh *mesh;
+    Uint32 first;
+    Uint32 count;
+    bool indexed;
+  };
+
+  const Device *m_device;
+  SDL_GPUComputePipeline *m_pipeline{nullptr};
+  SDL_GPUComputePipeline *m_occlusionPipeline{nullptr};
+  std::vector<GpuDrawRecord> m_records;
+  std::vector<Batch> m_batches;
+  InstanceBuffer m_recordBuffer;
+};
+
+} // namespace candlewick
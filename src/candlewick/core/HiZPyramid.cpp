@@ -0,0 +1,128 @@
+#include "HiZPyramid.h"
+#include "CommandBuffer.h"
+#include "Device.h"
+#include "Shader.h"
+
+#include <algorithm>
+
+namespace candlewick {
+
+/// Uniforms of `HiZDownsample.comp`.
+struct HiZLevelUniforms {
+  Uint32 srcSize[2];
+  Uint32 dstSize[2];
+};
+
+/// Workgroup size of `HiZDownsample.comp`, in both dimensions.
+static constexpr Uint32 kHiZGroupSize = 8;
+
+static SDL_GPUTextureCreateInfo hizTextureInfo(Uint32 width, Uint32 height,
+                                               Uint32 num_levels,
+                                               SDL_GPUTextureUsageFlags usage) {
+  return {
+      .type = SDL_GPU_TEXTURETYPE_2D,
+      .format = SDL_GPU_TEXTUREFORMAT_R32_FLOAT,
+      .usage = usage,
+      .width = width,
+      .height = height,
+      .layer_count_or_depth = 1,
+      .num_levels = num_levels,
+      .sample_count = SDL_GPU_SAMPLECOUNT_1,
+      .props = 0,
+  };
+}
+
+HiZPyramid::HiZPyramid(const Device &device, Uint32 width, Uint32 height)
+    : m_device(&device), m_depthWidth(width), m_depthHeight(height) {
+  m_pipeline = createComputePipeline(device, "HiZDownsample.comp");
+
+  Uint32 w = std::max(width / 2, 1u);
+  Uint32 h = std::max(height / 2, 1u);
+  const Uint32 baseWidth = w, baseHeight = h;
+  const SDL_GPUTextureUsageFlags levelUsage =
+      SDL_GPU_TEXTUREUSAGE_SAMPLER | SDL_GPU_TEXTUREUSAGE_COMPUTE_STORAGE_WRITE;
+  while (true) {
+    m_levels.emplace_back(device, hizTextureInfo(w, h, 1, levelUsage),
+                          "Hi-Z level");
+    if (w == 1 && h == 1)
+      break;
+    w = std::max(w / 2, 1u);
+    h = std::max(h / 2, 1u);
+  }
+  m_pyramid = Texture{device,
+                      hizTextureInfo(baseWidth, baseHeight, numLevels(),
+                                     SDL_GPU_TEXTUREUSAGE_SAMPLER),
+                      "Hi-Z pyramid"};
+
+  SDL_GPUSamplerCreateInfo sampler_desc{
+      .min_filter = SDL_GPU_FILTER_NEAREST,
+      .mag_filter = SDL_GPU_FILTER_NEAREST,
+      .mipmap_mode = SDL_GPU_SAMPLERMIPMAPMODE_NEAREST,
+      .address_mode_u = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE,
+      .address_mode_v = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE,
+      .address_mode_w = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE,
+  };
+  m_sampler = SDL_CreateGPUSampler(device, &sampler_desc);
+}
+
+void HiZPyramid::build(CommandBuffer &command_buffer,
+                       SDL_GPUTexture *depth_texture, const Mat4f &viewProj) {
+  SDL_GPUTexture *src = depth_texture;
+  Uint32 srcWidth = m_depthWidth, srcHeight = m_depthHeight;
+  for (const Texture &level : m_levels) {
+    SDL_GPUStorageTextureReadWriteBinding target{
+        .texture = level,
+        .mip_level = 0,
+        .layer = 0,
+        .cycle = true,
+    };
+    SDL_GPUComputePass *pass =
+        SDL_BeginGPUComputePass(command_buffer, &target, 1, nullptr, 0);
+    SDL_BindGPUComputePipeline(pass, m_pipeline);
+    const SDL_GPUTextureSamplerBinding source{
+        .texture = src,
+        .sampler = m_sampler,
+    };
+    SDL_BindGPUComputeSamplers(pass, 0, &source, 1);
+    const HiZLevelUniforms ubo{{srcWidth, srcHeight},
+                               {level.width(), level.height()}};
+    command_buffer.pushComputeUniform(0, &ubo, sizeof(ubo));
+    SDL_DispatchGPUCompute(
+        pass, (level.width() + kHiZGroupSize - 1) / kHiZGroupSize,
+        (level.height() + kHiZGroupSize - 1) / kHiZGroupSize, 1);
+    SDL_EndGPUComputePass(pass);
+    src = level;
+    srcWidth = level.width();
+    srcHeight = level.height();
+  }
+
+  // gather the levels into the mip chain read by the culling
+  SDL_GPUCopyPass *copy_pass = SDL_BeginGPUCopyPass(command_buffer);
+  for (Uint32 i = 0; i < numLevels(); i++) {
+    const Texture &level = m_levels[i];
+    const SDL_GPUTextureLocation from{.texture = level};
+    const SDL_GPUTextureLocation to{.texture = m_pyramid, .mip_level = i};
+    // cycle the pyramid once, before writing its first level
+    SDL_CopyGPUTextureToTexture(copy_pass, &from, &to, level.width(),
+                                level.height(), 1, i == 0);
+  }
+  SDL_EndGPUCopyPass(copy_pass);
+  m_viewProj = viewProj;
+  m_ready = true;
+}
+
+void HiZPyramid::release() noexcept {
+  m_levels.clear();
+  m_pyramid.destroy();
+  if (m_sampler) {
+    SDL_ReleaseGPUSampler(*m_device, m_sampler);
+    m_sampler = nullptr;
+  }
+  if (m_pipeline) {
+    SDL_ReleaseGPUComputePipeline(*m_device, m_pipeline);
+    m_pipeline = nullptr;
+  }
+  m_ready = false;
+}
+
+} // namespace candlewick
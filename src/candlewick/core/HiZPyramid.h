@@ -0,0 +1,74 @@
+#pragma once
+
+#include "Core.h"
+#include "Texture.h"
+#include "math_types.h"
+
+#include <SDL3/SDL_gpu.h>
+#include <vector>
+
+namespace candlewick {
+
+/// \brief Hierarchical-Z pyramid of a depth texture, used to cull objects
+/// hidden behind the depths of an earlier frame.
+///
+/// Each level holds, for each texel, the farthest depth of the texels of the
+/// previous level it covers. Level \f$ k \f$ is the size of the depth texture
+/// divided by \f$ 2^{k+1} \f$, rounded down, and the last row and column of
+/// each level also cover the leftover texels: the culling addresses the texels
+/// from depth texture coordinates, rather than normalized ones.
+/// The levels are built with a compute shader (`HiZDownsample.comp`), one
+/// compute pass per level, into scratch textures which are then copied into
+/// the mip chain of texture(): a texture cannot be both sampled and written
+/// within a compute pass.
+///
+/// An object whose bounds, projected with viewProj(), are behind the
+/// farthest depth of the pyramid texels they cover is hidden.
+/// \sa GpuDrawList::cull()
+class HiZPyramid {
+public:
+  /// \param width Width of the depth textures the pyramid is built from.
+  /// \param height Height of the depth textures.
+  HiZPyramid(const Device &device, Uint32 width, Uint32 height);
+  HiZPyramid(const HiZPyramid &) = delete;
+  HiZPyramid &operator=(const HiZPyramid &) = delete;
+  ~HiZPyramid() noexcept { release(); }
+
+  /// \brief Build the pyramid of \p depth_texture, rendered with the
+  /// view-projection matrix \p viewProj.
+  /// \warning Call it outside of render passes.
+  void build(CommandBuffer &command_buffer, SDL_GPUTexture *depth_texture,
+             const Mat4f &viewProj);
+
+  /// \brief Whether the pyramid was built, and can be tested against.
+  bool ready() const { return m_ready; }
+
+  /// \brief Mip chain of the pyramid, in \c R32_FLOAT.
+  SDL_GPUTexture *texture() const { return m_pyramid; }
+  /// \brief Nearest-neighbor sampler, for texture().
+  SDL_GPUSampler *sampler() const { return m_sampler; }
+  Uint32 width() const { return m_pyramid.width(); }
+  Uint32 height() const { return m_pyramid.height(); }
+  Uint32 numLevels() const { return Uint32(m_levels.size()); }
+  /// \brief Size of the depth textures the pyramid is built from.
+  Uint32 depthWidth() const { return m_depthWidth; }
+  Uint32 depthHeight() const { return m_depthHeight; }
+  /// \brief View-projection matrix of the depths of the pyramid.
+  const Mat4f &viewProj() const { return m_viewProj; }
+
+  void release() noexcept;
+
+private:
+  const Device *m_device;
+  SDL_GPUComputePipeline *m_pipeline{nullptr};
+  SDL_GPUSampler *m_sampler{nullptr};
+  Uint32 m_depthWidth;
+  Uint32 m_depthHeight;
+  /// Scratch textures written by the compute passes, one per level.
+  std::vector<Texture> m_levels;
+  Texture m_pyramid{NoInit};
+  Mat4f m_viewProj = Mat4f::Identity();
+  bool m_ready = false;
+};
+
+} // namespace candlewick
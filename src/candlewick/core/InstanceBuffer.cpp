@@ -0,0 +1,75 @@
+#include "InstanceBuffer.h"
+#include "CommandBuffer.h"
+#include "Device.h"
+#include "UploadRing.h"
+#include "errors.h"
+
+#include <algorithm>
+#include <bit>
+
+namespace candlewick {
+
+InstanceBuffer::InstanceBuffer(const Device &device,
+                               SDL_GPUBufferUsageFlags usage)
+    : m_device(&device), m_usage(usage) {}
+
+void InstanceBuffer::reserve(Uint32 size) {
+  if (size <= m_capacity)
+    return;
+  // released once the frames in flight are done with it
+  release();
+  m_capacity = std::bit_ceil(std::max(size, 4096u));
+  SDL_GPUBufferCreateInfo info{
+      .usage = m_usage,
+      .size = m_capacity,
+      .props = 0,
+  };
+  m_buffer = SDL_CreateGPUBuffer(*m_device, &info);
+  if (!m_buffer) {
+    m_capacity = 0;
+    throw RAIIException(SDL_GetError());
+  }
+}
+
+void InstanceBuffer::upload(
+    CommandBuffer &command_buffer,
+    std::initializer_list<std::span<const std::byte>> chunks) {
+  Uint32 size = 0;
+  for (auto chunk : chunks)
+    size += Uint32(chunk.size());
+  if (size == 0)
+    return;
+  reserve(size);
+
+  UploadRing &ring = m_device->uploadRing();
+  StagingAllocation staging = ring.allocate(command_buffer, size);
+  std::byte *dst = staging.data;
+  for (auto chunk : chunks) {
+    SDL_memcpy(dst, chunk.data(), chunk.size());
+    dst += chunk.size();
+  }
+  ring.unmap(staging);
+
+  SDL_GPUCopyPass *copy_pass = SDL_BeginGPUCopyPass(command_buffer);
+  SDL_GPUTransferBufferLocation src_location{
+      .transfer_buffer = staging.buffer,
+      .offset = staging.offset,
+  };
+  SDL_GPUBufferRegion dst_region{
+      .buffer = m_buffer,
+      .offset = 0,
+      .size = size,
+  };
+  SDL_UploadToGPUBuffer(copy_pass, &src_location, &dst_region, true);
+  SDL_EndGPUCopyPass(copy_pass);
+}
+
+void InstanceBuffer::release() noexcept {
+  if (m_buffer) {
+    SDL_ReleaseGPUBuffer(*m_device, m_buffer);
+    m_buffer = nullptr;
+    m_capacity = 0;
+  }
+}
+
+} // namespace candlewick
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "Core.h"
+#include <SDL3/SDL_gpu.h>
+
+#include <cstddef>
+#include <initializer_list>
+#include <span>
+
+namespace candlewick {
+
+/// \brief GPU storage buffer of per-instance data (e.g. model matrices),
+/// rewritten each frame and read by the vertex shaders of instanced draws.
+///
+/// The data is staged through the Device's UploadRing, and the buffer is
+/// cycled on each upload, so that frames in flight keep reading their own
+/// contents. The buffer grows as needed, and never shrinks.
+///
+/// Other usages can be requested, e.g. to also read the buffer from compute
+/// shaders, or to write indirect draw commands to it with a compute pass.
+class InstanceBuffer {
+public:
+  explicit InstanceBuffer(const Device &device,
+                          SDL_GPUBufferUsageFlags usage =
+                              SDL_GPU_BUFFERUSAGE_GRAPHICS_STORAGE_READ);
+  InstanceBuffer(const InstanceBuffer &) = delete;
+  InstanceBuffer &operator=(const InstanceBuffer &) = delete;
+  ~InstanceBuffer() noexcept { release(); }
+
+  /// \brief Upload \p data to the start of the buffer.
+  /// \warning This records a copy pass: call it outside of render passes.
+  void upload(CommandBuffer &command_buffer, std::span<const std::byte> data) {
+    upload(command_buffer, {data});
+  }
+
+  /// \brief Upload the concatenation of \p chunks to the start of the
+  /// buffer, with a single copy.
+  void upload(CommandBuffer &command_buffer,
+              std::initializer_list<std::span<const std::byte>> chunks);
+
+  template <typename T>
+  void upload(CommandBuffer &command_buffer, std::span<T> data) {
+    upload(command_buffer, std::as_bytes(data));
+  }
+
+  /// \brief Grow the buffer to at least \p size bytes. The contents are lost
+  /// if it grows.
+  void reserve(Uint32 size);
+
+  /// \brief Bind the buffer to a vertex shader storage buffer slot.
+  void bindVertex(SDL_GPURenderPass *pass, Uint32 slot = 0) const {
+    SDL_BindGPUVertexStorageBuffers(pass, slot, &m_buffer, 1);
+  }
+
+  /// \brief Bind the buffer to a fragment shader storage buffer slot.
+  void bindFragment(SDL_GPURenderPass *pass, Uint32 slot = 0) const {
+    SDL_BindGPUFragmentStorageBuffers(pass, slot, &m_buffer, 1);
+  }
+
+  /// \brief Bind the buffer to a read-only compute storage buffer slot.
+  void bindCompute(SDL_GPUComputePass *pass, Uint32 slot = 0) const {
+    SDL_BindGPUComputeStorageBuffers(pass, slot, &m_buffer, 1);
+  }
+
+  SDL_GPUBuffer *buffer() const { return m_buffer; }
+  Uint32 capacity() const { return m_capacity; }
+
+  void release() noexcept;
+
+private:
+  const Device *m_device;
+  SDL_GPUBufferUsageFlags m_usage;
+  SDL_GPUBuffer *m_buffer{nullptr};
+  Uint32 m_capacity{0};
+};
+
+} // namespace candlewick
@@ -1,6 +1,7 @@
 #include "Mesh.h"
 
 #include "Device.h"
+#include "MeshArena.h"
 #include "MeshLayout.h"
 #include "./errors.h"
 
@@ -12,6 +13,8 @@ MeshView::MeshView(const MeshView &parent, Uint32 subVertexOffset,
                    Uint32 subVertexCount, Uint32 subIndexOffset,
                    Uint32 subIndexCount)
     : vertexBuffers(parent.vertexBuffers), indexBuffer(parent.indexBuffer),
+      indexElementSize(parent.indexElementSize),
+      positionBuffer(parent.positionBuffer),
       vertexOffset(parent.vertexOffset + subVertexOffset),
       vertexCount(subVertexCount),
       indexOffset(parent.indexOffset + subIndexOffset),
@@ -32,32 +35,53 @@ Mesh::Mesh(const Device &device, const MeshLayout &layout)
 
 Mesh::Mesh(Mesh &&other) noexcept
     : m_device(other.m_device), m_views(std::move(other.m_views)),
-      m_layout(other.m_layout), vertexCount(other.vertexCount),
+      m_layout(other.m_layout), m_shared(std::move(other.m_shared)),
+      m_arena(std::move(other.m_arena)),
+      m_arenaVertexOffset(other.m_arenaVertexOffset),
+      m_arenaIndexOffset(other.m_arenaIndexOffset),
+      m_lods(std::move(other.m_lods)),
+      m_meshlets(std::move(other.m_meshlets)),
+      m_viewBounds(std::move(other.m_viewBounds)), m_bounds(other.m_bounds),
+      vertexCount(other.vertexCount),
       indexCount(other.indexCount),
       vertexBuffers(std::move(other.vertexBuffers)),
-      indexBuffer(other.indexBuffer) {
+      indexBuffer(other.indexBuffer),
+      indexElementSize(other.indexElementSize),
+      positionBuffer(other.positionBuffer),
+      positionDequant(other.positionDequant) {
   other.m_device = nullptr;
   other.indexBuffer = nullptr;
+  other.positionBuffer = nullptr;
 }
 
 Mesh &Mesh::operator=(Mesh &&other) noexcept {
   if (this != &other) {
-    if (m_device) {
-      release();
-    }
+    release();
 
     m_device = other.m_device;
     m_views = std::move(other.m_views);
     m_layout = std::move(other.m_layout);
+    m_shared = std::move(other.m_shared);
+    m_arena = std::move(other.m_arena);
+    m_arenaVertexOffset = other.m_arenaVertexOffset;
+    m_arenaIndexOffset = other.m_arenaIndexOffset;
+    m_lods = std::move(other.m_lods);
+    m_meshlets = std::move(other.m_meshlets);
+    m_viewBounds = std::move(other.m_viewBounds);
+    m_bounds = other.m_bounds;
     vertexCount = std::move(other.vertexCount);
     indexCount = std::move(other.indexCount);
     vertexBuffers = std::move(other.vertexBuffers);
     indexBuffer = std::move(other.indexBuffer);
+    indexElementSize = other.indexElementSize;
+    positionBuffer = other.positionBuffer;
+    positionDequant = other.positionDequant;
 
     other.m_device = nullptr;
     other.vertexCount = 0u;
     other.indexCount = 0u;
     other.indexBuffer = nullptr;
+    other.positionBuffer = nullptr;
   }
   return *this;
 }
@@ -76,12 +100,68 @@ Mesh &Mesh::bindVertexBuffer(Uint32 slot, SDL_GPUBuffer *buffer) {
   terminate_with_message("Binding slot not found!");
 }
 
+Mesh &Mesh::createPositionStream() {
+  assert(!isShared() && !isArenaAllocated());
+  if (positionBuffer)
+    return *this;
+  const MeshLayout layout = positionStreamLayout(m_layout);
+  SDL_GPUBufferCreateInfo info{.usage = SDL_GPU_BUFFERUSAGE_VERTEX,
+                               .size = layout.vertexSize() * vertexCount,
+                               .props = 0};
+  positionBuffer = SDL_CreateGPUBuffer(m_device, &info);
+  if (!positionBuffer)
+    throw RAIIException(SDL_GetError());
+  for (MeshView &view : m_views)
+    view.positionBuffer = positionBuffer;
+  for (LodLevel &lod : m_lods) {
+    for (MeshView &view : lod.views)
+      view.positionBuffer = positionBuffer;
+  }
+  return *this;
+}
+
 Mesh &Mesh::setIndexBuffer(SDL_GPUBuffer *buffer) {
   indexBuffer = buffer;
   return *this;
 }
 
+Mesh Mesh::share(std::shared_ptr<const Mesh> mesh) {
+  assert(mesh);
+  Mesh out{NoInit};
+  out.m_views = mesh->m_views;
+  out.m_lods = mesh->m_lods;
+  out.m_meshlets = mesh->m_meshlets;
+  out.m_viewBounds = mesh->m_viewBounds;
+  out.m_bounds = mesh->m_bounds;
+  out.m_layout = mesh->m_layout;
+  out.vertexCount = mesh->vertexCount;
+  out.indexCount = mesh->indexCount;
+  out.vertexBuffers = mesh->vertexBuffers;
+  out.indexBuffer = mesh->indexBuffer;
+  out.indexElementSize = mesh->indexElementSize;
+  out.positionBuffer = mesh->positionBuffer;
+  out.positionDequant = mesh->positionDequant;
+  out.m_shared = std::move(mesh);
+  return out;
+}
+
 void Mesh::release() noexcept {
+  if (m_shared) {
+    m_shared.reset();
+    vertexBuffers.clear();
+    indexBuffer = nullptr;
+    positionBuffer = nullptr;
+    return;
+  }
+  if (m_arena) {
+    m_arena->free(m_arenaVertexOffset, vertexCount, m_arenaIndexOffset,
+                  indexCount);
+    m_arena.reset();
+    vertexBuffers.clear();
+    indexBuffer = nullptr;
+    positionBuffer = nullptr;
+    return;
+  }
   if (!m_device)
     return;
 
@@ -95,6 +175,10 @@ void Mesh::release() noexcept {
     SDL_ReleaseGPUBuffer(m_device, indexBuffer);
     indexBuffer = nullptr;
   }
+  if (positionBuffer) {
+    SDL_ReleaseGPUBuffer(m_device, positionBuffer);
+    positionBuffer = nullptr;
+  }
 }
 
 MeshView &Mesh::addView(Uint32 vertexOffset, Uint32 vertexSubCount,
@@ -102,12 +186,94 @@ MeshView &Mesh::addView(Uint32 vertexOffset, Uint32 vertexSubCount,
   MeshView v;
   v.vertexBuffers = vertexBuffers;
   v.indexBuffer = indexBuffer;
-  v.vertexOffset = vertexOffset;
+  v.indexElementSize = indexElementSize;
+  v.positionBuffer = positionBuffer;
+  v.vertexOffset = m_arenaVertexOffset + vertexOffset;
   v.vertexCount = vertexSubCount;
-  v.indexOffset = indexOffset;
+  v.indexOffset = m_arenaIndexOffset + indexOffset;
   v.indexCount = indexSubCount;
 
   return m_views.emplace_back(std::move(v));
 }
 
+Uint32 Mesh::addLod(float error) {
+  std::vector<MeshView> views = m_lods.empty() ? m_views : m_lods.back().views;
+  m_lods.push_back({error, std::move(views)});
+  return Uint32(m_lods.size());
+}
+
+MeshView &Mesh::setLodView(size_t i, Uint32 indexOffset,
+                           Uint32 indexSubCount) {
+  assert(!m_lods.empty());
+  MeshView &v = m_lods.back().views[i];
+  v.indexOffset = m_arenaIndexOffset + indexOffset;
+  v.indexCount = indexSubCount;
+  return v;
+}
+
+void Mesh::setMeshlets(size_t i, std::span<const Meshlet> meshlets) {
+  assert(i < m_views.size());
+  m_meshlets.resize(m_views.size());
+  const MeshView &view = m_views[i];
+  auto &out = m_meshlets[i];
+  out.assign(meshlets.begin(), meshlets.end());
+  for (Meshlet &m : out) {
+    assert(m.indexOffset + m.indexCount <= view.indexCount);
+    m.indexOffset += view.indexOffset;
+  }
+}
+
+void Mesh::setViewBounds(size_t i, const AABBf &box) {
+  assert(i < m_views.size());
+  m_viewBounds.resize(m_views.size());
+  m_viewBounds[i] = box;
+  m_bounds.extend(box);
+}
+
+Uint32 cullMeshlets(std::span<const Meshlet> meshlets,
+                    const FrustumPlanes &frustum, const Float3 *cameraPos,
+                    std::vector<std::pair<Uint32, Uint32>> &runs) {
+  runs.clear();
+  Uint32 numVisible = 0;
+  for (const Meshlet &m : meshlets) {
+    if (!frustum.intersectsSphere(m.center, m.radius))
+      continue;
+    if (cameraPos && isMeshletBackfacing(m, *cameraPos))
+      continue;
+    numVisible++;
+    // meshlets are stored in index order: extend the current run if they are
+    // adjacent
+    if (!runs.empty() &&
+        runs.back().first + runs.back().second == m.indexOffset)
+      runs.back().second += m.indexCount;
+    else
+      runs.emplace_back(m.indexOffset, m.indexCount);
+  }
+  return numVisible;
+}
+
+Uint32 selectLod(const Mesh &mesh, const Mat4f &viewProj, const Mat4f &model,
+                 float viewportHeight, float pixelError) {
+  if (mesh.numLods() == 1 || pixelError <= 0.f)
+    return 0u;
+  // clip-space w of the model origin: its depth for a perspective projection,
+  // 1 for an orthographic one
+  const float w = viewProj.row(3).dot(model.col(3));
+  if (w <= 0.f)
+    return 0u;
+  // for a rigid view matrix, the norm of this row is the projection's vertical
+  // scale factor P(1, 1)
+  const float projScale = viewProj.row(1).head<3>().norm();
+  const float modelScale =
+      model.topLeftCorner<3, 3>().colwise().norm().maxCoeff();
+  const float pixelsPerUnit =
+      0.5f * viewportHeight * projScale * modelScale / w;
+
+  Uint32 level = 0;
+  while (level + 1 < mesh.numLods() &&
+         mesh.lodError(level + 1) * pixelsPerUnit <= pixelError)
+    level++;
+  return level;
+}
+
 } // namespace candlewick
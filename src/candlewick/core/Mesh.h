@@ -3,9 +3,11 @@
 #include "Core.h"
 #include "Tags.h"
 #include "MeshLayout.h"
+#include "Meshlet.h"
 
 #include <vector>
 #include <span>
+#include <memory>
 #include <SDL3/SDL_assert.h>
 #include <entt/entity/registry.hpp>
 #include <entt/entity/handle.hpp>
@@ -28,6 +30,10 @@ public:
   std::vector<SDL_GPUBuffer *> vertexBuffers;
   /// Index buffer.
   SDL_GPUBuffer *indexBuffer;
+  /// Size of the elements of the index buffer.
+  SDL_GPUIndexElementSize indexElementSize;
+  /// Position-only vertex stream, if any. \sa Mesh::positionBuffer
+  SDL_GPUBuffer *positionBuffer{nullptr};
 
   /// Vertex offsets, expressed in elements.
   Uint32 vertexOffset;
@@ -51,13 +57,37 @@ public:
 /// This class contains the layout, vertex (and index) count(s), and handles to
 /// the GPU vertex and index buffers the Mesh references.
 ///
-/// A Mesh **owns** its vertex and index buffers.
+/// A Mesh **owns** its vertex and index buffers, unless it was created through
+/// Mesh::share(), in which case it holds a reference to a shared Mesh which
+/// owns them, or allocated from a MeshArena, in which case it owns a range of
+/// the arena's buffers.
 ///
 /// \sa MeshView
+/// \sa MeshArena
 class Mesh {
+  friend class MeshArena;
   SDL_GPUDevice *m_device{nullptr};
   std::vector<MeshView> m_views;
   MeshLayout m_layout;
+  /// Reference-counted owner of the buffers, for shared meshes.
+  std::shared_ptr<const Mesh> m_shared;
+  /// Arena the mesh was allocated from, if any.
+  std::shared_ptr<MeshArena> m_arena;
+  /// Start of the mesh's vertex range in the arena buffers.
+  Uint32 m_arenaVertexOffset{0u};
+  /// Start of the mesh's index range in the arena index buffer.
+  Uint32 m_arenaIndexOffset{0u};
+  /// A coarser level of detail, with one view per view of the Mesh.
+  struct LodLevel {
+    float error;
+    std::vector<MeshView> views;
+  };
+  std::vector<LodLevel> m_lods;
+  /// Meshlets of each view of the full-detail level, if any.
+  std::vector<std::vector<Meshlet>> m_meshlets;
+  /// Bounds of the vertex positions of each view.
+  std::vector<AABBf> m_viewBounds;
+  AABBf m_bounds;
 
 public:
   Uint32 vertexCount;
@@ -77,6 +107,22 @@ public:
   /// commands are issued.
   SDL_GPUBuffer *indexBuffer{nullptr};
 
+  /// Size of the elements of the index buffer. Meshes are indexed using 16-bit
+  /// integers when their vertex count allows it.
+  SDL_GPUIndexElementSize indexElementSize{SDL_GPU_INDEXELEMENTSIZE_32BIT};
+
+  /// Optional vertex buffer with a copy of the vertex positions, tightly
+  /// packed, with the layout positionStreamLayout(). Depth-only passes bind it
+  /// instead of the full interleaved vertices, which cuts their vertex fetch
+  /// bandwidth. It is indexed like the vertex buffers.
+  /// \sa createPositionStream()
+  SDL_GPUBuffer *positionBuffer{nullptr};
+
+  /// Transform from the stored to the actual vertex positions, to be
+  /// multiplied into the model matrix when drawing meshes with quantized
+  /// positions. \sa PositionQuantization
+  Mat4f positionDequant = Mat4f::Identity();
+
   explicit Mesh(const Device &device, const MeshLayout &layout);
 
   const MeshLayout &layout() const { return m_layout; }
@@ -88,16 +134,109 @@ public:
   Mesh &operator=(const Mesh &) = delete;
   Mesh &operator=(Mesh &&other) noexcept;
 
+  /// \brief Create a Mesh which references the buffers and views of a
+  /// reference-counted Mesh.
+  ///
+  /// The returned Mesh does not own the buffers: they are released along with
+  /// the referenced Mesh, when its last reference is dropped.
+  [[nodiscard]] static Mesh share(std::shared_ptr<const Mesh> mesh);
+
+  /// \brief Whether the buffers are owned by another, shared Mesh.
+  bool isShared() const { return m_shared != nullptr; }
+
+  /// \brief Whether the buffers belong to a MeshArena.
+  bool isArenaAllocated() const { return m_arena != nullptr; }
+
+  /// \brief Offset of the Mesh's vertices in its vertex buffers, in elements.
+  /// Nonzero only for arena-allocated meshes.
+  Uint32 baseVertex() const { return m_arenaVertexOffset; }
+  /// \brief Offset of the Mesh's indices in its index buffer, in elements.
+  /// Nonzero only for arena-allocated meshes.
+  Uint32 baseIndex() const { return m_arenaIndexOffset; }
+
   const MeshView &view(size_t i) const { return m_views[i]; }
   std::span<const MeshView> views() const { return m_views; }
   size_t numViews() const { return m_views.size(); }
 
   /// \brief Add a stored MeshView object. The added view will be drawn when
   /// calling Renderer::draw() with a Mesh argument.
+  ///
+  /// For an arena-allocated Mesh, the offsets are relative to the Mesh's range
+  /// in the arena buffers.
   /// \returns Reference to the created MeshView object.
   MeshView &addView(Uint32 vertexOffset, Uint32 vertexSubCount,
                     Uint32 indexOffset, Uint32 indexSubCount);
 
+  /// \brief Number of levels of detail, including the full-detail level 0.
+  Uint32 numLods() const { return Uint32(m_lods.size()) + 1; }
+
+  /// \brief Views of a level of detail, one for each view of the Mesh. Level 0
+  /// returns views().
+  std::span<const MeshView> lodViews(Uint32 level) const {
+    return level == 0 ? std::span{m_views} : std::span{m_lods[level - 1].views};
+  }
+
+  /// \brief Simplification error of a level of detail, in the units of the
+  /// dequantized vertex positions. \sa MeshLod
+  float lodError(Uint32 level) const {
+    return level == 0 ? 0.f : m_lods[level - 1].error;
+  }
+
+  /// \brief Add a coarser level of detail. Its views start out as copies of
+  /// the views of the previous level, and are then set with setLodView().
+  /// \returns The index of the new level.
+  Uint32 addLod(float error);
+
+  /// \brief Set the index range of the \p i-th view of the coarsest level of
+  /// detail. The view keeps the vertex range of the \p i-th view of the Mesh.
+  ///
+  /// As for addView(), the offset is relative to the Mesh's range in the arena
+  /// buffers for an arena-allocated Mesh.
+  MeshView &setLodView(size_t i, Uint32 indexOffset, Uint32 indexSubCount);
+
+  /// \brief Bounds of the vertex positions of the Mesh, as stored: map them
+  /// through \ref positionDequant to the model frame. Empty if unknown, e.g.
+  /// for meshes created without MeshData.
+  const AABBf &bounds() const { return m_bounds; }
+
+  /// \brief Bounds of the vertex positions of the \p i-th view, used to cull
+  /// the views of batched meshes separately. \sa bounds()
+  AABBf viewBounds(size_t i) const {
+    return i < m_viewBounds.size() ? m_viewBounds[i] : AABBf{};
+  }
+
+  /// \brief Set the bounds of the \p i-th view, and extend those of the Mesh.
+  void setViewBounds(size_t i, const AABBf &box);
+
+  /// \brief Whether the full-detail views were partitioned into meshlets.
+  bool hasMeshlets() const { return !m_meshlets.empty(); }
+
+  /// \brief Meshlets of the \p i-th view, whose index offsets are in elements
+  /// of the whole index buffer, like MeshView::indexOffset. Empty if the view
+  /// has no meshlets.
+  std::span<const Meshlet> meshlets(size_t i) const {
+    return i < m_meshlets.size() ? std::span{m_meshlets[i]}
+                                 : std::span<const Meshlet>{};
+  }
+
+  /// \brief Set the meshlets of the \p i-th view, with index offsets relative
+  /// to that view.
+  void setMeshlets(size_t i, std::span<const Meshlet> meshlets);
+
+  /// \brief Drop the meshlets of all views, e.g. once the vertices they bound
+  /// were rewritten. The views are then culled as a whole.
+  void clearMeshlets() { m_meshlets.clear(); }
+
+  /// \brief Create the position-only vertex stream of the Mesh. Its contents
+  /// are uploaded along with the vertices by uploadMeshToDevice(), so this must
+  /// be called before uploading.
+  /// \warning Arena-allocated meshes get their position stream from the
+  /// MeshArena instead.
+  /// \sa positionBuffer
+  Mesh &createPositionStream();
+
+  bool hasPositionStream() const { return positionBuffer != nullptr; }
+
   /// \brief Bind an existing vertex buffer to a given slot of the Mesh.
   /// \warning This function will **take ownership of the buffer**.
   ///
@@ -126,6 +265,8 @@ public:
   bool isIndexed() const { return indexBuffer != nullptr; }
 
   /// \brief Release all owned vertex and index buffers in the Mesh object.
+  /// For a shared Mesh, this only drops the reference to the owner. For an
+  /// arena-allocated Mesh, this returns its range to the arena.
   void release() noexcept;
   ~Mesh() noexcept { release(); }
 
@@ -136,8 +277,44 @@ public:
   SDL_GPUBufferBinding getIndexBinding() const {
     return {.buffer = indexBuffer, .offset = 0u};
   }
+
+  /// \brief Size of an index element, in bytes.
+  Uint32 indexSize() const { return indexElementBytes(indexElementSize); }
 };
 
+/// \brief Select the level of detail of a Mesh to draw: the coarsest level
+/// whose simplification error, projected on the viewport, is at most
+/// \p pixelError pixels.
+///
+/// The projected size is evaluated at the origin of the model frame, which
+/// works for both perspective and orthographic projections.
+/// \param viewProj View-projection matrix of the render pass.
+/// \param model Model matrix, \b without the Mesh's positionDequant.
+/// \param viewportHeight Height of the render target, in pixels.
+/// \param pixelError Error threshold. If not positive, this returns 0.
+Uint32 selectLod(const Mesh &mesh, const Mat4f &viewProj, const Mat4f &model,
+                 float viewportHeight, float pixelError);
+
+/// \brief World-space bounds of a Mesh, on Mesh::bounds().
+/// \param model Model matrix, \b without the Mesh's positionDequant.
+inline AABBf worldBounds(const Mesh &mesh, const Mat4f &model) {
+  return transformBox(mesh.bounds(), model * mesh.positionDequant);
+}
+
+/// \brief Cull the meshlets of a view against a view frustum and, for a
+/// perspective camera, their normal cones, and gather the visible ones into
+/// runs of consecutive indices.
+/// \param frustum Frustum planes, in the frame of the meshlet bounds: that of
+/// the model matrix \b without the Mesh's positionDequant.
+/// \param cameraPos Camera position in the same frame, or null to skip the
+/// backface cone test (e.g. for orthographic projections).
+/// \param[out] runs Receives the visible index ranges, as (offset, count)
+/// pairs with offsets in elements of the whole index buffer.
+/// \returns The number of visible meshlets.
+Uint32 cullMeshlets(std::span<const Meshlet> meshlets,
+                    const FrustumPlanes &frustum, const Float3 *cameraPos,
+                    std::vector<std::pair<Uint32, Uint32>> &runs);
+
 /// \brief Check that all vertex buffers were set, and consistency in the
 /// "indexed/non-indexed" status.
 /// \sa validateMeshView()
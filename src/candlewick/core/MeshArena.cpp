@@ -0,0 +1,143 @@
+#include "MeshArena.h"
+#include "Device.h"
+#include "errors.h"
+
+#include <cassert>
+
+namespace candlewick {
+
+FreeListAllocator::FreeListAllocator(Uint32 capacity)
+    : m_capacity(capacity), m_freeCount(capacity) {
+  if (capacity > 0)
+    m_freeBlocks.emplace(0u, capacity);
+}
+
+std::optional<Uint32> FreeListAllocator::allocate(Uint32 count) {
+  if (count == 0)
+    return 0u;
+  for (auto it = m_freeBlocks.begin(); it != m_freeBlocks.end(); ++it) {
+    auto [offset, size] = *it;
+    if (size < count)
+      continue;
+    m_freeBlocks.erase(it);
+    if (size > count)
+      m_freeBlocks.emplace(offset + count, size - count);
+    m_freeCount -= count;
+    return offset;
+  }
+  return std::nullopt;
+}
+
+void FreeListAllocator::free(Uint32 offset, Uint32 count) {
+  if (count == 0)
+    return;
+  assert(offset + count <= m_capacity);
+  m_freeCount += count;
+  auto next = m_freeBlocks.lower_bound(offset);
+  assert(next == m_freeBlocks.end() || offset + count <= next->first);
+  // coalesce with the following block
+  if (next != m_freeBlocks.end() && offset + count == next->first) {
+    count += next->second;
+    next = m_freeBlocks.erase(next);
+  }
+  // coalesce with the preceding block
+  if (next != m_freeBlocks.begin()) {
+    auto prev = std::prev(next);
+    assert(prev->first + prev->second <= offset);
+    if (prev->first + prev->second == offset) {
+      prev->second += count;
+      return;
+    }
+  }
+  m_freeBlocks.emplace_hint(next, offset, count);
+}
+
+MeshArena::MeshArena(Private, const Device &device, const MeshLayout &layout,
+                     Uint32 vertexCapacity, Uint32 indexCapacity,
+                     SDL_GPUIndexElementSize indexElementSize,
+                     bool positionStream)
+    : m_device(device), m_layout(layout), m_indexElementSize(indexElementSize),
+      m_vertices(vertexCapacity), m_indices(indexCapacity) {
+  assert(validateMeshLayout(layout));
+  for (const auto &desc : m_layout.m_bufferDescs) {
+    SDL_GPUBufferCreateInfo info{.usage = SDL_GPU_BUFFERUSAGE_VERTEX,
+                                 .size = desc.pitch * vertexCapacity,
+                                 .props = 0};
+    SDL_GPUBuffer *buffer = SDL_CreateGPUBuffer(m_device, &info);
+    if (!buffer)
+      throw RAIIException(SDL_GetError());
+    m_vertexBuffers.push_back(buffer);
+  }
+  if (indexCapacity > 0) {
+    SDL_GPUBufferCreateInfo info{.usage = SDL_GPU_BUFFERUSAGE_INDEX,
+                                 .size = indexElementBytes(indexElementSize) *
+                                         indexCapacity,
+                                 .props = 0};
+    m_indexBuffer = SDL_CreateGPUBuffer(m_device, &info);
+    if (!m_indexBuffer)
+      throw RAIIException(SDL_GetError());
+  }
+  if (positionStream) {
+    SDL_GPUBufferCreateInfo info{
+        .usage = SDL_GPU_BUFFERUSAGE_VERTEX,
+        .size = positionStreamLayout(layout).vertexSize() * vertexCapacity,
+        .props = 0};
+    m_positionBuffer = SDL_CreateGPUBuffer(m_device, &info);
+    if (!m_positionBuffer)
+      throw RAIIException(SDL_GetError());
+  }
+}
+
+MeshArena::~MeshArena() noexcept {
+  for (auto *buffer : m_vertexBuffers)
+    SDL_ReleaseGPUBuffer(m_device, buffer);
+  if (m_indexBuffer)
+    SDL_ReleaseGPUBuffer(m_device, m_indexBuffer);
+  if (m_positionBuffer)
+    SDL_ReleaseGPUBuffer(m_device, m_positionBuffer);
+}
+
+std::shared_ptr<MeshArena> MeshArena::create(const Device &device,
+                                             const MeshLayout &layout,
+                                             Uint32 vertexCapacity,
+                                             Uint32 indexCapacity,
+                                             SDL_GPUIndexElementSize
+                                                 indexElementSize,
+                                             bool positionStream) {
+  return std::make_shared<MeshArena>(Private{}, device, layout, vertexCapacity,
+                                     indexCapacity, indexElementSize,
+                                     positionStream);
+}
+
+std::optional<Mesh> MeshArena::allocate(Uint32 vertexCount,
+                                        Uint32 indexCount) {
+  auto vertexOffset = m_vertices.allocate(vertexCount);
+  if (!vertexOffset)
+    return std::nullopt;
+  auto indexOffset = m_indices.allocate(indexCount);
+  if (!indexOffset) {
+    m_vertices.free(*vertexOffset, vertexCount);
+    return std::nullopt;
+  }
+
+  Mesh mesh{NoInit};
+  mesh.m_layout = m_layout;
+  mesh.vertexCount = vertexCount;
+  mesh.indexCount = indexCount;
+  mesh.vertexBuffers = m_vertexBuffers;
+  mesh.indexBuffer = indexCount > 0 ? m_indexBuffer : nullptr;
+  mesh.indexElementSize = m_indexElementSize;
+  mesh.positionBuffer = m_positionBuffer;
+  mesh.m_arena = shared_from_this();
+  mesh.m_arenaVertexOffset = *vertexOffset;
+  mesh.m_arenaIndexOffset = *indexOffset;
+  return mesh;
+}
+
+void MeshArena::free(Uint32 vertexOffset, Uint32 vertexCount,
+                     Uint32 indexOffset, Uint32 indexCount) noexcept {
+  m_vertices.free(vertexOffset, vertexCount);
+  m_indices.free(indexOffset, indexCount);
+}
+
+} // namespace candlewick
@@ -0,0 +1,111 @@
+#pragma once
+
+#include "Core.h"
+#include "Mesh.h"
+#include "MeshLayout.h"
+
+#include <map>
+#include <memory>
+#include <optional>
+#include <SDL3/SDL_gpu.h>
+
+namespace candlewick {
+
+/// \brief First-fit free-list allocator over a range of elements.
+///
+/// This only does the bookkeeping: it hands out offsets into a range of
+/// \c capacity elements, e.g. vertices or indices of a GPU buffer. Adjacent
+/// free blocks are coalesced on deallocation.
+class FreeListAllocator {
+public:
+  explicit FreeListAllocator(Uint32 capacity);
+
+  /// \brief Allocate a block of \p count contiguous elements.
+  /// \returns The offset of the block, or nothing if no free block is large
+  /// enough.
+  std::optional<Uint32> allocate(Uint32 count);
+
+  /// \brief Return a block to the free list.
+  void free(Uint32 offset, Uint32 count);
+
+  Uint32 capacity() const { return m_capacity; }
+  /// \brief Total number of free elements (not necessarily contiguous).
+  Uint32 freeCount() const { return m_freeCount; }
+  /// \brief Number of free blocks, i.e. a measure of fragmentation.
+  size_t numFreeBlocks() const { return m_freeBlocks.size(); }
+
+private:
+  Uint32 m_capacity;
+  Uint32 m_freeCount;
+  // offset -> size of each free block
+  std::map<Uint32, Uint32> m_freeBlocks;
+};
+
+/// \brief Shared vertex and index buffers for all meshes of a given MeshLayout.
+///
+/// Meshes allocated from the arena are views into one large vertex buffer (per
+/// binding slot) and one large index buffer, so that a render pass can bind
+/// the buffers once and then only issue draws for all of them.
+///
+/// Arena-allocated meshes hold a reference to their arena, which is released
+/// along with the last one of them.
+///
+/// \warning This class is not thread-safe.
+/// \sa createMesh(MeshArena &, const MeshData &, bool)
+class MeshArena : public std::enable_shared_from_this<MeshArena> {
+  struct Private {};
+
+public:
+  MeshArena(Private, const Device &device, const MeshLayout &layout,
+            Uint32 vertexCapacity, Uint32 indexCapacity,
+            SDL_GPUIndexElementSize indexElementSize, bool positionStream);
+  MeshArena(const MeshArena &) = delete;
+  MeshArena &operator=(const MeshArena &) = delete;
+  ~MeshArena() noexcept;
+
+  /// \brief Create an arena with room for \p vertexCapacity vertices and
+  /// \p indexCapacity indices of size \p indexElementSize.
+  /// \param positionStream Whether the arena also holds a position-only
+  /// vertex stream, shared by the allocated meshes. \sa Mesh::positionBuffer
+  [[nodiscard]] static std::shared_ptr<MeshArena>
+  create(const Device &device, const MeshLayout &layout,
+         Uint32 vertexCapacity, Uint32 indexCapacity,
+         SDL_GPUIndexElementSize indexElementSize =
+             SDL_GPU_INDEXELEMENTSIZE_32BIT,
+         bool positionStream = false);
+
+  /// \brief Allocate a Mesh of \p vertexCount vertices and \p indexCount
+  /// indices from the arena.
+  ///
+  /// The returned Mesh has no views. MeshView offsets passed to
+  /// Mesh::addView() are relative to the start of the allocation.
+  /// \returns The Mesh, or nothing if the arena is full.
+  [[nodiscard]] std::optional<Mesh> allocate(Uint32 vertexCount,
+                                             Uint32 indexCount);
+
+  const MeshLayout &layout() const { return m_layout; }
+  SDL_GPUBuffer *vertexBuffer(Uint32 i) const { return m_vertexBuffers[i]; }
+  SDL_GPUBuffer *indexBuffer() const { return m_indexBuffer; }
+  SDL_GPUBuffer *positionBuffer() const { return m_positionBuffer; }
+  SDL_GPUIndexElementSize indexElementSize() const {
+    return m_indexElementSize;
+  }
+  const FreeListAllocator &vertexAllocator() const { return m_vertices; }
+  const FreeListAllocator &indexAllocator() const { return m_indices; }
+
+private:
+  friend class Mesh;
+  void free(Uint32 vertexOffset, Uint32 vertexCount, Uint32 indexOffset,
+            Uint32 indexCount) noexcept;
+
+  SDL_GPUDevice *m_device;
+  MeshLayout m_layout;
+  std::vector<SDL_GPUBuffer *> m_vertexBuffers;
+  SDL_GPUBuffer *m_indexBuffer{nullptr};
+  SDL_GPUBuffer *m_positionBuffer{nullptr};
+  SDL_GPUIndexElementSize m_indexElementSize;
+  FreeListAllocator m_vertices;
+  FreeListAllocator m_indices;
+};
+
+} // namespace candlewick
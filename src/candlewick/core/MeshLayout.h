@@ -1,6 +1,7 @@
 #pragma once
 
 #include <SDL3/SDL_gpu.h>
+#include <SDL3/SDL_assert.h>
 #include "math_types.h"
 #include <vector>
 
@@ -52,25 +53,40 @@ constexpr Uint64 vertexElementSize(SDL_GPUVertexElementFormat format) {
   case SDL_GPU_VERTEXELEMENTFORMAT_UBYTE2:
   case SDL_GPU_VERTEXELEMENTFORMAT_BYTE2_NORM:
   case SDL_GPU_VERTEXELEMENTFORMAT_UBYTE2_NORM:
-    return 16u;
+    return sizeof(Uint8[2]);
   case SDL_GPU_VERTEXELEMENTFORMAT_BYTE4:
   case SDL_GPU_VERTEXELEMENTFORMAT_UBYTE4:
   case SDL_GPU_VERTEXELEMENTFORMAT_BYTE4_NORM:
   case SDL_GPU_VERTEXELEMENTFORMAT_UBYTE4_NORM:
-    return 32u;
+    return sizeof(Uint8[4]);
   case SDL_GPU_VERTEXELEMENTFORMAT_SHORT2:
   case SDL_GPU_VERTEXELEMENTFORMAT_USHORT2:
   case SDL_GPU_VERTEXELEMENTFORMAT_SHORT2_NORM:
   case SDL_GPU_VERTEXELEMENTFORMAT_USHORT2_NORM:
   case SDL_GPU_VERTEXELEMENTFORMAT_HALF2:
-    return 32ul;
+    return sizeof(Uint16[2]);
   case SDL_GPU_VERTEXELEMENTFORMAT_SHORT4:
   case SDL_GPU_VERTEXELEMENTFORMAT_USHORT4:
   case SDL_GPU_VERTEXELEMENTFORMAT_SHORT4_NORM:
   case SDL_GPU_VERTEXELEMENTFORMAT_USHORT4_NORM:
   case SDL_GPU_VERTEXELEMENTFORMAT_HALF4:
-    return 64ul;
+    return sizeof(Uint16[4]);
   }
+  return 0u;
+}
+
+/// \brief Size of an index element, in bytes.
+constexpr Uint32 indexElementBytes(SDL_GPUIndexElementSize size) {
+  return size == SDL_GPU_INDEXELEMENTSIZE_16BIT ? sizeof(Uint16)
+                                                : sizeof(Uint32);
+}
+
+/// \brief Smallest index element size which can address \p numVertices
+/// vertices. The largest 16-bit value is left out, as it is the primitive
+/// restart index on some backends.
+constexpr SDL_GPUIndexElementSize minimalIndexElementSize(Uint32 numVertices) {
+  return numVertices <= 0xFFFFu ? SDL_GPU_INDEXELEMENTSIZE_16BIT
+                                : SDL_GPU_INDEXELEMENTSIZE_32BIT;
 }
 
 /// \brief Fixed vertex attributes.
@@ -86,6 +102,9 @@ enum class VertexAttrib : Uint16 {
   Color1,
   TexCoord0,
   TexCoord1,
+  /// Per-draw attributes, from an instance-rate buffer of GpuDrawRecord.
+  DrawObject,
+  DrawMaterial,
 };
 
 /// \brief This class defines the layout of a mesh's vertices.
@@ -110,6 +129,15 @@ public:
   /// type Vertex.
   MeshLayout &addBinding(Uint32 slot, Uint32 pitch) {
     m_bufferDescs.emplace_back(slot, pitch, SDL_GPU_VERTEXINPUTRATE_VERTEX, 0u);
+    m_totalVertexSize += pitch;
+    return *this;
+  }
+
+  /// \brief Add an instance-rate binding, whose elements advance once per
+  /// instance instead of once per vertex. It does not count in vertexSize().
+  MeshLayout &addInstanceBinding(Uint32 slot, Uint32 pitch) {
+    m_bufferDescs.emplace_back(slot, pitch, SDL_GPU_VERTEXINPUTRATE_INSTANCE,
+                               0u);
     return *this;
   }
 
@@ -125,9 +153,6 @@ public:
                                      Uint32 offset) {
     const Uint16 _loc = static_cast<Uint16>(loc);
     m_attrs.emplace_back(_loc, binding, format, offset);
-    const Uint32 attrSize =
-        math::roundUpTo16(Uint32(vertexElementSize(format)));
-    m_totalVertexSize = std::max(m_totalVertexSize, offset + attrSize);
     return *this;
   }
 
@@ -181,11 +206,9 @@ public:
   Uint32 numBuffers() const { return Uint32(m_bufferDescs.size()); }
   /// \brief Number of vertex attributes.
   Uint32 numAttributes() const { return Uint32(m_attrs.size()); }
-  /// \brief Total size of a vertex (in bytes).
-  /// \todo Make this compatible with multiple vertex bindings.
+  /// \brief Total size of a vertex (in bytes), i.e. the sum of the pitches of
+  /// the vertex bindings.
   Uint32 vertexSize() const { return m_totalVertexSize; }
-  /// \brief Size of mesh indices (in bytes).
-  Uint32 indexSize() const { return sizeof(Uint32); }
 
   std::vector<SDL_GPUVertexBufferDescription> m_bufferDescs;
   std::vector<SDL_GPUVertexAttribute> m_attrs;
@@ -200,6 +223,27 @@ inline bool validateMeshLayout(const MeshLayout &layout) {
   return (layout.numBuffers() > 0) && (layout.numAttributes() > 0);
 }
 
+/// \brief Layout of the position-only vertex stream of meshes with \p layout:
+/// a single binding holding tightly packed positions.
+/// \sa Mesh::positionBuffer
+inline MeshLayout positionStreamLayout(const MeshLayout &layout) {
+  const SDL_GPUVertexAttribute *pos =
+      layout.getAttribute(VertexAttrib::Position);
+  SDL_assert(pos);
+  MeshLayout out;
+  out.addBinding(0, Uint32(vertexElementSize(pos->format)))
+      .addAttribute(VertexAttrib::Position, 0, pos->format, 0u);
+  return out;
+}
+
+/// \brief Whether the layout only holds vertex positions, e.g. the layout of
+/// a position-only stream.
+/// \sa positionStreamLayout()
+inline bool isPositionOnlyLayout(const MeshLayout &layout) {
+  return layout.numAttributes() == 1 &&
+         layout.getAttribute(VertexAttrib::Position) != nullptr;
+}
+
 /// \brief Basic concept checking if type V has the correct layout and alignment
 /// requirements to be a vertex element.
 template <typename V>
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "Culling.h"
+
+namespace candlewick {
+
+/// \brief A small cluster of triangles of an indexed triangle mesh, with
+/// bounds to cull it.
+///
+/// A meshlet is a range of consecutive triangles in the index buffer, so that
+/// runs of visible meshlets are drawn with a single indexed draw call. Its
+/// bounds are in the units of the dequantized vertex positions.
+/// \sa buildMeshlets()
+struct Meshlet {
+  Uint32 indexOffset; //< Offset of the meshlet's indices, in elements.
+  Uint32 indexCount;  //< Number of indices of the meshlet.
+  /// Center of the bounding sphere.
+  Float3 center;
+  /// Radius of the bounding sphere.
+  float radius;
+  /// Axis of the normal cone, which contains the normals of all triangles.
+  Float3 coneAxis;
+  /// Sine of the half-angle of the normal cone. The meshlet is never
+  /// backfacing if this is 1, e.g. when its triangles face all directions.
+  float coneCutoff;
+};
+
+/// \brief Whether all triangles of a meshlet face away from a perspective
+/// camera located at \p cameraPos, in the frame of the meshlet's bounds.
+inline bool isMeshletBackfacing(const Meshlet &meshlet,
+                                const Float3 &cameraPos) {
+  const Float3 d = meshlet.center - cameraPos;
+  return d.dot(meshlet.coneAxis) >=
+         meshlet.coneCutoff * d.norm() + meshlet.radius;
+}
+
+} // namespace candlewick
@@ -0,0 +1,17 @@
+#include "ObjectBuffer.h"
+
+namespace candlewick {
+
+Uint32 ObjectBuffer::addObject(const Mat4f &model, const Mat4f &transform) {
+  Mat4f normalMatrix = Mat4f::Identity();
+  normalMatrix.topLeftCorner<3, 3>() = math::computeNormalMatrix(transform);
+  m_objects.push_back({model, normalMatrix});
+  return Uint32(m_objects.size() - 1);
+}
+
+void ObjectBuffer::upload(CommandBuffer &command_buffer) {
+  m_buffer.upload(command_buffer, {std::as_bytes(std::span{m_objects}),
+                                   std::as_bytes(std::span{m_materials})});
+}
+
+} // namespace candlewick
@@ -0,0 +1,98 @@
+#pragma once
+
+#include "Core.h"
+#include "InstanceBuffer.h"
+#include "MaterialUniform.h"
+#include "math_types.h"
+
+#include <vector>
+
+namespace candlewick {
+
+/// \brief Transforms of an object, as stored in an ObjectBuffer.
+struct alignas(16) GpuObjectData {
+  /// Model matrix, including the Mesh's position dequantization.
+  GpuMat4 model;
+  /// Normal matrix of the model transform, padded to 4x4.
+  GpuMat4 normalMatrix;
+};
+
+/// \brief Per-frame GPU storage buffer of the transforms and materials of the
+/// objects drawn in a frame.
+///
+/// The data is gathered on the CPU with addObject() and addMaterial(), then
+/// uploaded once per frame with upload(), in a single copy. All passes of the
+/// frame (shadow maps, depth pre-pass, main pass...) then read the transforms
+/// from the same buffer, indexed by object, instead of each pushing them as
+/// uniforms for every draw.
+///
+/// The materials are stored after the objects, in the same buffer. Shaders
+/// read them by binding the buffer as an array of \ref PbrMaterial, at the
+/// indices given by materialIndex().
+class ObjectBuffer {
+public:
+  /// Object index of objects which are not in the buffer.
+  static constexpr Uint32 kNoObject = ~0u;
+
+  /// The buffer is also read by compute shaders, e.g. to cull draws on the
+  /// GPU. \sa GpuDrawList
+  explicit ObjectBuffer(const Device &device)
+      : m_buffer(device, SDL_GPU_BUFFERUSAGE_GRAPHICS_STORAGE_READ |
+                             SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_READ) {}
+
+  /// \brief Remove the objects and materials, e.g. at the start of a frame.
+  void clear() {
+    m_objects.clear();
+    m_materials.clear();
+  }
+
+  /// \brief Add an object, and return its index.
+  /// \param model Model matrix, including the position dequantization.
+  /// \param transform Transform of the object, without the dequantization,
+  /// for the normal matrix.
+  Uint32 addObject(const Mat4f &model, const Mat4f &transform);
+
+  /// \brief Add a material, and return its index among the materials.
+  Uint32 addMaterial(const PbrMaterial &material) {
+    m_materials.push_back(material);
+    return Uint32(m_materials.size() - 1);
+  }
+
+  Uint32 numObjects() const { return Uint32(m_objects.size()); }
+  Uint32 numMaterials() const { return Uint32(m_materials.size()); }
+  bool empty() const { return m_objects.empty(); }
+
+  /// \brief Index of a material in the buffer, seen as an array of
+  /// PbrMaterial. This is the index shaders use.
+  /// \warning Only valid once all objects are added.
+  Uint32 materialIndex(Uint32 material) const {
+    return numObjects() * kMaterialsPerObject + material;
+  }
+
+  /// \brief Upload the objects and materials.
+  /// \warning This records a copy pass: call it outside of render passes.
+  void upload(CommandBuffer &command_buffer);
+
+  void bindVertex(SDL_GPURenderPass *pass, Uint32 slot = 0) const {
+    m_buffer.bindVertex(pass, slot);
+  }
+  void bindFragment(SDL_GPURenderPass *pass, Uint32 slot = 0) const {
+    m_buffer.bindFragment(pass, slot);
+  }
+  void bindCompute(SDL_GPUComputePass *pass, Uint32 slot = 0) const {
+    m_buffer.bindCompute(pass, slot);
+  }
+
+  void release() noexcept { m_buffer.release(); }
+
+private:
+  static constexpr Uint32 kMaterialsPerObject =
+      sizeof(GpuObjectData) / sizeof(PbrMaterial);
+  static_assert(sizeof(GpuObjectData) % sizeof(PbrMaterial) == 0);
+
+  std::vector<GpuObjectData> m_objects;
+  std::vector<PbrMaterial> m_materials;
+  InstanceBuffer m_buffer;
+};
+
+} // namespace candlewick
@@ -0,0 +1,203 @@
+#include "RenderQueue.h"
+#include "Mesh.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <tuple>
+#include <utility>
+
+namespace candlewick {
+
+void RenderQueue::clear() {
+  m_packets.clear();
+  m_depths.clear();
+  m_instanceObjects.clear();
+  m_pipelines.clear();
+  m_meshIds.clear();
+  m_materialIds.clear();
+  m_materials.clear();
+}
+
+Uint64 RenderQueue::makeKey(Uint32 pipelineId, Uint32 meshId,
+                            Uint32 materialId, Uint32 depthBucket) {
+  constexpr Uint32 depthShift = 0;
+  constexpr Uint32 materialShift = depthShift + kDepthBits;
+  constexpr Uint32 meshShift = materialShift + kMaterialBits;
+  constexpr Uint32 pipelineShift = meshShift + kMeshBits;
+  auto field = [](Uint32 value, Uint32 bits) {
+    return Uint64(std::min(value, (1u << bits) - 1u));
+  };
+  return field(pipelineId, kPipelineBits) << pipelineShift |
+         field(meshId, kMeshBits) << meshShift |
+         field(materialId, kMaterialBits) << materialShift |
+         field(depthBucket, kDepthBits) << depthShift;
+}
+
+Uint32 RenderQueue::depthBucket(float depth) {
+  // 64 buckets per doubling of the distance, up to 2^16
+  constexpr float bucketsPerOctave = float(1u << kDepthBits) / 16.f;
+  if (!(depth > 0.f))
+    return 0;
+  const float bucket = std::log2(1.f + depth) * bucketsPerOctave;
+  return Uint32(std::min(bucket, float((1u << kDepthBits) - 1u)));
+}
+
+Uint32 RenderQueue::pipelineId(SDL_GPUGraphicsPipeline *pipeline) {
+  auto it = std::find(m_pipelines.begin(), m_pipelines.end(), pipeline);
+  if (it != m_pipelines.end())
+    return Uint32(it - m_pipelines.begin());
+  m_pipelines.push_back(pipeline);
+  return Uint32(m_pipelines.size() - 1);
+}
+
+Uint32 RenderQueue::meshId(const Mesh &mesh) {
+  // meshes allocated from the same arena share their buffers
+  auto [it, inserted] =
+      m_meshIds.try_emplace(mesh.vertexBuffers[0], Uint32(m_meshIds.size()));
+  return it->second;
+}
+
+size_t RenderQueue::MaterialKeyHash::operator()(
+    const MaterialKey &key) const noexcept {
+  size_t h = 0;
+  for (float x : key)
+    h = h * 31 + std::hash<float>{}(x);
+  return h;
+}
+
+Uint32 RenderQueue::materialId(const PbrMaterial &material) {
+  const MaterialKey key{material.baseColor[0], material.baseColor[1],
+                        material.baseColor[2], material.baseColor[3],
+                        material.metalness,    material.roughness,
+                        material.ao};
+  auto [it, inserted] =
+      m_materialIds.try_emplace(key, Uint32(m_materials.size()));
+  if (inserted)
+    m_materials.push_back(material);
+  return it->second;
+}
+
+void RenderQueue::push(SDL_GPUGraphicsPipeline *pipeline, const Mesh &mesh,
+                       Uint32 lod, Uint32 viewIndex,
+                       const PbrMaterial &material, Uint32 object,
+                       float depth, Uint32 payload) {
+  const Uint32 matId = materialId(material);
+  m_depths.push_back(depth);
+  m_packets.push_back({
+      .key = makeKey(pipelineId(pipeline), meshId(mesh), matId,
+                     depthBucket(depth)),
+      .pipeline = pipeline,
+      .mesh = &mesh,
+      .lod = lod,
+      .viewIndex = viewIndex,
+      .materialId = matId,
+      .object = object,
+      .payload = payload,
+  });
+}
+
+void RenderQueue::mergeInstances(SDL_GPUGraphicsPipeline *instancedPipeline,
+                                 Uint32 minInstances) {
+  minInstances = std::max(minInstances, 2u);
+  // order the mergeable draws by view identity, keeping the others apart
+  using GroupKey = std::tuple<bool, SDL_GPUGraphicsPipeline *, SDL_GPUBuffer *,
+                              SDL_GPUBuffer *, Uint32, Uint32, Uint32, Uint32>;
+  auto groupKey = [this](size_t i) {
+    const DrawPacket &p = m_packets[i];
+    const MeshView &view = p.mesh->lodViews(p.lod)[p.viewIndex];
+    return GroupKey{p.payload != 0,        p.pipeline,
+                    view.vertexBuffers[0], view.indexBuffer,
+                    view.vertexOffset,     view.indexOffset,
+                    view.indexCount,       p.materialId};
+  };
+  std::vector<Uint32> order(m_packets.size());
+  std::iota(order.begin(), order.end(), 0u);
+  std::ranges::stable_sort(order, [&](Uint32 a, Uint32 b) {
+    return groupKey(a) < groupKey(b);
+  });
+
+  m_scratch.clear();
+  m_instanceObjects.clear();
+  for (size_t begin = 0; begin < order.size();) {
+    const GroupKey key = groupKey(order[begin]);
+    size_t end = begin + 1;
+    while (end < order.size() && groupKey(order[end]) == key)
+      end++;
+    const Uint32 count = Uint32(end - begin);
+    if (std::get<0>(key) || count < minInstances) {
+      for (size_t k = begin; k < end; k++)
+        m_scratch.push_back(m_packets[order[k]]);
+      begin = end;
+      continue;
+    }
+    // key the group on its nearest object
+    float depth = m_depths[order[begin]];
+    DrawPacket packet = m_packets[order[begin]];
+    packet.firstInstance = Uint32(m_instanceObjects.size());
+    packet.instanceCount = count;
+    packet.object = kInstancedObject | packet.firstInstance;
+    packet.pipeline = instancedPipeline;
+    for (size_t k = begin; k < end; k++) {
+      m_instanceObjects.push_back(m_packets[order[k]].object);
+      depth = std::min(depth, m_depths[order[k]]);
+    }
+    packet.key = makeKey(pipelineId(instancedPipeline), meshId(*packet.mesh),
+                         packet.materialId, depthBucket(depth));
+    m_scratch.push_back(packet);
+    begin = end;
+  }
+  m_packets.swap(m_scratch);
+  // the depths are only needed to key the merged draws
+  m_depths.clear();
+}
+
+void RenderQueue::sort() {
+  // LSD radix sort, one byte at a time; stable, so that draws with equal keys
+  // keep their submission order
+  const size_t n = m_packets.size();
+  m_scratch.resize(n);
+  for (Uint32 shift = 0; shift < 64; shift += 8) {
+    std::array<size_t, 256> counts{};
+    for (const DrawPacket &p : m_packets)
+      counts[(p.key >> shift) & 0xFF]++;
+    // skip the bytes which all keys share
+    if (std::ranges::find(counts, n) != counts.end())
+      continue;
+    size_t offset = 0;
+    for (size_t &c : counts)
+      offset += std::exchange(c, offset);
+    for (const DrawPacket &p : m_packets)
+      m_scratch[counts[(p.key >> shift) & 0xFF]++] = p;
+    m_packets.swap(m_scratch);
+  }
+}
+
+void DrawStateTracker::bindPipeline(SDL_GPUGraphicsPipeline *pipeline) {
+  if (pipeline == m_pipeline) {
+    m_stats.pipelineBindsSaved++;
+    return;
+  }
+  SDL_BindGPUGraphicsPipeline(m_pass, pipeline);
+  m_pipeline = pipeline;
+  m_stats.pipelineBinds++;
+}
+
+void DrawStateTracker::bindMesh(const Mesh &mesh) {
+  if (m_binder.bind(mesh))
+    m_stats.meshBinds++;
+  else
+    m_stats.meshBindsSaved++;
+}
+
+bool DrawStateTracker::change(Uint32 &current, Uint32 next) {
+  if (current == next) {
+    m_stats.uniformPushesSaved++;
+    return false;
+  }
+  current = next;
+  m_stats.uniformPushes++;
+  return true;
+}
+
+} // namespace candlewick
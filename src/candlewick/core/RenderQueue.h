@@ -0,0 +1,174 @@
+#pragma once
+
+#include "Core.h"
+#include "MaterialUniform.h"
+#include "Renderer.h"
+
+#include <array>
+#include <span>
+#include <unordered_map>
+#include <vector>
+#include <SDL3/SDL_gpu.h>
+
+namespace candlewick {
+
+/// \brief Counters of the state changes made while submitting sorted draws,
+/// and of those skipped because the state was already bound.
+/// \sa DrawStateTracker
+struct RenderQueueStats {
+  Uint32 draws = 0;
+  /// Objects drawn, with those of instanced draws counted one by one.
+  Uint32 instances = 0;
+  Uint32 pipelineBinds = 0;
+  Uint32 pipelineBindsSaved = 0;
+  Uint32 meshBinds = 0;
+  Uint32 meshBindsSaved = 0;
+  /// Pushes of per-object and per-material uniforms.
+  Uint32 uniformPushes = 0;
+  Uint32 uniformPushesSaved = 0;
+  /// Mesh views culled on the GPU, and drawn with indirect draws.
+  /// \sa GpuDrawList
+  Uint32 gpuCulled = 0;
+};
+
+/// \brief A draw of one view of a Mesh, recorded in a RenderQueue.
+struct DrawPacket {
+  /// Sort key. \sa RenderQueue::makeKey()
+  Uint64 key;
+  SDL_GPUGraphicsPipeline *pipeline;
+  const Mesh *mesh;
+  Uint32 lod;       //< Level of detail of the view.
+  Uint32 viewIndex; //< Index of the view in Mesh::lodViews().
+  Uint32 materialId;
+  /// Index of the object (e.g. the entity) the view belongs to, in data owned
+  /// by the caller. Draws of the same object share their transform uniforms.
+  /// Instanced draws use RenderQueue::kInstancedObject | firstInstance.
+  Uint32 object;
+  /// Caller-defined data, e.g. an index into per-draw data.
+  Uint32 payload;
+  /// Range of the objects of an instanced draw, in
+  /// RenderQueue::instanceObjects(). \sa RenderQueue::mergeInstances()
+  Uint32 firstInstance = 0;
+  Uint32 instanceCount = 1;
+
+  bool isInstanced() const { return instanceCount > 1; }
+};
+
+/// \brief Queue of draws, sorted by a 64-bit key to minimize state changes.
+///
+/// The key holds, from the most significant bits: the pipeline, the vertex
+/// buffer of the mesh, the material and the depth (front to back). State
+/// changes are thus grouped across the whole queue, and depth only orders the
+/// draws which share their state. This suits opaque draws; blended draws need
+/// a back-to-front order, and are not queued here. Draws are recorded with
+/// push(), sorted with sort() (an LSD radix sort on the keys), then submitted
+/// in order with a DrawStateTracker.
+class RenderQueue {
+public:
+  static constexpr Uint32 kPipelineBits = 8;
+  static constexpr Uint32 kMeshBits = 24;
+  static constexpr Uint32 kMaterialBits = 22;
+  static constexpr Uint32 kDepthBits = 10;
+  static_assert(kPipelineBits + kMeshBits + kMaterialBits + kDepthBits == 64);
+  /// Bit set in the DrawPacket::object of instanced draws.
+  static constexpr Uint32 kInstancedObject = 1u << 31;
+
+  /// Clear the draws, and the pipeline, mesh and material ids.
+  void clear();
+
+  /// \brief Record a draw.
+  /// \param depth Distance from the camera to the object, for front-to-back
+  /// ordering. It is quantized on a logarithmic scale.
+  void push(SDL_GPUGraphicsPipeline *pipeline, const Mesh &mesh, Uint32 lod,
+            Uint32 viewIndex, const PbrMaterial &material, Uint32 object,
+            float depth, Uint32 payload = 0);
+
+  /// \brief Merge the draws of the same view of a mesh (same buffers and
+  /// offsets), with the same pipeline and material, into instanced draws.
+  ///
+  /// Only draws with a zero payload are merged, and only groups of at least
+  /// \p minInstances draws. Merged draws use \p instancedPipeline, are keyed
+  /// on their nearest object, and list their objects in instanceObjects().
+  /// Call this before sort().
+  void mergeInstances(SDL_GPUGraphicsPipeline *instancedPipeline,
+                      Uint32 minInstances = 2);
+
+  /// \brief Objects of the instanced draws, each draw's objects contiguous.
+  std::span<const Uint32> instanceObjects() const { return m_instanceObjects; }
+
+  /// \brief Sort the draws by key. Draws with equal keys keep their order.
+  void sort();
+
+  std::span<const DrawPacket> packets() const { return m_packets; }
+  size_t size() const { return m_packets.size(); }
+
+  /// \brief Material of a draw, by its id.
+  const PbrMaterial &material(Uint32 id) const { return m_materials[id]; }
+
+  /// \brief Sort key of a draw. Fields wider than their bits are clamped.
+  static Uint64 makeKey(Uint32 pipelineId, Uint32 meshId, Uint32 materialId,
+                        Uint32 depthBucket);
+
+  /// \brief Logarithmic depth bucket, over \c kDepthBits bits.
+  static Uint32 depthBucket(float depth);
+
+private:
+  Uint32 pipelineId(SDL_GPUGraphicsPipeline *pipeline);
+  Uint32 meshId(const Mesh &mesh);
+  Uint32 materialId(const PbrMaterial &material);
+
+  using MaterialKey = std::array<float, 7>;
+  struct MaterialKeyHash {
+    size_t operator()(const MaterialKey &key) const noexcept;
+  };
+
+  std::vector<DrawPacket> m_packets;
+  std::vector<DrawPacket> m_scratch;
+  std::vector<float> m_depths;
+  std::vector<Uint32> m_instanceObjects;
+  std::vector<SDL_GPUGraphicsPipeline *> m_pipelines;
+  std::unordered_map<const SDL_GPUBuffer *, Uint32> m_meshIds;
+  std::unordered_map<MaterialKey, Uint32, MaterialKeyHash> m_materialIds;
+  std::vector<PbrMaterial> m_materials;
+};
+
+/// \brief Tracks the state bound while submitting sorted draws in a render
+/// pass, to skip redundant state changes, and counts them in a
+/// RenderQueueStats.
+class DrawStateTracker {
+public:
+  DrawStateTracker(SDL_GPURenderPass *pass, RenderQueueStats &stats)
+      : m_pass(pass), m_binder(pass), m_stats(stats) {}
+
+  /// \brief Bind a pipeline, unless it is bound already.
+  void bindPipeline(SDL_GPUGraphicsPipeline *pipeline);
+
+  /// \brief Bind the buffers of a Mesh, unless they are bound already.
+  void bindMesh(const Mesh &mesh);
+
+  /// \brief Whether the uniforms of \p object must be pushed, i.e. those of
+  /// another object were pushed last.
+  bool changeObject(Uint32 object) { return change(m_object, object); }
+
+  /// \brief Whether the uniforms of a material must be pushed.
+  bool changeMaterial(Uint32 materialId) {
+    return change(m_materialId, materialId);
+  }
+
+  void countDraw(Uint32 numInstances = 1) {
+    m_stats.draws++;
+    m_stats.instances += numInstances;
+  }
+
+private:
+  bool change(Uint32 &current, Uint32 next);
+
+  SDL_GPURenderPass *m_pass;
+  rend::MeshBinder m_binder;
+  RenderQueueStats &m_stats;
+  SDL_GPUGraphicsPipeline *m_pipeline = nullptr;
+  Uint32 m_object = ~0u;
+  Uint32 m_materialId = ~0u;
+};
+
+} // namespace candlewick
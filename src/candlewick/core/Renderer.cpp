@@ -87,8 +87,7 @@ namespace rend {
     SDL_BindGPUVertexBuffers(pass, 0, vertex_bindings.data(), num_buffers);
     if (mesh.isIndexed()) {
       SDL_GPUBufferBinding index_binding = mesh.getIndexBinding();
-      SDL_BindGPUIndexBuffer(pass, &index_binding,
-                             SDL_GPU_INDEXELEMENTSIZE_32BIT);
+      SDL_BindGPUIndexBuffer(pass, &index_binding, mesh.indexElementSize);
     }
   }
 
@@ -103,8 +102,16 @@ namespace rend {
     SDL_BindGPUVertexBuffers(pass, 0, vertex_bindings.data(), num_buffers);
     if (meshView.isIndexed()) {
       SDL_GPUBufferBinding index_binding = {meshView.indexBuffer, 0u};
-      SDL_BindGPUIndexBuffer(pass, &index_binding,
-                             SDL_GPU_INDEXELEMENTSIZE_32BIT);
+      SDL_BindGPUIndexBuffer(pass, &index_binding, meshView.indexElementSize);
+    }
+  }
+
+  void bindMeshPositions(SDL_GPURenderPass *pass, const Mesh &mesh) {
+    SDL_GPUBufferBinding vertex_binding{mesh.positionBuffer, 0u};
+    SDL_BindGPUVertexBuffers(pass, 0, &vertex_binding, 1);
+    if (mesh.isIndexed()) {
+      SDL_GPUBufferBinding index_binding = mesh.getIndexBinding();
+      SDL_BindGPUIndexBuffer(pass, &index_binding, mesh.indexElementSize);
     }
   }
 
@@ -121,6 +128,16 @@ namespace rend {
     }
   }
 
+  void drawViewIndices(SDL_GPURenderPass *pass, const MeshView &view,
+                       Uint32 firstIndex, Uint32 indexCount,
+                       Uint32 numInstances) {
+    assert(view.isIndexed());
+    assert(firstIndex >= view.indexOffset &&
+           firstIndex + indexCount <= view.indexOffset + view.indexCount);
+    SDL_DrawGPUIndexedPrimitives(pass, indexCount, numInstances, firstIndex,
+                                 Sint32(view.vertexOffset), 0);
+  }
+
   void drawViews(SDL_GPURenderPass *pass, std::span<const MeshView> meshViews,
                  Uint32 numInstances) {
     if (meshViews.empty())
@@ -79,6 +79,56 @@ namespace rend {
   /// \sa drawViews()
   void bindMeshView(SDL_GPURenderPass *pass, const MeshView &view);
 
+  /// \brief Bind the position-only vertex stream of a Mesh, along with its
+  /// index buffer, for pipelines with the positionStreamLayout() of the
+  /// Mesh's layout.
+  /// \sa Mesh::positionBuffer
+  void bindMeshPositions(SDL_GPURenderPass *pass, const Mesh &mesh);
+
+  /// \brief Binds meshes within a render pass, skipping the bind calls when
+  /// the buffers are those of the previously bound mesh.
+  ///
+  /// Meshes allocated from the same MeshArena share their buffers, so a pass
+  /// drawing only these binds them once.
+  /// \sa MeshArena
+  class MeshBinder {
+  public:
+    explicit MeshBinder(SDL_GPURenderPass *pass) : m_pass(pass) {}
+
+    /// \returns Whether the buffers were bound, i.e. were not bound already.
+    bool bind(const Mesh &mesh) {
+      SDL_GPUBuffer *vb = mesh.vertexBuffers[0];
+      if (vb == m_vertexBuffer && mesh.indexBuffer == m_indexBuffer)
+        return false;
+      bindMesh(m_pass, mesh);
+      m_vertexBuffer = vb;
+      m_indexBuffer = mesh.indexBuffer;
+      return true;
+    }
+
+    /// \brief Bind the position-only stream of the Mesh. Meshes without one
+    /// must have a position-only layout, and are bound as usual.
+    /// \sa bindMeshPositions()
+    void bindPositions(const Mesh &mesh) {
+      if (!mesh.hasPositionStream()) {
+        SDL_assert(isPositionOnlyLayout(mesh.layout()));
+        bind(mesh);
+        return;
+      }
+      SDL_GPUBuffer *vb = mesh.positionBuffer;
+      if (vb == m_vertexBuffer && mesh.indexBuffer == m_indexBuffer)
+        return;
+      bindMeshPositions(m_pass, mesh);
+      m_vertexBuffer = vb;
+      m_indexBuffer = mesh.indexBuffer;
+    }
+
+  private:
+    SDL_GPURenderPass *m_pass;
+    SDL_GPUBuffer *m_vertexBuffer{nullptr};
+    SDL_GPUBuffer *m_indexBuffer{nullptr};
+  };
+
   /// \brief Render a collection of MeshView.
   /// This collection must satisfy the invariant that they all have the same
   /// parent Mesh object, which allows batching draw calls like this without
@@ -110,6 +160,16 @@ namespace rend {
   void drawView(SDL_GPURenderPass *pass, const MeshView &mesh,
                 Uint32 numInstances = 1);
 
+  /// \brief Draw a range of the indices of an indexed MeshView, e.g. a run of
+  /// visible meshlets.
+  /// \warning Call bindMesh() first!
+  /// \param firstIndex First index to draw, in elements of the whole index
+  /// buffer (as MeshView::indexOffset).
+  /// \sa cullMeshlets()
+  void drawViewIndices(SDL_GPURenderPass *pass, const MeshView &view,
+                       Uint32 firstIndex, Uint32 indexCount,
+                       Uint32 numInstances = 1);
+
   /// \brief Bind multiple fragment shader samplers.
   inline void
   bindVertexSamplers(SDL_GPURenderPass *pass, Uint32 first_slot,
@@ -51,27 +51,29 @@ ShaderCode loadShaderFile(const char *filename, const char *shader_ext) {
   return ShaderCode{reinterpret_cast<Uint8 *>(code), code_size};
 }
 
-Shader::Shader(const Device &device, const char *filename, const Config &config)
-    : _shader(nullptr), _device(device) {
-  SDL_GPUShaderStage stage = detect_shader_stage(filename);
+/// Shader format supported by the device, with its file extension and entry
+/// point.
+struct ShaderFormatInfo {
+  SDL_GPUShaderFormat format;
+  const char *extension;
+  const char *entry_point;
+};
 
+static ShaderFormatInfo selectShaderFormat(const Device &device) {
   SDL_GPUShaderFormat supported_formats = device.shaderFormats();
-  SDL_GPUShaderFormat target_format = SDL_GPU_SHADERFORMAT_INVALID;
-  const char *shader_ext;
-  const char *entry_point;
+  if (supported_formats & SDL_GPU_SHADERFORMAT_SPIRV)
+    return {SDL_GPU_SHADERFORMAT_SPIRV, "spv", "main"};
+  if (supported_formats & SDL_GPU_SHADERFORMAT_MSL)
+    return {SDL_GPU_SHADERFORMAT_MSL, "msl", "main0"};
+  throw RAIIException(
+      "Failed to load shader: no available supported shader format.");
+}
 
-  if (supported_formats & SDL_GPU_SHADERFORMAT_SPIRV) {
-    target_format = SDL_GPU_SHADERFORMAT_SPIRV;
-    shader_ext = "spv";
-    entry_point = "main";
-  } else if (supported_formats & SDL_GPU_SHADERFORMAT_MSL) {
-    target_format = SDL_GPU_SHADERFORMAT_MSL;
-    shader_ext = "msl";
-    entry_point = "main0";
-  } else {
-    throw RAIIException(
-        "Failed to load shader: no available supported shader format.");
-  }
+Shader::Shader(const Device &device, const char *filename, const Config &config)
+    : _shader(nullptr), _device(device) {
+  SDL_GPUShaderStage stage = detect_shader_stage(filename);
+  const auto [target_format, shader_ext, entry_point] =
+      selectShaderFormat(device);
 
   ShaderCode shader_code = loadShaderFile(filename, shader_ext);
 
@@ -108,4 +110,47 @@ Shader::Config loadShaderMetadata(const char *filename) {
   return meta.get<Shader::Config>();
 }
 
+NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(ComputeShaderConfig, samplers,
+                                   readonly_storage_textures,
+                                   readonly_storage_buffers,
+                                   readwrite_storage_textures,
+                                   readwrite_storage_buffers, uniform_buffers,
+                                   threadcount_x, threadcount_y, threadcount_z);
+
+ComputeShaderConfig loadComputeShaderMetadata(const char *filename) {
+  auto data = loadShaderFile(filename, "json");
+  auto meta = nlohmann::json::parse(data.data, data.data + data.size);
+  return meta.get<ComputeShaderConfig>();
+}
+
+SDL_GPUComputePipeline *createComputePipeline(const Device &device,
+                                              const char *filename) {
+  const auto [target_format, shader_ext, entry_point] =
+      selectShaderFormat(device);
+  const ComputeShaderConfig config = loadComputeShaderMetadata(filename);
+  ShaderCode shader_code = loadShaderFile(filename, shader_ext);
+
+  SDL_GPUComputePipelineCreateInfo info{
+      .code_size = shader_code.size,
+      .code = shader_code.data,
+      .entrypoint = entry_point,
+      .format = target_format,
+      .num_samplers = config.samplers,
+      .num_readonly_storage_textures = config.readonly_storage_textures,
+      .num_readonly_storage_buffers = config.readonly_storage_buffers,
+      .num_readwrite_storage_textures = config.readwrite_storage_textures,
+      .num_readwrite_storage_buffers = config.readwrite_storage_buffers,
+      .num_uniform_buffers = config.uniform_buffers,
+      .threadcount_x = config.threadcount_x,
+      .threadcount_y = config.threadcount_y,
+      .threadcount_z = config.threadcount_z,
+      .props = 0U,
+  };
+  SDL_GPUComputePipeline *pipeline =
+      SDL_CreateGPUComputePipeline(device, &info);
+  if (!pipeline)
+    throw RAIIException(SDL_GetError());
+  return pipeline;
+}
+
 } // namespace candlewick
@@ -69,4 +69,30 @@ inline Shader Shader::fromMetadata(const Device &device,
   return Shader{device, shader_name, config};
 }
 
+/// \ingroup shaders
+/// \brief Resources and workgroup size of a compute shader, as in its JSON
+/// metadata.
+struct ComputeShaderConfig {
+  Uint32 samplers = 0;
+  Uint32 readonly_storage_textures = 0;
+  Uint32 readonly_storage_buffers = 0;
+  Uint32 readwrite_storage_textures = 0;
+  Uint32 readwrite_storage_buffers = 0;
+  Uint32 uniform_buffers = 0;
+  Uint32 threadcount_x = 1;
+  Uint32 threadcount_y = 1;
+  Uint32 threadcount_z = 1;
+};
+
+/// \brief Load the metadata of a compute shader, e.g. `CullDraws.comp`.
+ComputeShaderConfig loadComputeShaderMetadata(const char *shader_name);
+
+/// \ingroup shaders
+/// \brief Create a compute pipeline from a compute shader (`.comp`) and its
+/// metadata. The pipeline must be released with
+/// SDL_ReleaseGPUComputePipeline().
+/// \throws RAIIException if the pipeline cannot be created.
+[[nodiscard]] SDL_GPUComputePipeline *
+createComputePipeline(const Device &device, const char *shader_name);
+
 } // namespace candlewick
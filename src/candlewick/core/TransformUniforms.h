@@ -10,4 +10,13 @@ struct alignas(16) TransformUniformData {
   alignas(16) GpuMat3 normalMatrix;
 };
 
+/// \brief Per-pass uniforms of the shaders which read the model transforms
+/// from an ObjectBuffer. \sa ObjectBuffer
+struct alignas(16) ObjectPassUniformData {
+  GpuMat4 view;
+  GpuMat4 viewProj;
+  /// View-projection matrix of the shadow-casting light.
+  GpuMat4 lightViewProj;
+};
+
 } // namespace candlewick
@@ -0,0 +1,160 @@
+#include "UploadRing.h"
+#include "CommandBuffer.h"
+#include "errors.h"
+#include "math_types.h"
+
+namespace candlewick {
+
+UploadRing::UploadRing(SDL_GPUDevice *device, Uint32 capacity)
+    : m_device(device), m_buffer(nullptr),
+      m_capacity(math::roundUpTo16(capacity)) {
+  SDL_GPUTransferBufferCreateInfo info{
+      .usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD,
+      .size = m_capacity,
+      .props = 0,
+  };
+  m_buffer = SDL_CreateGPUTransferBuffer(m_device, &info);
+  if (!m_buffer)
+    throw RAIIException(SDL_GetError());
+}
+
+UploadTicket::~UploadTicket() noexcept {
+  for (auto *buffer : dedicated)
+    SDL_ReleaseGPUTransferBuffer(device, buffer);
+  if (fence)
+    SDL_ReleaseGPUFence(device, fence);
+}
+
+UploadRing::~UploadRing() noexcept {
+  while (!m_regions.empty()) {
+    if (!waitOldest())
+      m_regions.pop_front();
+  }
+  SDL_ReleaseGPUTransferBuffer(m_device, m_buffer);
+}
+
+UploadTicket &UploadRing::ticketFor(CommandBuffer &command_buffer) {
+  auto &ticket = command_buffer._uploadTicket;
+  if (!ticket)
+    ticket = std::make_shared<UploadTicket>(m_device);
+  return *ticket;
+}
+
+StagingAllocation UploadRing::allocate(CommandBuffer &command_buffer,
+                                       Uint32 size) {
+  size = math::roundUpTo16(size);
+  retireCompleted();
+  UploadTicket &ticket = ticketFor(command_buffer);
+
+  if (size <= m_capacity) {
+    // allocations do not wrap around: skip to the start of the buffer
+    Uint64 start = m_head;
+    const Uint32 phys = Uint32(start % m_capacity);
+    if (phys + size > m_capacity)
+      start += m_capacity - phys;
+
+    while (start + size - m_tail > m_capacity && !m_regions.empty()) {
+      if (!waitOldest())
+        break;
+    }
+
+    // otherwise, the allocations of unsubmitted command buffers fill the ring
+    if (start + size - m_tail <= m_capacity) {
+      m_head = start + size;
+      if (!m_regions.empty() && m_regions.back().ticket.get() == &ticket)
+        m_regions.back().end = m_head;
+      else
+        m_regions.push_back({m_head, command_buffer._uploadTicket});
+      auto *map =
+          (std::byte *)SDL_MapGPUTransferBuffer(m_device, m_buffer, false);
+      if (!map)
+        throw RAIIException(SDL_GetError());
+      const Uint32 offset = Uint32(start % m_capacity);
+      return {m_buffer, offset, size, map + offset};
+    }
+  }
+
+  SDL_GPUTransferBufferCreateInfo info{
+      .usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD,
+      .size = size,
+      .props = 0,
+  };
+  SDL_GPUTransferBuffer *buffer = SDL_CreateGPUTransferBuffer(m_device, &info);
+  if (!buffer)
+    throw RAIIException(SDL_GetError());
+  ticket.dedicated.push_back(buffer);
+  auto *map = (std::byte *)SDL_MapGPUTransferBuffer(m_device, buffer, false);
+  if (!map)
+    throw RAIIException(SDL_GetError());
+  return {buffer, 0u, size, map};
+}
+
+void UploadRing::unmap(const StagingAllocation &alloc) {
+  SDL_UnmapGPUTransferBuffer(m_device, alloc.buffer);
+}
+
+bool UploadRing::submit(CommandBuffer &command_buffer) {
+  retireCompleted();
+  std::shared_ptr<UploadTicket> ticket =
+      std::move(command_buffer._uploadTicket);
+  if (!ticket) {
+    // nothing was allocated for this command buffer: no fence needed
+    if (command_buffer.submitUnguarded())
+      return true;
+    SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                 "%s: Failed to submit command buffer: %s", __FILE__,
+                 SDL_GetError());
+    return false;
+  }
+  SDL_GPUFence *fence = command_buffer.submitAndAcquireFence();
+  // release dedicated buffers: this is deferred until the GPU is done
+  for (auto *buffer : ticket->dedicated)
+    SDL_ReleaseGPUTransferBuffer(m_device, buffer);
+  ticket->dedicated.clear();
+  if (!fence) {
+    SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                 "%s: Failed to submit command buffer: %s", __FILE__,
+                 SDL_GetError());
+    ticket->done = true;
+    return false;
+  }
+  // released with the ticket, once its regions are retired
+  ticket->fence = fence;
+  return true;
+}
+
+bool UploadRing::cancel(CommandBuffer &command_buffer) {
+  std::shared_ptr<UploadTicket> ticket =
+      std::move(command_buffer._uploadTicket);
+  if (ticket)
+    ticket->done = true;
+  return command_buffer.cancelUnguarded();
+}
+
+bool UploadRing::isDone(UploadTicket &ticket) {
+  if (!ticket.done && ticket.fence)
+    ticket.done = SDL_QueryGPUFence(m_device, ticket.fence);
+  return ticket.done;
+}
+
+void UploadRing::retireCompleted() {
+  while (!m_regions.empty() && isDone(*m_regions.front().ticket)) {
+    m_tail = m_regions.front().end;
+    m_regions.pop_front();
+  }
+}
+
+bool UploadRing::waitOldest() {
+  UploadTicket &oldest = *m_regions.front().ticket;
+  if (!oldest.done) {
+    if (!oldest.fence)
+      return false;
+    SDL_WaitForGPUFences(m_device, true, &oldest.fence, 1);
+    oldest.done = true;
+  }
+  m_tail = m_regions.front().end;
+  m_regions.pop_front();
+  return true;
+}
+
+} // namespace candlewick
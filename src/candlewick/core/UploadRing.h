@@ -0,0 +1,123 @@
+#pragma once
+
+#include "Core.h"
+#include <SDL3/SDL_gpu.h>
+
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <vector>
+
+namespace candlewick {
+
+/// \brief Mapped region of staging memory, returned by UploadRing::allocate().
+struct StagingAllocation {
+  /// Transfer buffer to use as the source of copy commands.
+  SDL_GPUTransferBuffer *buffer;
+  /// Byte offset of the region in the transfer buffer.
+  Uint32 offset;
+  /// Size of the region, in bytes.
+  Uint32 size;
+  /// Mapped pointer to the region. Valid until UploadRing::unmap().
+  std::byte *data;
+};
+
+/// \brief Staging memory allocated for a CommandBuffer, shared by the command
+/// buffer and the UploadRing.
+///
+/// The memory is recycled once the command buffer has completed on the GPU,
+/// or has been cancelled.
+struct UploadTicket {
+  SDL_GPUDevice *device;
+  /// Fence acquired when the command buffer was submitted, null before.
+  SDL_GPUFence *fence = nullptr;
+  /// Whether the GPU is done with the memory.
+  bool done = false;
+  /// Dedicated transfer buffers, released on submission.
+  std::vector<SDL_GPUTransferBuffer *> dedicated;
+
+  explicit UploadTicket(SDL_GPUDevice *device) : device(device) {}
+  UploadTicket(const UploadTicket &) = delete;
+  UploadTicket &operator=(const UploadTicket &) = delete;
+  ~UploadTicket() noexcept;
+};
+
+/// \brief Persistent, fence-guarded ring of staging memory for uploads to the
+/// GPU.
+///
+/// Staging memory is sub-allocated from a single transfer buffer which lives as
+/// long as the Device. Each allocation belongs to the command buffer it is
+/// made for, and is recycled once that command buffer has completed, which is
+/// tracked using the fence acquired when it is submitted. Other command
+/// buffers may be submitted in the meantime. Regions are recycled in
+/// allocation order, so a command buffer which is not yet submitted holds back
+/// the regions allocated after its own. Requests which do not fit in the ring
+/// fall back to a dedicated transfer buffer, released after submission.
+///
+/// Usage:
+/// 1. allocate() staging memory for a command buffer and write to the mapped
+///    pointer,
+/// 2. unmap() it, then record copy commands reading from it in that command
+///    buffer,
+/// 3. submit the command buffer, with CommandBuffer::submit() which goes
+///    through the ring's submit().
+///
+/// \warning This class is not thread-safe.
+/// \sa Device::uploadRing()
+class UploadRing {
+public:
+  static constexpr Uint32 kDefaultCapacity = 32u << 20;
+
+  UploadRing(SDL_GPUDevice *device, Uint32 capacity = kDefaultCapacity);
+  UploadRing(const UploadRing &) = delete;
+  UploadRing &operator=(const UploadRing &) = delete;
+  /// \brief Waits for in-flight uploads, then releases the transfer buffer.
+  ~UploadRing() noexcept;
+
+  /// \brief Allocate and map \p size bytes of staging memory, read by the
+  /// copy commands of \p command_buffer.
+  [[nodiscard]] StagingAllocation allocate(CommandBuffer &command_buffer,
+                                           Uint32 size);
+
+  /// \brief Unmap staging memory. Must be called before the copy commands
+  /// reading from \p alloc are recorded.
+  void unmap(const StagingAllocation &alloc);
+
+  /// \brief Submit a command buffer, and guard the staging memory allocated
+  /// for it with a fence. Completed submissions are retired first. This is
+  /// called by CommandBuffer::submit().
+  bool submit(CommandBuffer &command_buffer);
+
+  /// \brief Cancel a command buffer, recycling the staging memory allocated
+  /// for it. This is called by CommandBuffer::cancel().
+  bool cancel(CommandBuffer &command_buffer);
+
+  /// \brief Release the fences of completed submissions, recycling their
+  /// staging memory. This does not block.
+  void retireCompleted();
+
+  Uint32 capacity() const { return m_capacity; }
+  /// \brief Number of bytes currently reserved (in flight or pending submit).
+  Uint32 used() const { return Uint32(m_head - m_tail); }
+
+private:
+  struct Region {
+    Uint64 end;
+    std::shared_ptr<UploadTicket> ticket;
+  };
+  UploadTicket &ticketFor(CommandBuffer &command_buffer);
+  bool isDone(UploadTicket &ticket);
+  /// Wait for the oldest region to be released. Returns false if its command
+  /// buffer is not submitted yet.
+  bool waitOldest();
+
+  SDL_GPUDevice *m_device;
+  SDL_GPUTransferBuffer *m_buffer;
+  Uint32 m_capacity;
+  // Monotonic byte positions; the physical offset is (position % capacity).
+  Uint64 m_head{0};
+  Uint64 m_tail{0};
+  std::deque<Region> m_regions;
+};
+
+} // namespace candlewick
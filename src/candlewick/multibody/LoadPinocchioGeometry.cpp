@@ -1,15 +1,32 @@
 #include "LoadPinocchioGeometry.h"
 #include "LoadCoalPrimitives.h"
+#include "../core/CompactVertex.h"
 #include "../core/errors.h"
 #include "../utils/LoadMesh.h"
+#include "../utils/MeshCacheFile.h"
 #include "../utils/MeshTransforms.h"
 
 #include <pinocchio/multibody/geometry.hpp>
+#include <SDL3/SDL_log.h>
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <iterator>
+#include <mutex>
+#include <numeric>
+#include <thread>
+#include <utility>
 
 namespace candlewick::multibody {
 
+static MeshProcessOptions processOptions(Uint32 lodLevels) {
+  return {.lodLevels = lodLevels, .optimize = true};
+}
+
 void loadGeometryObject(const pin::GeometryObject &gobj,
-                        std::vector<MeshData> &meshData) {
+                        std::vector<MeshData> &meshData,
+                        const MeshLayout &layout, Uint32 lodLevels) {
   using namespace coal;
 
   const coal::CollisionGeometry &collgom = *gobj.geometry.get();
@@ -21,27 +38,195 @@ void loadGeometryObject(const pin::GeometryObject &gobj,
   Eigen::Affine3f T;
   T.setIdentity();
   T.scale(meshScale);
+  const MeshProcessOptions options = processOptions(lodLevels);
   switch (objType) {
   case OT_BVH: {
-    loadSceneMeshes(gobj.meshPath.c_str(), meshData);
+    // the mesh file cache holds the processed meshes
+    loadSceneMeshes(gobj.meshPath.c_str(), meshData, layout, options);
     break;
   }
   case OT_GEOM: {
-    meshData.push_back(loadCoalPrimitive(collgom, meshColor));
+    MeshData &md = meshData.emplace_back(
+        convertToLayout(loadCoalPrimitive(collgom, meshColor), layout));
+    processMesh(md, options);
     break;
   }
   case OT_HFIELD: {
     MeshData &md = meshData.emplace_back(loadCoalHeightField(collgom));
     md.material.baseColor = meshColor;
+    processMesh(md, options);
     break;
   }
   default:
     terminate_with_message("Unsupported object type.");
     break;
   }
-  for (auto &data : meshData) {
+  for (auto &data : meshData)
     apply3DTransformInPlace(data, T);
+}
+
+GeometryMeshes loadGeometryMeshes(const pin::GeometryObject &gobj,
+                                  const MeshLayout &layout, Uint32 lodLevels,
+                                  bool useCacheFile) {
+  GeometryMeshes out;
+  if (!useCacheFile || gobj.geometry->getObjectType() != coal::OT_BVH) {
+    loadGeometryObject(gobj, out.meshDatas, layout, lodLevels);
+  } else {
+    loadSceneMeshes(gobj.meshPath.c_str(), out.meshDatas, out.cacheFile,
+                    layout, processOptions(lodLevels));
+    const Float3 meshScale = gobj.meshScale.cast<float>();
+    const float scale = meshScale.x();
+    auto posAttr = layout.getAttribute(VertexAttrib::Position);
+    // the vertices of the mapped meshes cannot be transformed: only a scale
+    // which leaves the normals as they are is folded into the dequantization
+    const bool foldScale =
+        (meshScale.array() == 1.f).all() ||
+        (posAttr && isNormalizedFormat(posAttr->format) && scale > 0.f &&
+         (meshScale.array() == scale).all());
+    if (out.cacheFile && !foldScale) {
+      out.cacheFile->toOwned(out.meshDatas);
+      out.cacheFile.reset();
+    }
+    if (out.cacheFile) {
+      auto meshes = out.cacheFile->meshes();
+      size_t numLods = 0;
+      for (const MeshDataView &view : meshes)
+        numLods += view.lods.size();
+      // the views point into the levels of detail: no reallocation
+      out.cachedLods.reserve(numLods);
+      Mat4f S = Mat4f::Identity();
+      S.diagonal().head<3>() = meshScale;
+      for (size_t i = 0; i < meshes.size(); i++) {
+        MeshDataView &view = out.views.emplace_back(meshes[i]);
+        view.positionDequant = S * view.positionDequant;
+        const size_t first = out.cachedLods.size();
+        for (MeshLod lod : view.lods) {
+          lod.error *= scale;
+          out.cachedLods.push_back(lod);
+        }
+        view.lods = std::span{out.cachedLods}.subspan(first, view.lods.size());
+        out.materials.push_back(out.cacheFile->materials()[i]);
+      }
+      return out;
+    }
+    Eigen::Affine3f T;
+    T.setIdentity();
+    T.scale(meshScale);
+    for (auto &data : out.meshDatas)
+      apply3DTransformInPlace(data, T);
+  }
+  for (const MeshData &data : out.meshDatas) {
+    out.views.emplace_back(data);
+    out.materials.push_back(data.material);
   }
+  return out;
+}
+
+std::vector<GeometryMeshes>
+loadGeometryModel(const pin::GeometryModel &geom_model,
+                  std::span<const pin::GeomIndex> geom_ids,
+                  Uint32 num_threads, const MeshLayout &layout,
+                  Uint32 lodLevels, bool useCacheFile) {
+  const size_t count = geom_ids.size();
+  std::vector<GeometryMeshes> meshDatas;
+  meshDatas.resize(count);
+  if (count == 0)
+    return meshDatas;
+
+  if (num_threads == 0)
+    num_threads = std::max(1u, std::thread::hardware_concurrency());
+  num_threads = Uint32(std::min(size_t(num_threads), count));
+
+  // Geometry objects are claimed dynamically: their costs vary wildly (a
+  // primitive vs. a high-poly mesh file), so a static split balances poorly.
+  std::atomic_size_t next{0};
+  std::exception_ptr error;
+  std::mutex error_mutex;
+
+  auto worker = [&] {
+    size_t i;
+    while ((i = next.fetch_add(1, std::memory_order_relaxed)) < count) {
+      try {
+        meshDatas[i] =
+            loadGeometryMeshes(geom_model.geometryObjects[geom_ids[i]],
+                               layout, lodLevels, useCacheFile);
+      } catch (...) {
+        std::lock_guard lock{error_mutex};
+        if (!error)
+          error = std::current_exception();
+        // stop handing out work
+        next.store(count, std::memory_order_relaxed);
+      }
+    }
+  };
+
+  if (num_threads == 1) {
+    worker();
+  } else {
+    std::vector<std::jthread> threads;
+    threads.reserve(num_threads - 1);
+    for (Uint32 t = 0; t + 1 < num_threads; t++)
+      threads.emplace_back(worker);
+    // the calling thread takes part in the work
+    worker();
+  }
+
+  if (error)
+    std::rethrow_exception(error);
+  return meshDatas;
+}
+
+std::vector<GeometryMeshes>
+loadGeometryModel(const pin::GeometryModel &geom_model, Uint32 num_threads,
+                  const MeshLayout &layout, Uint32 lodLevels,
+                  bool useCacheFile) {
+  std::vector<pin::GeomIndex> geom_ids(geom_model.ngeoms);
+  std::iota(geom_ids.begin(), geom_ids.end(), pin::GeomIndex(0));
+  return loadGeometryModel(geom_model, geom_ids, num_threads, layout,
+                           lodLevels, useCacheFile);
+}
+
+AsyncGeometryLoader::AsyncGeometryLoader(const pin::GeometryModel &geom_model,
+                                         std::vector<pin::GeomIndex> geom_ids,
+                                         const MeshLayout &layout,
+                                         Uint32 lodLevels, bool useCacheFile)
+    : m_remaining(geom_ids.size()) {
+  // copied, as the thread may outlive the caller's GeometryModel: this shares
+  // the coal geometries, which are only read
+  std::vector<pin::GeometryObject> geom_objs;
+  geom_objs.reserve(geom_ids.size());
+  for (pin::GeomIndex geom_id : geom_ids)
+    geom_objs.push_back(geom_model.geometryObjects[geom_id]);
+
+  m_thread = std::jthread([this, geom_objs = std::move(geom_objs),
+                           geom_ids = std::move(geom_ids), layout, lodLevels,
+                           useCacheFile](std::stop_token stop) {
+    for (size_t i = 0; i < geom_ids.size(); i++) {
+      if (stop.stop_requested())
+        return;
+      Result result{geom_ids[i], {}, nullptr};
+      try {
+        result.meshes = loadGeometryMeshes(geom_objs[i], layout, lodLevels,
+                                           useCacheFile);
+      } catch (...) {
+        result.error = std::current_exception();
+      }
+      std::lock_guard lock{m_mutex};
+      m_ready.push_back(std::move(result));
+    }
+  });
+}
+
+void AsyncGeometryLoader::poll(std::vector<Result> &out) {
+  std::lock_guard lock{m_mutex};
+  m_remaining -= m_ready.size();
+  std::move(m_ready.begin(), m_ready.end(), std::back_inserter(out));
+  m_ready.clear();
+}
+
+bool AsyncGeometryLoader::done() const {
+  std::lock_guard lock{m_mutex};
+  return m_remaining == 0;
 }
 
 } // namespace candlewick::multibody
@@ -2,21 +2,157 @@
 
 #include "Multibody.h"
 #include "../utils/MeshData.h"
+#include "../utils/MeshCacheFile.h"
+#include "../utils/MeshDataView.h"
+#include "../core/DefaultVertex.h"
 
 #include <pinocchio/multibody/geometry-object.hpp>
 
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+
 namespace candlewick::multibody {
 
 /// \brief Load an invidual Pinocchio GeometryObject's component geometries into
 /// an array of \c MeshData.
-void loadGeometryObject(const pin::GeometryObject &gobj,
-                        std::vector<MeshData> &meshData);
+///
+/// Triangle meshes are reordered for the vertex cache, overdraw and vertex
+/// fetch, see optimizeMesh(). Mesh files are processed before the geometry
+/// object's scale is applied, so that the preprocessed mesh cache holds the
+/// processed meshes (see MeshProcessOptions).
+/// \param layout Vertex layout of mesh files and primitives. Heightfields keep
+/// their own layout.
+/// \param lodLevels Number of coarser levels of detail to generate for the
+/// triangle meshes, see generateLodChain(). If 0, no LOD chain is generated.
+void loadGeometryObject(
+    const pin::GeometryObject &gobj, std::vector<MeshData> &meshData,
+    const MeshLayout &layout = meshLayoutFor<DefaultVertex>(),
+    Uint32 lodLevels = 0);
 
 inline std::vector<MeshData>
-loadGeometryObject(const pin::GeometryObject &gobj) {
+loadGeometryObject(const pin::GeometryObject &gobj,
+                   const MeshLayout &layout = meshLayoutFor<DefaultVertex>(),
+                   Uint32 lodLevels = 0) {
   std::vector<MeshData> meshData;
-  loadGeometryObject(gobj, meshData);
+  loadGeometryObject(gobj, meshData, layout, lodLevels);
   return meshData;
 }
 
+/// \brief Component geometries of a GeometryObject, as loaded by
+/// loadGeometryMeshes().
+///
+/// Meshes read from an up-to-date preprocessed cache file are not copied: they
+/// are views into the file's mapping, which this object keeps alive, so that
+/// they can be uploaded straight from it. The object is move-only, and moving
+/// it keeps the views valid.
+struct GeometryMeshes {
+  /// Views of the meshes, to create and upload the GPU mesh from.
+  std::vector<MeshDataView> views;
+  std::vector<PbrMaterial> materials;
+  /// Storage of the meshes which were imported or generated.
+  std::vector<MeshData> meshDatas;
+  /// Preprocessed cache file which the other views point into, if any.
+  std::shared_ptr<const MeshCacheFile> cacheFile;
+  /// Levels of detail of the cached meshes, with their errors scaled like the
+  /// meshes.
+  std::vector<MeshLod> cachedLods;
+
+  GeometryMeshes() = default;
+  // a copy's views would point into the original's storage
+  GeometryMeshes(const GeometryMeshes &) = delete;
+  GeometryMeshes &operator=(const GeometryMeshes &) = delete;
+  GeometryMeshes(GeometryMeshes &&) noexcept = default;
+  GeometryMeshes &operator=(GeometryMeshes &&) noexcept = default;
+};
+
+/// \brief Load the component geometries of a GeometryObject, as
+/// loadGeometryObject() does.
+///
+/// \param useCacheFile Read mesh files through the preprocessed mesh cache
+/// (see loadSceneMeshes()), without copying the cached meshes when the
+/// geometry object's scale can be folded into their position dequantization:
+/// that is, when it is the identity, or when it is uniform and the layout has
+/// quantized positions. Otherwise, the cached meshes are copied and scaled.
+GeometryMeshes
+loadGeometryMeshes(const pin::GeometryObject &gobj,
+                   const MeshLayout &layout = meshLayoutFor<DefaultVertex>(),
+                   Uint32 lodLevels = 0, bool useCacheFile = false);
+
+/// \brief Load the component geometries of a subset of the GeometryObjects in
+/// a GeometryModel, using a pool of worker threads.
+///
+/// This only performs the CPU-side work (file import through assimp, format
+/// conversion, mesh transforms). The output is ordered like \p geom_ids, so
+/// that GPU resources can be created serially afterwards.
+/// \param geom_model Pinocchio geometry model.
+/// \param geom_ids Indices of the geometry objects to load.
+/// \param num_threads Number of worker threads. If 0, this uses the number of
+/// hardware threads.
+/// \param layout Vertex layout, see loadGeometryObject().
+/// \param lodLevels Number of levels of detail, see loadGeometryObject().
+/// \param useCacheFile See loadGeometryMeshes().
+/// \throws Rethrows the first exception raised by any of the workers.
+std::vector<GeometryMeshes>
+loadGeometryModel(const pin::GeometryModel &geom_model,
+                  std::span<const pin::GeomIndex> geom_ids,
+                  Uint32 num_threads = 0,
+                  const MeshLayout &layout = meshLayoutFor<DefaultVertex>(),
+                  Uint32 lodLevels = 0, bool useCacheFile = false);
+
+/// \brief Load the component geometries of every GeometryObject in a
+/// GeometryModel, using a pool of worker threads.
+/// \copydetails loadGeometryModel(const pin::GeometryModel&, std::span<const pin::GeomIndex>, Uint32, const MeshLayout&, Uint32, bool)
+std::vector<GeometryMeshes>
+loadGeometryModel(const pin::GeometryModel &geom_model, Uint32 num_threads = 0,
+                  const MeshLayout &layout = meshLayoutFor<DefaultVertex>(),
+                  Uint32 lodLevels = 0, bool useCacheFile = false);
+
+/// \brief Load the component geometries of a subset of the GeometryObjects in
+/// a GeometryModel on a background thread, handing out each object's meshes
+/// as soon as they are loaded.
+///
+/// As for loadGeometryModel(), this only performs the CPU-side work: GPU
+/// resources are created by the thread calling poll(). The loader copies the
+/// GeometryObjects it loads, so the GeometryModel may be modified or destroyed
+/// in the meantime.
+class AsyncGeometryLoader {
+public:
+  struct Result {
+    pin::GeomIndex geom_id;
+    GeometryMeshes meshes;
+    /// Exception raised while loading the object, in which case \ref
+    /// meshes is empty. Loading goes on with the next objects.
+    std::exception_ptr error;
+  };
+
+  /// \brief Start loading, in the order of \p geom_ids.
+  /// \param layout Vertex layout, see loadGeometryObject().
+  /// \param lodLevels Number of levels of detail, see loadGeometryObject().
+  /// \param useCacheFile See loadGeometryMeshes().
+  AsyncGeometryLoader(const pin::GeometryModel &geom_model,
+                      std::vector<pin::GeomIndex> geom_ids,
+                      const MeshLayout &layout, Uint32 lodLevels,
+                      bool useCacheFile = false);
+  AsyncGeometryLoader(const AsyncGeometryLoader &) = delete;
+  AsyncGeometryLoader &operator=(const AsyncGeometryLoader &) = delete;
+  /// \brief Stops loading after the current object, and joins the thread.
+  ~AsyncGeometryLoader() noexcept = default;
+
+  /// \brief Move the objects loaded, or which failed to load, since the last
+  /// call into \p out. This does not block.
+  void poll(std::vector<Result> &out);
+
+  /// \brief Whether all objects were handed out by poll().
+  bool done() const;
+
+private:
+  mutable std::mutex m_mutex;
+  std::vector<Result> m_ready;
+  size_t m_remaining;
+  // declared last: joined before the members it uses are destroyed
+  std::jthread m_thread;
+};
+
 } // namespace candlewick::multibody
@@ -28,6 +28,8 @@ entt::entity RobotDebugSystem::addFrameVelocityArrow(DebugScene &scene,
                                   std::move(mesh), std::vector{color});
   reg.emplace<PinFrameVelocityComponent>(entity, frame_id);
   reg.emplace<TransformComponent>(entity, Mat4f::Identity());
+  // updated by DebugScene::update()
+  reg.emplace<WorldBoundsComponent>(entity);
   return entity;
 }
 
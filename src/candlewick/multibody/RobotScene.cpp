@@ -4,10 +4,14 @@
 #include "../core/Components.h"
 #include "../core/errors.h"
 #include "../core/Shader.h"
-#include "../core/Components.h"
 #include "../core/TransformUniforms.h"
 #include "../core/Camera.h"
-#include "../core/errors.h"
+#include "../core/CompactVertex.h"
+#include "../core/MeshArena.h"
+#include "../primitives/Cube.h"
+#include "../utils/MeshCache.h"
+#include "../utils/MeshDataView.h"
+#include "../utils/MeshTransforms.h"
 
 #include <entt/entity/registry.hpp>
 #include <coal/BVH/BVH_model.h>
@@ -17,6 +21,9 @@
 #include <magic_enum/magic_enum_utility.hpp>
 #include <magic_enum/magic_enum_switch.hpp>
 
+#include <algorithm>
+#include <unordered_set>
+
 namespace candlewick::multibody {
 
 struct alignas(16) light_ubo_t {
@@ -73,9 +80,40 @@ void add_pipeline_tag_component(entt::registry &reg, entt::entity ent,
       type);
 }
 
+/// Box spanning the local AABB of \p geom, drawn until its meshes are loaded.
+static MeshData loadPlaceholderBox(const coal::CollisionGeometry &geom,
+                                   const MeshLayout &layout) {
+  AABB aabb = geom.aabb_local;
+  if ((aabb.min_.array() > aabb.max_.array()).any()) {
+    aabb = AABB{};
+    aabb.update({-0.05, -0.05, -0.05}, {0.05, 0.05, 0.05});
+  }
+  // the vertices are scaled before quantization, which keeps the normals of
+  // non-uniform boxes right; flat boxes get some thickness so that the scale
+  // stays invertible
+  const Float3 halfExtents =
+      (0.5f * (aabb.max_ - aabb.min_).cast<float>()).cwiseMax(1e-3f);
+  Eigen::Affine3f T = Eigen::Affine3f::Identity();
+  T.translate(aabb.center().cast<float>()).scale(halfExtents);
+  MeshData data = loadCubeSolid().toOwned();
+  apply3DTransformInPlace(data, T);
+  return convertToLayout(data, layout);
+}
+
 entt::entity RobotScene::addEnvironmentObject(MeshData &&data, Mat4f placement,
                                               PipelineType pipe_type) {
+  // triangle meshes are drawn with a single pipeline, hence a single layout
+  if (pipe_type == PIPELINE_TRIANGLEMESH &&
+      !(data.layout == m_config.mesh_layout))
+    data = convertToLayout(data, m_config.mesh_layout);
+  optimizeMesh(data);
+  if (pipe_type == PIPELINE_TRIANGLEMESH &&
+      m_config.meshlet_min_triangles > 0 &&
+      data.baseIndexCount() / 3 >= m_config.meshlet_min_triangles)
+    buildMeshlets(data);
   Mesh mesh = createMesh(device(), data);
+  if (pipe_type == PIPELINE_TRIANGLEMESH && m_config.enable_position_stream)
+    mesh.createPositionStream();
   uploadMeshToDevice(device(), mesh, data);
   entt::entity entity = m_registry.create();
   m_registry.emplace<TransformComponent>(entity, placement);
@@ -83,6 +121,8 @@ entt::entity RobotScene::addEnvironmentObject(MeshData &&data, Mat4f placement,
     m_registry.emplace<Opaque>(entity);
   // add tag type
   m_registry.emplace<EnvironmentTag>(entity);
+  m_registry.emplace<WorldBoundsComponent>(entity,
+                                           worldBounds(mesh, placement));
   m_registry.emplace<MeshMaterialComponent>(
       entity, std::move(mesh), std::vector{std::move(data.material)});
   add_pipeline_tag_component(m_registry, entity, pipe_type);
@@ -95,10 +135,31 @@ void RobotScene::clearEnvironment() {
 }
 
 void RobotScene::clearRobotGeometries() {
+  // stop loading the meshes of the destroyed entities
+  m_asyncLoad.reset();
   auto view = m_registry.view<PinGeomObjComponent>();
   m_registry.destroy(view.begin(), view.end());
 }
 
+struct RobotScene::AsyncLoadState {
+  AsyncLoadState(const pin::GeometryModel &geom_model,
+                 std::vector<pin::GeomIndex> geom_ids, const Config &config)
+      : loader(geom_model, std::move(geom_ids), config.mesh_layout,
+               config.lod_levels, config.enable_mesh_file_cache) {}
+
+  AsyncGeometryLoader loader;
+  struct Pending {
+    entt::entity entity;
+    std::optional<MeshCacheKey> cacheKey;
+  };
+  /// Geometry objects which wait on their meshes, by geometry index. The
+  /// triangle meshes are drawn as boxes meanwhile, the others are hidden.
+  std::unordered_map<pin::GeomIndex, Pending> pending;
+  std::vector<AsyncGeometryLoader::Result> results;
+};
+
+RobotScene::~RobotScene() = default;
+
 RobotScene::RobotScene(entt::registry &registry, const Renderer &renderer,
                        const pin::GeometryModel &geom_model,
                        const pin::GeometryData &geom_data, Config config)
@@ -121,50 +182,353 @@ RobotScene::RobotScene(entt::registry &registry, const Renderer &renderer,
 
   // initialize render target for GBuffer
   this->initGBuffer(renderer);
-  const bool enable_shadows = m_config.enable_shadows;
+  m_objectBuffer = std::make_unique<ObjectBuffer>(renderer.device);
+  m_drawInstanceBuffer = std::make_unique<InstanceBuffer>(renderer.device);
+  if (m_config.enable_gpu_culling) {
+    m_drawList = std::make_unique<GpuDrawList>(renderer.device);
+    m_cullOutput = std::make_unique<GpuCullOutput>(renderer.device);
+    if (m_config.enable_occlusion_culling)
+      m_hiz = std::make_unique<HiZPyramid>(renderer.device,
+                                           renderer.depth_texture.width(),
+                                           renderer.depth_texture.height());
+  }
+
+  const size_t ngeoms = geom_model.ngeoms;
+
+  // Mesh files which are already on the GPU, or which are referenced by an
+  // earlier geometry object, are loaded (and uploaded) only once.
+  MeshCache &meshCache = MeshCache::instance();
+  std::vector<std::optional<MeshCacheKey>> cacheKeys(ngeoms);
+  std::vector<MeshCache::AssetPtr> cachedAssets(ngeoms);
+  std::vector<pin::GeomIndex> toLoad;
+  std::vector<size_t> loadSlot(ngeoms, SIZE_MAX);
+  {
+    std::unordered_set<MeshCacheKey, MeshCacheKeyHash> pending;
+    for (pin::GeomIndex geom_id = 0; geom_id < ngeoms; geom_id++) {
+      const auto &geom_obj = geom_model.geometryObjects[geom_id];
+      if (m_config.enable_mesh_cache &&
+          geom_obj.geometry->getObjectType() == coal::OT_BVH) {
+        auto &key = cacheKeys[geom_id];
+        key = makeMeshCacheKey(device(), geom_obj.meshPath,
+                               geom_obj.meshScale.cast<float>(),
+                               m_config.mesh_layout,
+                               m_config.enable_position_stream,
+                               m_config.lod_levels);
+        if (key && ((cachedAssets[geom_id] = meshCache.find(*key)) ||
+                    !pending.insert(*key).second))
+          continue;
+      }
+      loadSlot[geom_id] = toLoad.size();
+      toLoad.push_back(geom_id);
+    }
+  }
+
+  // CPU-side loading (import, conversion) runs in parallel over geometry
+  // objects. GPU resources are then created in model order, and all the mesh
+  // data is uploaded at once. In async mode, loading runs in the background
+  // instead, and the geometry objects start out as placeholders.
+  const bool async = m_config.async_loading && !toLoad.empty();
+  std::vector<GeometryMeshes> allMeshes;
+  // placeholder boxes, kept alive until they are uploaded
+  std::vector<MeshData> boxDatas;
+  if (async) {
+    m_asyncLoad = std::make_unique<AsyncLoadState>(geom_model, toLoad,
+                                                   m_config);
+    boxDatas.reserve(ngeoms);
+  } else {
+    allMeshes = loadGeometryModel(geom_model, toLoad,
+                                  m_config.num_load_threads,
+                                  m_config.mesh_layout, m_config.lod_levels,
+                                  m_config.enable_mesh_file_cache);
+  }
+  std::vector<MeshView> uploadViews;
+  std::vector<MeshDataView> uploadDatas;
+
+  // One arena per mesh layout and index element size, sized for the meshes
+  // loaded here.
+  std::vector<std::shared_ptr<MeshArena>> arenas;
+  auto findArena = [&arenas](const MeshLayout &layout,
+                             SDL_GPUIndexElementSize indexElementSize) {
+    return std::find_if(arenas.begin(), arenas.end(), [&](auto &arena) {
+      return arena->layout() == layout &&
+             arena->indexElementSize() == indexElementSize;
+    });
+  };
+  if (m_config.enable_mesh_arena) {
+    struct ArenaSize {
+      MeshLayout layout;
+      SDL_GPUIndexElementSize indexElementSize;
+      Uint32 numVertices = 0, numIndices = 0;
+    };
+    std::vector<ArenaSize> sizes;
+    for (auto &meshes : allMeshes) {
+      const auto indexElementSize = batchIndexElementSize(meshes.views);
+      for (auto &data : meshes.views) {
+        auto it = std::find_if(sizes.begin(), sizes.end(), [&](auto &size) {
+          return size.layout == data.layout &&
+                 size.indexElementSize == indexElementSize;
+        });
+        if (it == sizes.end())
+          it = sizes.insert(it, {data.layout, indexElementSize});
+        it->numVertices += data.numVertices();
+        it->numIndices += data.numIndices();
+      }
+    }
+    for (auto &size : sizes) {
+      const bool positionStream = m_config.enable_position_stream &&
+                                  size.layout == m_config.mesh_layout;
+      arenas.push_back(MeshArena::create(
+          device(), size.layout, size.numVertices, size.numIndices,
+          size.indexElementSize, positionStream));
+    }
+  }
+  auto createGeometryMesh = [&](std::span<const MeshDataView> meshDatas,
+                                PipelineType pipeline_type) {
+    auto arena =
+        findArena(meshDatas[0].layout, batchIndexElementSize(meshDatas));
+    if (arena != arenas.end())
+      return createMeshFromBatch(device(), **arena, meshDatas, false);
+    Mesh mesh = createMeshFromBatch(device(), meshDatas, false);
+    if (pipeline_type == PIPELINE_TRIANGLEMESH &&
+        m_config.enable_position_stream)
+      mesh.createPositionStream();
+    return mesh;
+  };
 
-  for (pin::GeomIndex geom_id = 0; geom_id < geom_model.ngeoms; geom_id++) {
+  for (pin::GeomIndex geom_id = 0; geom_id < ngeoms; geom_id++) {
 
     const auto &geom_obj = geom_model.geometryObjects[geom_id];
-    auto meshDatas = loadGeometryObject(geom_obj);
     PipelineType pipeline_type = pinGeomToPipeline(*geom_obj.geometry);
-    auto mesh = createMeshFromBatch(device(), meshDatas, true);
+    const auto &cacheKey = cacheKeys[geom_id];
+
+    Mesh mesh{NoInit};
+    std::vector<PbrMaterial> materials;
+    bool placeholder = false;
+    MeshCache::AssetPtr asset = std::move(cachedAssets[geom_id]);
+    if (async && !asset) {
+      // box placeholder, until the meshes are loaded (by this object, or by
+      // an earlier one which uses the same mesh file)
+      const MeshData &boxData = boxDatas.emplace_back(
+          loadPlaceholderBox(*geom_obj.geometry, m_config.mesh_layout));
+      mesh = createMesh(device(), boxData);
+      if (m_config.enable_position_stream)
+        mesh.createPositionStream();
+      uploadViews.push_back(mesh.view(0));
+      uploadDatas.push_back(boxData);
+      materials = {PbrMaterial{.baseColor{0.5f, 0.5f, 0.5f, 1.f}}};
+      placeholder = true;
+    } else if (loadSlot[geom_id] != SIZE_MAX && !async) {
+      // the cached meshes are uploaded straight from their mapped files,
+      // which allMeshes keeps alive until then
+      auto &meshes = allMeshes[loadSlot[geom_id]];
+      mesh = createGeometryMesh(meshes.views, pipeline_type);
+      materials = meshes.materials;
+      for (size_t j = 0; j < meshes.views.size(); j++) {
+        uploadViews.push_back(mesh.view(j));
+        uploadDatas.push_back(meshes.views[j]);
+      }
+      if (cacheKey) {
+        asset = meshCache.insert(*cacheKey, std::move(mesh), materials);
+        mesh = shareMesh(asset);
+      }
+    } else {
+      // loaded by another scene, or by an earlier geometry object
+      if (!asset)
+        asset = meshCache.find(*cacheKey);
+      assert(asset);
+      mesh = shareMesh(asset);
+      materials = asset->materials;
+    }
     assert(validateMesh(mesh));
 
     // local copy for use
     const auto layout = mesh.layout();
+    // heightfields and point clouds are not drawn until they are loaded
+    const bool drawn = !placeholder || pipeline_type == PIPELINE_TRIANGLEMESH;
 
     // add entity for this geometry
     entt::entity entity = registry.create();
     registry.emplace<PinGeomObjComponent>(entity, geom_id);
     registry.emplace<TransformComponent>(entity);
+    // filled in by updateTransforms()
+    registry.emplace<WorldBoundsComponent>(entity);
+    registry.emplace<MeshMaterialComponent>(entity, std::move(mesh),
+                                            std::move(materials));
+    if (placeholder)
+      m_asyncLoad->pending[geom_id] = {entity, cacheKey};
+    if (!drawn)
+      continue;
     if (pipeline_type != PIPELINE_POINTCLOUD)
       registry.emplace<Opaque>(entity);
-    registry.emplace<MeshMaterialComponent>(entity, std::move(mesh),
-                                            extractMaterials(meshDatas));
     add_pipeline_tag_component(m_registry, entity, pipeline_type);
 
-    if (pipeline_type == PIPELINE_TRIANGLEMESH) {
-      if (!ssaoPass.pipeline) {
-        ssaoPass = ssao::SsaoPass(renderer, layout, gBuffer.normalMap);
-      }
-      // configure shadow pass
-      if (enable_shadows && !shadowPass.pipeline) {
-        shadowPass =
-            ShadowPassInfo::create(renderer, layout, config.shadow_config);
+    initPipelinesFor(pipeline_type, layout);
+  }
+  uploadMeshesToDevice(device(), uploadViews, uploadDatas);
+}
+
+void RobotScene::initPipelinesFor(PipelineType pipeline_type,
+                                  const MeshLayout &layout) {
+  if (pipeline_type == PIPELINE_TRIANGLEMESH) {
+    if (!ssaoPass.pipeline) {
+      ssaoPass = ssao::SsaoPass(m_renderer, layout, gBuffer.normalMap);
+    }
+    // configure shadow pass
+    if (m_config.enable_shadows && !shadowPass.pipeline) {
+      shadowPass = ShadowPassInfo::create(
+          m_renderer,
+          m_config.enable_position_stream ? positionStreamLayout(layout)
+                                          : layout,
+          m_config.shadow_config);
+      shadowPass.objectBuffer = m_objectBuffer.get();
+      shadowPass.drawList = m_drawList.get();
+    }
+    if (m_config.triangle_has_prepass && !depthPrepass.pipeline) {
+      // cull the faces the main pass culls: the depths of the others would
+      // hide what is behind them
+      const auto cull_mode =
+          m_config.pipeline_configs.at(PIPELINE_TRIANGLEMESH).cull_mode;
+      depthPrepass = DepthPassInfo::create(
+          m_renderer,
+          m_config.enable_position_stream ? positionStreamLayout(layout)
+                                          : layout,
+          nullptr,
+          {
+              .cull_mode = cull_mode,
+              .depth_bias_constant_factor = 0.f,
+              .depth_bias_slope_factor = 0.f,
+              .enable_depth_bias = false,
+              .enable_depth_clip = true,
+              // the main pass reads the model matrices from the object
+              // buffer whether or not it instances: so must the pre-pass,
+              // for the same depths
+              .enable_instancing = true,
+              .enable_gpu_culling = m_config.enable_gpu_culling,
+          });
+      // the transforms and levels of detail of the main pass, for matching
+      // depths
+      depthPrepass.objectBuffer = m_objectBuffer.get();
+      depthPrepass.drawList = m_drawList.get();
+      depthPrepass.lodPixelError = m_config.lod_pixel_error;
+      depthPrepass.sortFrontToBack = true;
+    }
+  }
+
+  if (!renderPipelines[pipeline_type]) {
+    SDL_Log("Building pipeline for type %s",
+            magic_enum::enum_name(pipeline_type).data());
+    SDL_GPUGraphicsPipeline *pipeline =
+        createPipeline(layout, m_renderer.getSwapchainTextureFormat(),
+                       m_renderer.depthFormat(), pipeline_type);
+    assert(pipeline);
+    renderPipelines[pipeline_type] = pipeline;
+  }
+  if (pipeline_type == PIPELINE_TRIANGLEMESH && m_drawList &&
+      !m_indirectPipeline) {
+    m_indirectPipeline =
+        createPipeline(layout, m_renderer.getSwapchainTextureFormat(),
+                       m_renderer.depthFormat(), pipeline_type, true);
+    assert(m_indirectPipeline);
+    m_drawRecordSlot = layout.numBuffers();
+  }
+}
+
+Uint32 RobotScene::updateAsyncLoading() {
+  if (!m_asyncLoad)
+    return 0u;
+  AsyncLoadState &state = *m_asyncLoad;
+  state.results.clear();
+  state.loader.poll(state.results);
+  if (state.results.empty())
+    return 0u;
+
+  Uint32 count = 0;
+  auto swapIn = [&](entt::entity entity, PipelineType pipeline_type,
+                    Mesh &&mesh, std::vector<PbrMaterial> &&materials) {
+    if (!m_registry.valid(entity))
+      return;
+    initPipelinesFor(pipeline_type, mesh.layout());
+    m_registry.replace<MeshMaterialComponent>(entity, std::move(mesh),
+                                              std::move(materials));
+    // only the triangle meshes were drawn as placeholders
+    if (pipeline_type != PIPELINE_TRIANGLEMESH) {
+      add_pipeline_tag_component(m_registry, entity, pipeline_type);
+      if (pipeline_type != PIPELINE_POINTCLOUD)
+        m_registry.emplace<Opaque>(entity);
+    }
+    count++;
+  };
+
+  MeshCache &meshCache = MeshCache::instance();
+  const pin::GeometryModel &geom_model = m_geomModel;
+  for (auto &[geom_id, meshes, error] : state.results) {
+    const auto &geom_obj = geom_model.geometryObjects[geom_id];
+    if (error) {
+      try {
+        std::rethrow_exception(error);
+      } catch (const std::exception &e) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                     "Failed to load geometry object '%s': %s",
+                     geom_obj.name.c_str(), e.what());
+      } catch (...) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                     "Failed to load geometry object '%s'.",
+                     geom_obj.name.c_str());
       }
+      // this object, and those waiting on its mesh file, keep their
+      // placeholders
+      const auto cacheKey = state.pending.at(geom_id).cacheKey;
+      std::erase_if(state.pending, [&](const auto &entry) {
+        return entry.first == geom_id ||
+               (cacheKey && entry.second.cacheKey == cacheKey);
+      });
+      continue;
     }
+    const PipelineType pipeline_type = pinGeomToPipeline(*geom_obj.geometry);
+    Mesh mesh = createMeshFromBatch(device(), meshes.views, false);
+    if (pipeline_type == PIPELINE_TRIANGLEMESH &&
+        m_config.enable_position_stream)
+      mesh.createPositionStream();
+    // staged through the upload ring: this does not wait on the GPU
+    uploadMeshesToDevice(device(), mesh.views(), meshes.views);
+    std::vector<PbrMaterial> materials = std::move(meshes.materials);
 
-    if (!renderPipelines[pipeline_type]) {
-      SDL_Log("Building pipeline for type %s",
-              magic_enum::enum_name(pipeline_type).data());
-      SDL_GPUGraphicsPipeline *pipeline =
-          createPipeline(layout, renderer.getSwapchainTextureFormat(),
-                         renderer.depthFormat(), pipeline_type);
-      assert(pipeline);
-      renderPipelines[pipeline_type] = pipeline;
+    auto node = state.pending.extract(geom_id);
+    assert(!node.empty());
+    const AsyncLoadState::Pending &pending = node.mapped();
+    if (pending.cacheKey) {
+      auto asset =
+          meshCache.insert(*pending.cacheKey, std::move(mesh), materials);
+      mesh = shareMesh(asset);
     }
+    swapIn(pending.entity, pipeline_type, std::move(mesh),
+           std::move(materials));
   }
+
+  // objects which share the mesh file of one loaded above
+  for (auto it = state.pending.begin(); it != state.pending.end();) {
+    const AsyncLoadState::Pending &pending = it->second;
+    auto asset =
+        pending.cacheKey ? meshCache.find(*pending.cacheKey) : nullptr;
+    if (!asset) {
+      ++it;
+      continue;
+    }
+    const auto &geom_obj = geom_model.geometryObjects[it->first];
+    swapIn(pending.entity, pinGeomToPipeline(*geom_obj.geometry),
+           shareMesh(asset), std::vector{asset->materials});
+    it = state.pending.erase(it);
+  }
+
+  if (state.pending.empty()) {
+    SDL_Log("Finished loading %zu geometry objects.",
+            size_t(geom_model.ngeoms));
+    m_asyncLoad.reset();
+  }
+  // the swapped meshes may keep the addresses of their placeholders
+  if (count > 0)
+    shadowPass.cache.invalidate();
+  return count;
 }
 
 void RobotScene::initGBuffer(const Renderer &renderer) {
@@ -197,6 +561,49 @@ void updateRobotTransforms(entt::registry &registry,
 
 void RobotScene::updateTransforms() {
   ::candlewick::multibody::updateRobotTransforms(m_registry, m_geomData);
+  updateWorldBounds<MeshMaterialComponent>(m_registry);
+}
+
+void RobotScene::uploadObjectData(CommandBuffer &command_buffer) {
+  auto all_view =
+      m_registry.view<const TransformComponent, const MeshMaterialComponent,
+                      pipeline_tag_component<PIPELINE_TRIANGLEMESH>>(
+          entt::exclude<Disable>);
+
+  m_objectBuffer->clear();
+  m_objectMaterials.clear();
+  std::ranges::fill(m_objectIndices, ObjectBuffer::kNoObject);
+  for (auto [ent, tr, obj] : all_view.each()) {
+    const size_t id = entt::to_entity(ent);
+    if (id >= m_objectIndices.size())
+      m_objectIndices.resize(id + 1, ObjectBuffer::kNoObject);
+    m_objectIndices[id] =
+        m_objectBuffer->addObject(tr * obj.mesh.positionDequant, tr);
+    m_objectMaterials.push_back(m_objectBuffer->numMaterials());
+    for (const PbrMaterial &material : obj.materials)
+      m_objectBuffer->addMaterial(material);
+  }
+  m_objectBuffer->upload(command_buffer);
+
+  // the material indices are known once all objects are added
+  if (m_drawList) {
+    m_drawList->clear();
+    for (auto [ent, tr, obj] : all_view.each()) {
+      const Uint32 object = m_objectIndices[entt::to_entity(ent)];
+      m_drawList->addDraws(
+          obj.mesh, object,
+          m_objectBuffer->materialIndex(m_objectMaterials[object]));
+    }
+    m_drawList->upload(command_buffer);
+  }
+  m_objectDataUploaded = true;
+}
+
+Uint32 RobotScene::objectIndex(entt::entity entity) const {
+  const size_t id = entt::to_entity(entity);
+  if (!m_objectDataUploaded || id >= m_objectIndices.size())
+    return ObjectBuffer::kNoObject;
+  return m_objectIndices[id];
 }
 
 void RobotScene::collectOpaqueCastables() {
@@ -211,17 +618,54 @@ void RobotScene::collectOpaqueCastables() {
   // collect castable objects
   for (auto [ent, tr, meshMaterial] : all_view.each()) {
     const Mesh &mesh = meshMaterial.mesh;
-    m_castables.emplace_back(ent, mesh, tr);
+    // environment objects do not move
+    m_castables.emplace_back(ent, mesh, tr, objectIndex(ent),
+                             m_registry.all_of<EnvironmentTag>(ent));
   }
 }
 
+float RobotScene::viewDepth(const Camera &camera, entt::entity entity,
+                            const Mat4f &transform) const {
+  const auto *bounds = m_registry.try_get<WorldBoundsComponent>(entity);
+  const Float3 center = bounds && !bounds->isEmpty()
+                            ? Float3{bounds->center()}
+                            : Float3{transform.topRightCorner<3, 1>()};
+  return -(camera.view * center).z();
+}
+
+void RobotScene::beginDrawQueue() {
+  m_renderQueue.clear();
+  m_drawTransforms.clear();
+  m_drawRunRanges.clear();
+  m_drawRuns.clear();
+}
+
 void RobotScene::render(CommandBuffer &command_buffer, const Camera &camera) {
+  m_renderStats = {};
+  // unless uploaded for the earlier passes of the frame
+  if (!m_objectDataUploaded)
+    uploadObjectData(command_buffer);
+  if (m_config.triangle_has_prepass)
+    renderDepthPrepass(command_buffer, camera);
   if (m_config.enable_ssao) {
     ssaoPass.render(command_buffer, camera);
   }
 
   renderPBRTriangleGeometry(command_buffer, camera);
   renderOtherGeometry(command_buffer, camera);
+  m_objectDataUploaded = false;
+}
+
+void RobotScene::renderDepthPrepass(CommandBuffer &command_buffer,
+                                    const Camera &camera) {
+  m_prepassStats = {};
+  if (!depthPrepass.pipeline)
+    return;
+  // the castables of the frame, with their object indices
+  collectOpaqueCastables();
+  depthPrepass.lodViewportHeight = float(m_renderer.window.size()[1]);
+  m_prepassStats = renderDepthOnlyPass(command_buffer, depthPrepass,
+                                       camera.viewProj(), m_castables);
 }
 
 /// Function private to this translation unit.
@@ -270,6 +714,97 @@ enum FragmentSamplerSlots {
   SSAO_SLOT,
 };
 
+/// Uniform slots of the triangle mesh shaders, see PbrBasicInstanced.vert and
+/// PbrBasicInstanced.frag.
+enum TriangleVertexUniformSlots : Uint32 { PASS_SLOT = 0, DRAW_SLOT = 1 };
+enum TriangleFragmentUniformSlots : Uint32 {
+  LIGHT_SLOT = 0,
+  EFFECTS_SLOT = 1,
+  SHADOW_SLOT = 2,
+};
+
+void RobotScene::queueTriangleDraws(CommandBuffer &command_buffer,
+                                    const Camera &camera) {
+  const Mat4f viewProj = camera.viewProj();
+  const float viewportHeight = float(m_renderer.window.size()[1]);
+
+  auto *pipeline = renderPipelines[PIPELINE_TRIANGLEMESH];
+  // normal cones only cull meshlets whose back faces are not drawn
+  const bool coneCulling =
+      m_config.pipeline_configs.at(PIPELINE_TRIANGLEMESH).cull_mode ==
+      SDL_GPU_CULLMODE_BACK;
+
+  auto all_view =
+      m_registry.view<const TransformComponent, const MeshMaterialComponent,
+                      pipeline_tag_component<PIPELINE_TRIANGLEMESH>>(
+          entt::exclude<Disable>);
+  const auto frustum = FrustumPlanes::fromClipMatrix(viewProj);
+  beginDrawQueue();
+  for (entt::entity ent : m_culler.cull(m_registry, all_view, frustum)) {
+    // draws are indexed by object in the object buffer
+    const Uint32 object = objectIndex(ent);
+    if (object == ObjectBuffer::kNoObject)
+      continue;
+    const auto &tr = all_view.get<const TransformComponent>(ent);
+    const auto &obj = all_view.get<const MeshMaterialComponent>(ent);
+    const Mesh &mesh = obj.mesh;
+    const Mat4f model = tr * mesh.positionDequant;
+    const float depth = viewDepth(camera, ent, tr);
+    const Uint32 lod = selectLod(mesh, viewProj, tr, viewportHeight,
+                                 m_config.lod_pixel_error);
+    const auto views = mesh.lodViews(lod);
+    // meshlets partition the full-detail level
+    const bool meshletCulling = lod == 0 && mesh.hasMeshlets();
+    FrustumPlanes localFrustum;
+    Float3 cameraPos;
+    if (meshletCulling) {
+      localFrustum = FrustumPlanes::fromClipMatrix(viewProj * tr);
+      cameraPos = (tr.inverse() * camera.position().homogeneous()).head<3>();
+    }
+    for (size_t j = 0; j < views.size(); j++) {
+      // the views of batched meshes are culled one by one
+      if (views.size() > 1 &&
+          !frustum.intersectsBox(transformBox(mesh.viewBounds(j), model)))
+        continue;
+      // zero for whole views, else one past the index of the meshlet runs
+      Uint32 runs = 0;
+      if (meshletCulling && !mesh.meshlets(j).empty()) {
+        if (cullMeshlets(mesh.meshlets(j), localFrustum,
+                         coneCulling ? &cameraPos : nullptr,
+                         m_meshletRuns) == 0)
+          continue;
+        m_drawRunRanges.emplace_back(m_drawRuns.size(), m_meshletRuns.size());
+        m_drawRuns.insert(m_drawRuns.end(), m_meshletRuns.begin(),
+                          m_meshletRuns.end());
+        runs = Uint32(m_drawRunRanges.size());
+      }
+      m_renderQueue.push(pipeline, mesh, lod, Uint32(j), obj.materials[j],
+                         object, depth, runs);
+    }
+  }
+  if (m_config.enable_instancing)
+    m_renderQueue.mergeInstances(pipeline, m_config.instancing_min_count);
+  m_renderQueue.sort();
+
+  // the object and material of each instance, uploaded before the render pass
+  m_drawInstances.clear();
+  m_drawFirstInstances.clear();
+  for (const DrawPacket &packet : m_renderQueue.packets()) {
+    m_drawFirstInstances.push_back(Uint32(m_drawInstances.size()));
+    const auto objects =
+        packet.isInstanced()
+            ? m_renderQueue.instanceObjects().subspan(packet.firstInstance,
+                                                      packet.instanceCount)
+            : std::span{&packet.object, 1};
+    for (Uint32 object : objects) {
+      const Uint32 material = m_objectBuffer->materialIndex(
+          m_objectMaterials[object] + packet.viewIndex);
+      m_drawInstances.push_back({object, material});
+    }
+  }
+  m_drawInstanceBuffer->upload(command_buffer, std::span{m_drawInstances});
+}
+
 void RobotScene::renderPBRTriangleGeometry(CommandBuffer &command_buffer,
                                            const Camera &camera) {
 
@@ -287,8 +822,17 @@ void RobotScene::renderPBRTriangleGeometry(CommandBuffer &command_buffer,
   };
 
   const bool enable_shadows = m_config.enable_shadows;
-  const Mat4f lightViewProj = shadowPass.cam.viewProj();
   const Mat4f viewProj = camera.viewProj();
+  // the draws are either culled on the GPU, or culled on the CPU and sorted
+  const bool gpuCulling =
+      m_drawList && m_indirectPipeline && !m_drawList->empty();
+  if (gpuCulling) {
+    m_drawList->cull(command_buffer, *m_objectBuffer,
+                     FrustumPlanes::fromClipMatrix(viewProj), *m_cullOutput,
+                     m_hiz.get());
+  } else {
+    queueTriangleDraws(command_buffer, camera);
+  }
 
   // this is the first render pass, hence:
   // clear the color texture (swapchain), either load or clear the depth texture
@@ -297,6 +841,10 @@ void RobotScene::renderPBRTriangleGeometry(CommandBuffer &command_buffer,
                     m_config.triangle_has_prepass ? SDL_GPU_LOADOP_LOAD
                                                   : SDL_GPU_LOADOP_CLEAR,
                     m_config.enable_normal_target, gBuffer);
+  if (!gpuCulling && m_drawInstances.empty()) {
+    SDL_EndGPURenderPass(render_pass);
+    return;
+  }
 
   if (enable_shadows) {
     rend::bindFragmentSamplers(render_pass, SHADOW_MAP_SLOT,
@@ -310,41 +858,60 @@ void RobotScene::renderPBRTriangleGeometry(CommandBuffer &command_buffer,
                                  .texture = ssaoPass.ssaoMap,
                                  .sampler = ssaoPass.texSampler,
                              }});
+  m_objectBuffer->bindVertex(render_pass, 0);
+  if (!gpuCulling)
+    m_drawInstanceBuffer->bindVertex(render_pass, 1);
+  m_objectBuffer->bindFragment(render_pass, 0);
+
+  // the only uniforms pushed per draw are the first instances
+  const ObjectPassUniformData passUbo{
+      .view = camera.view.matrix(),
+      .viewProj = viewProj,
+      .lightViewProj = shadowPass.cam.viewProj(),
+  };
   int _useSsao = m_config.enable_ssao;
+  // no cascades when shadows are disabled
+  const ShadowCascadeUniforms shadowUbo =
+      enable_shadows ? shadowPass.cascadeUniforms(camera)
+                     : ShadowCascadeUniforms{};
   command_buffer
-      .pushFragmentUniform(FragmentUniformSlots::LIGHTING, &lightUbo,
-                           sizeof(lightUbo))
-      .pushFragmentUniform(2, &_useSsao, sizeof(_useSsao));
+      .pushVertexUniform(PASS_SLOT, &passUbo, sizeof(passUbo))
+      .pushFragmentUniform(LIGHT_SLOT, &lightUbo, sizeof(lightUbo))
+      .pushFragmentUniform(EFFECTS_SLOT, &_useSsao, sizeof(_useSsao))
+      .pushFragmentUniform(SHADOW_SLOT, &shadowUbo, sizeof(shadowUbo));
 
-  auto *pipeline = renderPipelines[PIPELINE_TRIANGLEMESH];
-  assert(pipeline);
-  SDL_BindGPUGraphicsPipeline(render_pass, pipeline);
+  if (gpuCulling) {
+    SDL_BindGPUGraphicsPipeline(render_pass, m_indirectPipeline);
+    m_renderStats.pipelineBinds++;
+    m_renderStats.draws +=
+        m_drawList->draw(render_pass, *m_cullOutput, m_drawRecordSlot);
+    m_renderStats.gpuCulled += m_drawList->size();
+    SDL_EndGPURenderPass(render_pass);
+    // occludes the draws of the next frame
+    if (m_hiz)
+      m_hiz->build(command_buffer, m_renderer.depth_texture, viewProj);
+    return;
+  }
 
-  auto all_view =
-      m_registry.view<const TransformComponent, const MeshMaterialComponent,
-                      pipeline_tag_component<PIPELINE_TRIANGLEMESH>>(
-          entt::exclude<Disable>);
-  for (auto [ent, tr, obj] : all_view.each()) {
-    const Mat4f modelView = camera.view * tr;
-    const Mesh &mesh = obj.mesh;
-    Mat4f mvp = viewProj * tr;
-    TransformUniformData data{
-        .modelView = modelView,
-        .mvp = mvp,
-        .normalMatrix = math::computeNormalMatrix(modelView),
-    };
-    command_buffer.pushVertexUniform(VertexUniformSlots::TRANSFORM, &data,
-                                     sizeof(data));
-    if (enable_shadows) {
-      Mat4f lightMvp = lightViewProj * tr;
-      command_buffer.pushVertexUniform(1, &lightMvp, sizeof(lightMvp));
+  DrawStateTracker state{render_pass, m_renderStats};
+  const auto packets = m_renderQueue.packets();
+  for (size_t i = 0; i < packets.size(); i++) {
+    const DrawPacket &packet = packets[i];
+    const Mesh &mesh = *packet.mesh;
+    state.bindPipeline(packet.pipeline);
+    state.bindMesh(mesh);
+    command_buffer.pushVertexUniform(DRAW_SLOT, &m_drawFirstInstances[i],
+                                     sizeof(Uint32));
+    const MeshView &view = mesh.lodViews(packet.lod)[packet.viewIndex];
+    state.countDraw(packet.instanceCount);
+    if (packet.payload == 0) {
+      rend::drawView(render_pass, view, packet.instanceCount);
+      continue;
     }
-    rend::bindMesh(render_pass, mesh);
-    for (size_t j = 0; j < mesh.numViews(); j++) {
-      const auto material = obj.materials[j];
-      command_buffer.pushFragmentUniform(FragmentUniformSlots::MATERIAL,
-                                         &material, sizeof(material));
-      rend::drawView(render_pass, mesh.view(j));
+    const auto [first, count] = m_drawRunRanges[packet.payload - 1];
+    for (size_t k = first; k < first + count; k++) {
+      const auto [firstIndex, indexCount] = m_drawRuns[k];
+      rend::drawViewIndices(render_pass, view, firstIndex, indexCount);
     }
   }
 
@@ -358,6 +925,8 @@ void RobotScene::renderOtherGeometry(CommandBuffer &command_buffer,
                     SDL_GPU_LOADOP_LOAD, false, gBuffer);
 
   const Mat4f viewProj = camera.viewProj();
+  const auto frustum = FrustumPlanes::fromClipMatrix(viewProj);
+  beginDrawQueue();
 
   // iterate over primitive types in the keys
   magic_enum::enum_for_each<PipelineType>([&](auto current_pipeline_type) {
@@ -365,25 +934,44 @@ void RobotScene::renderOtherGeometry(CommandBuffer &command_buffer,
       return;
 
     auto *pipeline = renderPipelines[current_pipeline_type];
-    SDL_BindGPUGraphicsPipeline(render_pass, pipeline);
 
     auto env_view =
         m_registry.view<const TransformComponent, const MeshMaterialComponent,
                         pipeline_tag_component<current_pipeline_type>>(
             entt::exclude<Disable>);
-    for (auto [entity, tr, obj] : env_view.each()) {
-      auto &modelMat = tr;
-      const Mesh &mesh = obj.mesh;
-      const Mat4f mvp = viewProj * modelMat;
-      const auto &color = obj.materials[0].baseColor;
-      command_buffer
-          .pushVertexUniform(VertexUniformSlots::TRANSFORM, &mvp, sizeof(mvp))
-          .pushFragmentUniform(FragmentUniformSlots::MATERIAL, &color,
-                               sizeof(color));
-      rend::bindMesh(render_pass, mesh);
-      rend::draw(render_pass, mesh);
+    for (entt::entity ent : m_culler.cull(m_registry, env_view, frustum)) {
+      const auto &tr = env_view.template get<const TransformComponent>(ent);
+      const auto &obj = env_view.template get<const MeshMaterialComponent>(ent);
+      const Uint32 object = Uint32(m_drawTransforms.size());
+      m_drawTransforms.push_back(tr);
+      const float depth = viewDepth(camera, ent, tr);
+      // all views are drawn in the color of the first material
+      for (Uint32 j = 0; j < obj.mesh.numViews(); j++)
+        m_renderQueue.push(pipeline, obj.mesh, 0, j, obj.materials[0], object,
+                           depth);
     }
   });
+
+  m_renderQueue.sort();
+  DrawStateTracker state{render_pass, m_renderStats};
+  for (const DrawPacket &packet : m_renderQueue.packets()) {
+    const Mesh &mesh = *packet.mesh;
+    state.bindPipeline(packet.pipeline);
+    if (state.changeObject(packet.object)) {
+      const Mat4f mvp =
+          viewProj * m_drawTransforms[packet.object] * mesh.positionDequant;
+      command_buffer.pushVertexUniform(VertexUniformSlots::TRANSFORM, &mvp,
+                                       sizeof(mvp));
+    }
+    state.bindMesh(mesh);
+    if (state.changeMaterial(packet.materialId)) {
+      const auto &color = m_renderQueue.material(packet.materialId).baseColor;
+      command_buffer.pushFragmentUniform(FragmentUniformSlots::MATERIAL,
+                                         &color, sizeof(color));
+    }
+    state.countDraw();
+    rend::drawView(render_pass, mesh.view(packet.viewIndex));
+  }
   SDL_EndGPURenderPass(render_pass);
 }
 
@@ -391,27 +979,54 @@ void RobotScene::release() {
   if (!device())
     return;
 
+  m_asyncLoad.reset();
   m_registry.clear<MeshMaterialComponent>();
 
   for (auto &pipeline : renderPipelines) {
     SDL_ReleaseGPUGraphicsPipeline(device(), pipeline);
     pipeline = nullptr;
   }
+  if (m_indirectPipeline) {
+    SDL_ReleaseGPUGraphicsPipeline(device(), m_indirectPipeline);
+    m_indirectPipeline = nullptr;
+  }
+  m_objectBuffer->release();
+  m_drawInstanceBuffer->release();
+  if (m_drawList) {
+    m_drawList->release();
+    m_cullOutput->release();
+  }
+  if (m_hiz)
+    m_hiz->release();
 
   gBuffer.normalMap.destroy();
   ssaoPass.release();
   shadowPass.release();
+  depthPrepass.release();
 }
 
 SDL_GPUGraphicsPipeline *RobotScene::createPipeline(
     const MeshLayout &layout, SDL_GPUTextureFormat render_target_format,
-    SDL_GPUTextureFormat depth_stencil_format, PipelineType type) {
+    SDL_GPUTextureFormat depth_stencil_format, PipelineType type,
+    bool indirect) {
 
   SDL_assert(validateMeshLayout(layout));
 
   const PipelineConfig &pipe_config = m_config.pipeline_configs.at(type);
-  auto vertexShader =
-      Shader::fromMetadata(device(), pipe_config.vertex_shader_path);
+  const char *vertex_shader_path = pipe_config.vertex_shader_path;
+  const char *compact_vertex_shader_path =
+      pipe_config.compact_vertex_shader_path;
+  if (indirect) {
+    SDL_assert(pipe_config.indirect_vertex_shader_path);
+    vertex_shader_path = pipe_config.indirect_vertex_shader_path;
+    compact_vertex_shader_path =
+        pipe_config.compact_indirect_vertex_shader_path;
+  }
+  if (compact_vertex_shader_path && hasOctahedralNormals(layout))
+    vertex_shader_path = compact_vertex_shader_path;
+  // must stay in scope until the pipeline is created
+  const MeshLayout vertex_layout = indirect ? drawRecordLayout(layout) : layout;
+  auto vertexShader = Shader::fromMetadata(device(), vertex_shader_path);
   auto fragmentShader =
       Shader::fromMetadata(device(), pipe_config.fragment_shader_path);
 
@@ -434,7 +1049,7 @@ SDL_GPUGraphicsPipeline *RobotScene::createPipeline(
   SDL_GPUGraphicsPipelineCreateInfo desc{
       .vertex_shader = vertexShader,
       .fragment_shader = fragmentShader,
-      .vertex_input_state = layout,
+      .vertex_input_state = vertex_layout,
       .primitive_type = getPrimitiveTopologyForType(type),
       .depth_stencil_state{
           .compare_op = depth_compare_op,
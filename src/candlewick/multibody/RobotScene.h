@@ -6,10 +6,19 @@
 #include "../core/LightUniforms.h"
 #include "../core/Collision.h"
 #include "../core/DepthAndShadowPass.h"
+#include "../core/FrustumCuller.h"
+#include "../core/GpuDrawList.h"
+#include "../core/HiZPyramid.h"
+#include "../core/RenderQueue.h"
+#include "../core/ObjectBuffer.h"
+#include "../core/TransformUniforms.h"
 #include "../core/Texture.h"
+#include "../core/DefaultVertex.h"
 #include "../posteffects/SSAO.h"
 #include "../utils/MeshData.h"
 #include <magic_enum/magic_enum.hpp>
+#include <array>
+#include <memory>
 
 #include <entt/entity/fwd.hpp>
 #include <coal/fwd.hh>
@@ -53,10 +62,23 @@ namespace multibody {
 
     template <PipelineType t> struct pipeline_tag_component {};
 
+    /// \brief Shaders and rasterizer state of a pipeline type.
+    ///
+    /// The shaders of triangle meshes read the transforms and materials from
+    /// objectBuffer(), with the interface of `PbrBasicInstanced.vert` and
+    /// `PbrBasicInstanced.frag`.
     struct PipelineConfig {
       // shader set
       const char *vertex_shader_path;
       const char *fragment_shader_path;
+      /// Vertex shader for mesh layouts with octahedral-encoded normals, see
+      /// CompactVertex. If null, use \ref vertex_shader_path.
+      const char *compact_vertex_shader_path = nullptr;
+      /// Vertex shaders of the indirect draws of gpuDrawList(), which read
+      /// the object and material of each draw as per-instance attributes
+      /// (see `PbrBasicIndirect.vert`).
+      const char *indirect_vertex_shader_path = nullptr;
+      const char *compact_indirect_vertex_shader_path = nullptr;
       SDL_GPUCullMode cull_mode = SDL_GPU_CULLMODE_BACK;
       SDL_GPUFillMode fill_mode = SDL_GPU_FILLMODE_FILL;
     };
@@ -64,8 +86,12 @@ namespace multibody {
       std::unordered_map<PipelineType, PipelineConfig> pipeline_configs = {
           {PIPELINE_TRIANGLEMESH,
            {
-               .vertex_shader_path = "PbrBasic.vert",
-               .fragment_shader_path = "PbrBasic.frag",
+               .vertex_shader_path = "PbrBasicInstanced.vert",
+               .fragment_shader_path = "PbrBasicInstanced.frag",
+               .compact_vertex_shader_path = "PbrBasicCompactInstanced.vert",
+               .indirect_vertex_shader_path = "PbrBasicIndirect.vert",
+               .compact_indirect_vertex_shader_path =
+                   "PbrBasicCompactIndirect.vert",
            }},
           {PIPELINE_HEIGHTFIELD,
            {
@@ -77,21 +103,140 @@ namespace multibody {
       bool enable_msaa = false;
       bool enable_shadows = true;
       bool enable_ssao = true;
+      /// Whether render() draws the depths of the triangle meshes in a depth
+      /// pre-pass, \ref depthPrepass, before SSAO and the main pass. The
+      /// pre-pass draws the position streams, front to back, and the main
+      /// pass then tests against its depths without writing them, so that
+      /// the PBR fragment shader runs about once per pixel. SSAO reads the
+      /// depths of the current frame.
       bool triangle_has_prepass = false;
       bool enable_normal_target = false;
       SDL_GPUSampleCount msaa_samples = SDL_GPU_SAMPLECOUNT_1;
       ShadowPassConfig shadow_config;
+      /// Number of threads used to load the geometry objects' meshes.
+      /// If 0, use the number of hardware threads.
+      Uint32 num_load_threads = 0;
+      /// Share the GPU meshes of geometry objects which use the same mesh file
+      /// (and scale), including across scenes. \sa MeshCache
+      bool enable_mesh_cache = true;
+      /// Read the mesh files of geometry objects from their preprocessed cache
+      /// files, writing them on first import, and upload the meshes straight
+      /// from the mapped files. Off by default, as the files are written to
+      /// the user's cache directory. \sa MeshCacheFile, meshCacheDirectory()
+      bool enable_mesh_file_cache = false;
+      /// Allocate the geometry objects' meshes from one MeshArena per mesh
+      /// layout, so that render passes bind the vertex and index buffers once.
+      bool enable_mesh_arena = false;
+      /// Vertex layout of the triangle meshes (geometry objects and
+      /// environment objects). Mesh files are imported with only the
+      /// attributes of this layout. Compact layouts such as
+      /// meshLayoutFor<CompactVertex>() further reduce the vertex memory and
+      /// bandwidth.
+      MeshLayout mesh_layout = meshLayoutFor<PosNormalVertex>();
+      /// Give the triangle meshes a position-only vertex stream, which the
+      /// shadow pass binds instead of the full vertices.
+      /// \sa Mesh::positionBuffer
+      bool enable_position_stream = true;
+      /// Number of coarser levels of detail generated for the triangle meshes
+      /// of geometry objects, when they are loaded. \sa generateLodChain()
+      Uint32 lod_levels = 3;
+      /// Largest simplification error, in pixels, of the levels of detail drawn
+      /// by the main pass. If 0, meshes are always drawn at full detail. The
+      /// shadow pass has its own threshold, see ShadowPassConfig.
+      /// \sa selectLod()
+      float lod_pixel_error = 1.f;
+      /// Partition the environment objects with at least this many triangles
+      /// into meshlets, which the main pass culls against the view frustum
+      /// and, with back-face culling, their normal cones. If 0, environment
+      /// objects are always drawn whole. \sa buildMeshlets()
+      Uint32 meshlet_min_triangles = 4096;
+      /// Load the meshes of the geometry objects on a background thread, so
+      /// that the constructor does not wait on mesh import. Until its meshes
+      /// are uploaded, each triangle mesh geometry object is drawn as a box
+      /// placeholder, from the local AABB of its coal geometry; heightfields
+      /// and point clouds are hidden. Meshes are swapped in by
+      /// updateAsyncLoading(). Mesh arenas are not used in this mode. Geometry
+      /// objects whose meshes fail to load keep their placeholders, and the
+      /// error is logged.
+      bool async_loading = false;
+      /// Draw the triangle meshes which share a mesh view and material with
+      /// at least \ref instancing_min_count - 1 others in one instanced draw.
+      /// The depth pre-pass draws from the object buffer either way, so that
+      /// its depths match those of the main pass. \sa objectBuffer()
+      bool enable_instancing = true;
+      Uint32 instancing_min_count = 2;
+      /// Cull the triangle meshes on the GPU, with a compute pass, and draw
+      /// them with indirect draws: the CPU no longer culls, sorts or submits
+      /// the draws of each object. Meshes are drawn at full detail, without
+      /// meshlet culling. Allocating them from mesh arenas brings the draw
+      /// calls down to one per arena. The shadow pass also draws the list if
+      /// ShadowPassConfig::enable_gpu_culling is set. \sa gpuDrawList()
+      bool enable_gpu_culling = false;
+      /// With GPU culling, also cull the triangle meshes hidden behind the
+      /// depths of the previous frame, tested against their Hi-Z pyramid.
+      /// Meshes which come into view from behind others show up one frame
+      /// late. \sa HiZPyramid
+      bool enable_occlusion_culling = false;
     };
 
     RobotScene(entt::registry &registry, const Renderer &renderer,
                const pin::GeometryModel &geom_model,
                const pin::GeometryData &geom_data, Config config);
+    ~RobotScene();
+
+    /// \brief Create the GPU meshes of the geometry objects loaded in the
+    /// background since the last call, and swap them in place of their
+    /// placeholders. Call this once per frame, before rendering.
+    /// \returns The number of geometry objects which were swapped in.
+    /// \sa Config::async_loading
+    Uint32 updateAsyncLoading();
+
+    /// \brief Whether some geometry objects are still waiting on their
+    /// meshes, drawn as placeholders.
+    bool isLoading() const { return m_asyncLoad != nullptr; }
 
     void updateTransforms();
 
+    /// \brief Gather the transforms and materials of the triangle meshes in
+    /// objectBuffer(), and upload them.
+    ///
+    /// Call this once per frame, after updateTransforms() and before the
+    /// passes which read the object buffer: collectOpaqueCastables() then
+    /// gives the castables their object index. Otherwise, render() calls it.
+    void uploadObjectData(CommandBuffer &command_buffer);
+
+    /// \brief Per-frame transforms and materials of the triangle meshes,
+    /// read by the main pass, and by the depth and shadow passes.
+    const ObjectBuffer &objectBuffer() const { return *m_objectBuffer; }
+
+    /// \brief Draws of the views of the triangle meshes, culled on the GPU,
+    /// or null unless Config::enable_gpu_culling is set. Rebuilt with the
+    /// object data. \sa uploadObjectData()
+    const GpuDrawList *gpuDrawList() const { return m_drawList.get(); }
+
+    /// \brief Counters of the GPU culling of the main pass, read back
+    /// GpuCullOutput::kReadbackFrames frames late. Empty unless
+    /// Config::enable_gpu_culling is set.
+    GpuCullStats gpuCullStats() const {
+      return m_cullOutput ? m_cullOutput->stats() : GpuCullStats{};
+    }
+
+    /// \brief Index of an entity in objectBuffer(), or
+    /// ObjectBuffer::kNoObject if the object data of the frame is not uploaded
+    /// or does not include it.
+    Uint32 objectIndex(entt::entity entity) const;
+
     void collectOpaqueCastables();
     const std::vector<OpaqueCastable> &castables() const { return m_castables; }
 
+    /// \brief State changes of the draws of the last render(), and those the
+    /// sorted render queue saved.
+    const RenderQueueStats &renderStats() const { return m_renderStats; }
+
+    /// \brief Castables drawn by the depth pre-pass of the last render().
+    /// \sa Config::triangle_has_prepass
+    const DepthPassStats &prepassStats() const { return m_prepassStats; }
+
     entt::entity
     addEnvironmentObject(MeshData &&data, Mat4f placement,
                          PipelineType pipe_type = PIPELINE_TRIANGLEMESH);
@@ -105,13 +250,23 @@ namespace multibody {
     void clearEnvironment();
     void clearRobotGeometries();
 
-    [[nodiscard]] SDL_GPUGraphicsPipeline *createPipeline(
-        const MeshLayout &layout, SDL_GPUTextureFormat render_target_format,
-        SDL_GPUTextureFormat depth_stencil_format, PipelineType type);
+    /// \brief Create the pipeline of a pipeline type.
+    /// \param indirect Create the pipeline drawing gpuDrawList(), with the
+    /// indirect vertex shaders and the drawRecordLayout() of \p layout.
+    [[nodiscard]] SDL_GPUGraphicsPipeline *
+    createPipeline(const MeshLayout &layout,
+                   SDL_GPUTextureFormat render_target_format,
+                   SDL_GPUTextureFormat depth_stencil_format, PipelineType type,
+                   bool indirect = false);
 
     /// \warning Call updateRobotTransforms() before rendering the objects with
     /// this function.
     void render(CommandBuffer &command_buffer, const Camera &camera);
+    /// \brief Depth pre-pass of the triangle meshes, into the renderer's
+    /// depth texture. render() calls it if Config::triangle_has_prepass is
+    /// set. \sa depthPrepass
+    void renderDepthPrepass(CommandBuffer &command_buffer,
+                            const Camera &camera);
     /// \brief PBR render pass for triangle meshes.
     void renderPBRTriangleGeometry(CommandBuffer &command_buffer,
                                    const Camera &camera);
@@ -144,15 +299,70 @@ namespace multibody {
       Texture normalMap{NoInit};
     } gBuffer;
     ShadowPassInfo shadowPass;
+    /// Depth pre-pass of the triangle meshes, created with their pipeline if
+    /// Config::triangle_has_prepass is set.
+    DepthPassInfo depthPrepass;
     AABB worldSpaceBounds;
 
   private:
+    /// Create the render pipeline, and the passes, needed to draw meshes of
+    /// the given type and layout, unless they exist already.
+    void initPipelinesFor(PipelineType pipeline_type, const MeshLayout &layout);
+    /// Clear the render queue and the per-draw data, before a pass.
+    void beginDrawQueue();
+    /// Cull the triangle meshes on the CPU, queue their sorted draws, and
+    /// upload the objects and materials of their instances.
+    void queueTriangleDraws(CommandBuffer &command_buffer,
+                            const Camera &camera);
+    /// Distance of an entity from the camera plane, to sort draws.
+    float viewDepth(const Camera &camera, entt::entity entity,
+                    const Mat4f &transform) const;
+
     entt::registry &m_registry;
     Config m_config;
     const Renderer &m_renderer;
     std::reference_wrapper<pin::GeometryModel const> m_geomModel;
     std::reference_wrapper<pin::GeometryData const> m_geomData;
     std::vector<OpaqueCastable> m_castables;
+    /// Scratch buffer for the runs of visible meshlets. \sa cullMeshlets()
+    std::vector<std::pair<Uint32, Uint32>> m_meshletRuns;
+    /// Sorted draws of the current pass, and their per-object and per-draw
+    /// data: transforms, and ranges of meshlet runs in m_drawRuns.
+    RenderQueue m_renderQueue;
+    std::vector<Mat4f> m_drawTransforms;
+    std::vector<std::pair<Uint32, Uint32>> m_drawRunRanges;
+    std::vector<std::pair<Uint32, Uint32>> m_drawRuns;
+    RenderQueueStats m_renderStats;
+    DepthPassStats m_prepassStats;
+    /// Transforms and materials of the triangle meshes, for all the passes
+    /// of a frame. \sa uploadObjectData()
+    std::unique_ptr<ObjectBuffer> m_objectBuffer;
+    /// Index in m_objectBuffer of each entity, by entity index.
+    std::vector<Uint32> m_objectIndices;
+    /// Index of the material of the first mesh view of each object.
+    std::vector<Uint32> m_objectMaterials;
+    /// Whether m_objectBuffer holds the data of the current frame.
+    bool m_objectDataUploaded = false;
+    /// Object and material of each instance of the main pass's draws, and
+    /// the first instance of each draw.
+    std::vector<std::array<Uint32, 2>> m_drawInstances;
+    std::vector<Uint32> m_drawFirstInstances;
+    std::unique_ptr<InstanceBuffer> m_drawInstanceBuffer;
+    /// Draws culled on the GPU, the commands of the main pass, and the
+    /// pipeline drawing them. \sa Config::enable_gpu_culling
+    std::unique_ptr<GpuDrawList> m_drawList;
+    std::unique_ptr<GpuCullOutput> m_cullOutput;
+    /// Hi-Z pyramid of the main depth texture, built after the triangle
+    /// meshes are drawn. \sa Config::enable_occlusion_culling
+    std::unique_ptr<HiZPyramid> m_hiz;
+    SDL_GPUGraphicsPipeline *m_indirectPipeline = nullptr;
+    /// Vertex buffer slot of the draw records in m_indirectPipeline.
+    Uint32 m_drawRecordSlot = 0;
+    /// Culls the entities of each pass against the camera frustum.
+    FrustumCuller m_culler;
+    /// State of the background loading, while it runs. \sa async_loading
+    struct AsyncLoadState;
+    std::unique_ptr<AsyncLoadState> m_asyncLoad;
   };
   static_assert(Scene<RobotScene>);
 
@@ -25,6 +25,10 @@ Visualizer::Visualizer(const Config &config, const pin::Model &model,
 
   RobotScene::Config rconfig;
   rconfig.enable_shadows = true;
+  // the light volume covers the scene bounds, not the camera frustum: the
+  // shadow map only changes when the robot moves
+  rconfig.shadow_config.enable_caching = true;
+  rconfig.async_loading = config.async_loading;
   robotScene.emplace(registry, renderer, visualModel(), visualData(), rconfig);
   debugScene.emplace(registry, renderer);
   debugScene->addSystem<RobotDebugSystem>(m_model, data());
@@ -89,6 +93,7 @@ void Visualizer::displayImpl() {
   this->processEvents();
 
   debugScene->update();
+  robotScene->updateAsyncLoading();
   robotScene->updateTransforms();
   render();
 }
@@ -97,19 +102,29 @@ void Visualizer::render() {
 
   CommandBuffer cmdBuf = renderer.acquireCommandBuffer();
   if (renderer.waitAndAcquireSwapchain(cmdBuf)) {
+    auto &camera = controller.camera;
+    // one upload of the transforms, for all passes of the frame
+    robotScene->uploadObjectData(cmdBuf);
     robotScene->collectOpaqueCastables();
     std::span castables = robotScene->castables();
-    renderShadowPassFromAABB(cmdBuf, robotScene->shadowPass,
-                             robotScene->directionalLight, castables,
-                             robotScene->worldSpaceBounds);
+    if (robotScene->shadowPass.maxCascades > 1) {
+      renderShadowPassCascaded(cmdBuf, robotScene->shadowPass,
+                               robotScene->directionalLight, castables,
+                               camera);
+    } else {
+      renderShadowPassFromAABB(
+          cmdBuf, robotScene->shadowPass, robotScene->directionalLight,
+          castables, robotScene->worldSpaceBounds,
+          FrustumPlanes::fromClipMatrix(camera.viewProj()));
+    }
 
-    auto &camera = controller.camera;
     robotScene->render(cmdBuf, camera);
     debugScene->render(cmdBuf, camera);
     guiSystem.render(cmdBuf);
   }
 
-  cmdBuf.submit();
+  // fence the frame, recycling any staging memory it used
+  renderer.device.uploadRing().submit(cmdBuf);
 }
 
 } // namespace candlewick::multibody
@@ -63,6 +63,9 @@ public:
     Uint32 width;
     Uint32 height;
     SDL_GPUTextureFormat depth_stencil_format = SDL_GPU_TEXTUREFORMAT_D16_UNORM;
+    /// Open the window before the robot meshes are loaded, and draw
+    /// placeholders until they are. \sa RobotScene::Config::async_loading
+    bool async_loading = false;
   };
 
   /// \brief Default GUI callback for the Visualizer; provide your own callback
@@ -40,10 +40,44 @@ void Visualizer::default_gui_exec(Visualizer &viz) {
   ImGui::Begin("Renderer info & controls", nullptr,
                ImGuiWindowFlags_AlwaysAutoResize);
   ImGui::Text("Device driver: %s", render.device.driverName());
+  const RenderQueueStats &stats = viz.robotScene->renderStats();
+  ImGui::Text("Draws: %u (%u objects)", stats.draws, stats.instances);
+  if (stats.gpuCulled > 0) {
+    ImGui::Text("GPU-culled mesh views: %u", stats.gpuCulled);
+    const GpuCullStats cullStats = viz.robotScene->gpuCullStats();
+    if (cullStats.numDraws > 0)
+      ImGui::Text("  outside frustum %u, occluded %u (%.1f%%)",
+                  cullStats.numFrustumCulled, cullStats.numOccluded,
+                  100.f * float(cullStats.numOccluded) /
+                      float(cullStats.numDraws));
+  }
+  ImGui::Text("Binds (saved): pipeline %u (%u), mesh %u (%u), uniforms %u (%u)",
+              stats.pipelineBinds, stats.pipelineBindsSaved, stats.meshBinds,
+              stats.meshBindsSaved, stats.uniformPushes,
+              stats.uniformPushesSaved);
+  if (viz.robotScene->pbrHasPrepass()) {
+    const DepthPassStats &prepassStats = viz.robotScene->prepassStats();
+    ImGui::Text("Depth pre-pass: %u drawn / %u (%u instanced)",
+                prepassStats.numDrawn, prepassStats.numCastables,
+                prepassStats.numInstanced);
+  }
 
   ImGui::SeparatorText("Lights");
   ImGui::SetItemTooltip("Configuration for lights");
   add_light_gui(light);
+  const DepthPassStats &shadowStats = viz.robotScene->shadowPass.stats;
+  ImGui::Text("Shadow casters: %u drawn / %u (%u outside light, %u no "
+              "visible shadow, %u instanced, %u cached)",
+              shadowStats.numDrawn, shadowStats.numCastables,
+              shadowStats.numCulledVolume, shadowStats.numCulledReceivers,
+              shadowStats.numInstanced, shadowStats.numCached);
+  if (viz.robotScene->shadowPass.numCascades > 1)
+    ImGui::Text("Shadow cascades: %u", viz.robotScene->shadowPass.numCascades);
+  if (shadowStats.numGpuCulled > 0)
+    ImGui::Text("Shadow caster views culled on the GPU: %u (%u occluded, "
+                "%u no visible shadow)",
+                shadowStats.numGpuCulled, shadowStats.numGpuOccluded,
+                shadowStats.numGpuReceiverCulled);
 
   camera_params_gui(viz.controller, viz.cameraParams);
 
@@ -1,6 +1,7 @@
 #include "SSAO.h"
 
 #include "../core/CommandBuffer.h"
+#include "../core/Device.h"
 #include "../core/Shader.h"
 #include "../core/Camera.h"
 #include "../core/Renderer.h"
@@ -92,31 +93,25 @@ namespace ssao {
     using element_type = decltype(values)::value_type;
     const Texture &tex = noise.tex;
     auto &dev = tex.device();
-    CommandBuffer command_buffer(dev);
-    SDL_GPUCopyPass *copy_pass = SDL_BeginGPUCopyPass(command_buffer);
+    UploadRing &ring = dev.uploadRing();
 
     auto payload_size = Uint32(values.size() * sizeof(values[0]));
     assert(payload_size == tex.textureSize());
-    SDL_GPUTransferBufferCreateInfo tb_ci{
-        .usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD,
-        .size = payload_size,
-        .props = 0};
-    SDL_GPUTransferBuffer *texTransferBuffer =
-        SDL_CreateGPUTransferBuffer(dev, &tb_ci);
-    auto *data =
-        (element_type *)SDL_MapGPUTransferBuffer(dev, texTransferBuffer, false);
-    std::copy(values.begin(), values.end(), data);
-    SDL_UnmapGPUTransferBuffer(dev, texTransferBuffer);
+    CommandBuffer command_buffer(dev);
+    StagingAllocation staging = ring.allocate(command_buffer, payload_size);
+    std::copy(values.begin(), values.end(), (element_type *)staging.data);
+    ring.unmap(staging);
 
+    SDL_GPUCopyPass *copy_pass = SDL_BeginGPUCopyPass(command_buffer);
     SDL_GPUTextureTransferInfo tex_trans_info{
-        .transfer_buffer = texTransferBuffer, .offset = 0};
+        .transfer_buffer = staging.buffer, .offset = staging.offset};
     SDL_GPUTextureRegion tex_region{
         .texture = tex, .w = tex.width(), .h = tex.height(), .d = 1};
     assert(tex_region.d == tex.depth());
     SDL_UploadToGPUTexture(copy_pass, &tex_trans_info, &tex_region, false);
 
     SDL_EndGPUCopyPass(copy_pass);
-    return command_buffer.submit();
+    return ring.submit(command_buffer);
   }
 
   SsaoPass::SsaoPass(const Renderer &renderer, const MeshLayout &layout,
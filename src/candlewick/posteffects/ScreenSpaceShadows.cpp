@@ -3,16 +3,19 @@
 #include "../core/math_types.h"
 #include "../core/DepthAndShadowPass.h"
 #include "../core/Renderer.h"
+#include "../core/MeshLayout.h"
 #include "../core/Shader.h"
 #include "../core/Camera.h"
 
+#include <vector>
 #include <SDL3/SDL_log.h>
 
 namespace candlewick {
 namespace effects {
   ScreenSpaceShadowPass::ScreenSpaceShadowPass(const Renderer &renderer,
+                                               const MeshLayout &layout,
                                                const Config &config)
-      : config(config) {
+      : config(config), positionOnly(isPositionOnlyLayout(layout)) {
     const Device &device = renderer.device;
     this->depthTexture = renderer.depth_texture;
 
@@ -27,7 +30,7 @@ namespace effects {
     SDL_GPUGraphicsPipelineCreateInfo pipeline_desc{
         .vertex_shader = vertexShader,
         .fragment_shader = fragmentShader,
-        .vertex_input_state{},
+        .vertex_input_state = layout.toVertexInputState(),
         .primitive_type = SDL_GPU_PRIMITIVETYPE_TRIANGLELIST,
         .rasterizer_state{.fill_mode = SDL_GPU_FILLMODE_FILL,
                           .cull_mode = SDL_GPU_CULLMODE_BACK},
@@ -39,6 +42,15 @@ namespace effects {
 
     pipeline = SDL_CreateGPUGraphicsPipeline(device, &pipeline_desc);
     assert(pipeline);
+    if (config.enableInstancing) {
+      auto instancedVertexShader =
+          Shader::fromMetadata(device, "ShadowCastInstanced.vert");
+      pipeline_desc.vertex_shader = instancedVertexShader;
+      instancedPipeline =
+          SDL_CreateGPUGraphicsPipeline(device, &pipeline_desc);
+      assert(instancedPipeline);
+      instanceBuffer = std::make_shared<InstanceBuffer>(device);
+    }
 
     auto [width, height] = renderer.window.sizeInPixels();
     SDL_GPUTextureCreateInfo texture_desc{
@@ -83,6 +95,10 @@ namespace effects {
     if (pipeline)
       SDL_ReleaseGPUGraphicsPipeline(device, pipeline);
 
+    if (instancedPipeline)
+      SDL_ReleaseGPUGraphicsPipeline(device, instancedPipeline);
+    instanceBuffer.reset();
+
     if (depthSampler)
       SDL_ReleaseGPUSampler(device, depthSampler);
   }
@@ -90,7 +106,17 @@ namespace effects {
   void
   ScreenSpaceShadowPass::render(CommandBuffer &cmdBuf, const Camera &camera,
                                 const DirectionalLight &light,
-                                std::span<const OpaqueCastable> castables) {
+                                std::span<const OpaqueCastable> castables,
+                                const ObjectBuffer *objects) {
+    std::vector<Uint32> instanceObjects;
+    if (objects && !objects->empty() && instancedPipeline) {
+      for (auto &cs : castables) {
+        if (cs.object != ObjectBuffer::kNoObject)
+          instanceObjects.push_back(cs.object);
+      }
+      instanceBuffer->upload(cmdBuf, std::span{instanceObjects});
+    }
+
     SDL_GPUColorTargetInfo color_target_info;
     SDL_zero(color_target_info);
     color_target_info.texture = targetTexture;
@@ -101,7 +127,6 @@ namespace effects {
 
     SDL_GPURenderPass *render_pass =
         SDL_BeginGPURenderPass(cmdBuf, &color_target_info, 1, nullptr);
-    SDL_BindGPUGraphicsPipeline(render_pass, pipeline);
 
     Mat4f invProj = camera.projection.inverse();
     Mat4f vp = camera.viewProj();
@@ -119,10 +144,37 @@ namespace effects {
                                    .sampler = depthSampler,
                                }});
 
+    rend::MeshBinder binder{render_pass};
+    auto bind = [&](const Mesh &mesh) {
+      if (positionOnly)
+        binder.bindPositions(mesh);
+      else
+        binder.bind(mesh);
+    };
+    // the castables in the object buffer, then the others
+    if (!instanceObjects.empty()) {
+      SDL_BindGPUGraphicsPipeline(render_pass, instancedPipeline);
+      objects->bindVertex(render_pass, 0);
+      instanceBuffer->bindVertex(render_pass, 1);
+      const GpuMat4 viewProj = vp;
+      cmdBuf.pushVertexUniform(0, &viewProj, sizeof(viewProj));
+      Uint32 firstInstance = 0;
+      for (auto &cs : castables) {
+        if (cs.object == ObjectBuffer::kNoObject)
+          continue;
+        bind(cs.mesh);
+        cmdBuf.pushVertexUniform(1, &firstInstance, sizeof(firstInstance));
+        rend::draw(render_pass, cs.mesh);
+        firstInstance++;
+      }
+    }
+    SDL_BindGPUGraphicsPipeline(render_pass, pipeline);
     for (auto &cs : castables) {
-      GpuMat4 mvp = vp * cs.transform;
+      if (!instanceObjects.empty() && cs.object != ObjectBuffer::kNoObject)
+        continue;
+      GpuMat4 mvp = vp * cs.transform * cs.mesh.positionDequant;
       cmdBuf.pushVertexUniform(0, &mvp, sizeof(mvp));
-      rend::bindMesh(render_pass, cs.mesh);
+      bind(cs.mesh);
       rend::draw(render_pass, cs.mesh);
     }
 
@@ -5,10 +5,13 @@
 #include "../core/LightUniforms.h"
 
 #include <SDL3/SDL_gpu.h>
+#include <memory>
 #include <span>
 
 namespace candlewick {
 struct OpaqueCastable;
+class InstanceBuffer;
+class ObjectBuffer;
 namespace effects {
 
   /// \brief WIP screen space shadows
@@ -16,6 +19,8 @@ namespace effects {
     struct Config {
       float maxDist = 1.0f;
       int numSteps = 16;
+      /// Create \ref instancedPipeline, from `ShadowCastInstanced.vert`.
+      bool enableInstancing = false;
     } config;
     SDL_GPUTexture *depthTexture = nullptr;
     /// Sampler for the depth texture (e.g. from the prepass)
@@ -24,19 +29,34 @@ namespace effects {
     SDL_GPUTexture *targetTexture = nullptr;
     /// Render pipeline
     SDL_GPUGraphicsPipeline *pipeline = nullptr;
+    /// Render pipeline for the castables in an ObjectBuffer, which reads their
+    /// transforms from it. Null unless Config::enableInstancing is set.
+    /// \sa DepthPassInfo::instancedPipeline
+    SDL_GPUGraphicsPipeline *instancedPipeline = nullptr;
+    /// Object indices of the draws of the instanced pipeline.
+    std::shared_ptr<InstanceBuffer> instanceBuffer;
+    /// Whether the pipeline reads the meshes' position-only streams.
+    /// \sa DepthPassInfo::positionOnly
+    bool positionOnly = false;
 
     bool valid() const {
       return depthTexture && depthSampler && targetTexture && pipeline;
     }
 
     ScreenSpaceShadowPass(NoInitT) {}
-    ScreenSpaceShadowPass(const Renderer &renderer, const Config &config);
+    /// \param layout %Mesh layout for the pipeline's vertex input state, e.g.
+    /// the positionStreamLayout() of the meshes' layout.
+    ScreenSpaceShadowPass(const Renderer &renderer, const MeshLayout &layout,
+                          const Config &config);
 
     void release(SDL_GPUDevice *device) noexcept;
 
+    /// \param objects Per-frame transforms of the castables with an object
+    /// index, which are then not pushed as uniforms.
     void render(CommandBuffer &cmdBuf, const Camera &camera,
                 const DirectionalLight &light,
-                std::span<const OpaqueCastable> castables);
+                std::span<const OpaqueCastable> castables,
+                const ObjectBuffer *objects = nullptr);
   };
 
 } // namespace effects
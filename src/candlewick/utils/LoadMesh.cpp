@@ -2,8 +2,11 @@
 
 #include "MeshData.h"
 #include "LoadMaterial.h"
-#include "../core/DefaultVertex.h"
+#include "MeshCacheFile.h"
+#include "MeshTransforms.h"
+#include "../core/CompactVertex.h"
 
+#include <limits>
 #include <source_location>
 #include <SDL3/SDL_log.h>
 #include <assimp/scene.h>
@@ -12,31 +15,63 @@
 
 namespace candlewick {
 
-MeshData loadAiMesh(const aiMesh *inMesh, const aiMatrix4x4 transform) {
+MeshData loadAiMesh(const aiMesh *inMesh, const aiMatrix4x4 transform,
+                    const MeshLayout &layout,
+                    const PositionQuantization &quant) {
   using IndexType = MeshData::IndexType;
   const Uint32 expectedFaceSize = 3;
+  const Uint32 stride = layout.vertexSize();
 
-  std::vector<DefaultVertex> vertexData;
+  std::vector<char> vertexData;
   std::vector<IndexType> indexData;
-  vertexData.resize(inMesh->mNumVertices);
+  vertexData.resize(size_t(inMesh->mNumVertices) * stride);
   indexData.resize(inMesh->mNumFaces * expectedFaceSize);
 
+  const aiMatrix3x3 normMatrix(transform);
+  auto toFloat4 = [](const aiVector3D &v) {
+    return Float4{v.x, v.y, v.z, 0.f};
+  };
+
   for (Uint32 vertex_id = 0; vertex_id < inMesh->mNumVertices; vertex_id++) {
-    aiVector3D pos = inMesh->mVertices[vertex_id];
-    pos = transform * pos;
-    DefaultVertex &vertex = vertexData[vertex_id];
-    vertex.pos = Float3::Map(&pos.x);
-
-    aiMatrix3x3 normMatrix(transform);
-    if (inMesh->HasNormals()) {
-      aiVector3D n_ = inMesh->mNormals[vertex_id];
-      n_ = normMatrix * n_;
-      vertex.normal = Float3::Map(&n_.x);
-    }
-    if (inMesh->HasTangentsAndBitangents()) {
-      aiVector3D t = inMesh->mTangents[vertex_id];
-      t = normMatrix * t;
-      vertex.tangent = Float3::Map(&t.x);
+    char *vertex = vertexData.data() + size_t(vertex_id) * stride;
+    for (const SDL_GPUVertexAttribute &attr : layout.m_attrs) {
+      Float4 value;
+      switch (VertexAttrib(attr.location)) {
+      case VertexAttrib::Position:
+        value = toFloat4(transform * inMesh->mVertices[vertex_id]);
+        break;
+      case VertexAttrib::Normal:
+        if (!inMesh->HasNormals())
+          continue;
+        value = toFloat4(normMatrix * inMesh->mNormals[vertex_id]);
+        break;
+      case VertexAttrib::Tangent:
+        if (!inMesh->HasTangentsAndBitangents())
+          continue;
+        value = toFloat4(normMatrix * inMesh->mTangents[vertex_id]);
+        break;
+      case VertexAttrib::Bitangent:
+        if (!inMesh->HasTangentsAndBitangents())
+          continue;
+        value = toFloat4(normMatrix * inMesh->mBitangents[vertex_id]);
+        break;
+      case VertexAttrib::Color0:
+        if (inMesh->HasVertexColors(0)) {
+          const aiColor4D &c = inMesh->mColors[0][vertex_id];
+          value = Float4{c.r, c.g, c.b, c.a};
+        } else {
+          value = Float4::Ones();
+        }
+        break;
+      case VertexAttrib::TexCoord0:
+        if (!inMesh->HasTextureCoords(0))
+          continue;
+        value = toFloat4(inMesh->mTextureCoords[0][vertex_id]);
+        break;
+      default:
+        continue;
+      }
+      encodeVertexAttribute(vertex, attr, value, quant);
     }
   }
 
@@ -47,8 +82,64 @@ MeshData loadAiMesh(const aiMesh *inMesh, const aiMatrix4x4 transform) {
       indexData[face_id * expectedFaceSize + ii] = f.mIndices[ii];
     }
   }
-  return MeshData{SDL_GPU_PRIMITIVETYPE_TRIANGLELIST, std::move(vertexData),
-                  std::move(indexData)};
+  MeshData out{SDL_GPU_PRIMITIVETYPE_TRIANGLELIST, layout,
+               std::move(vertexData), std::move(indexData)};
+  out.positionDequant = quant.dequantMatrix();
+  return out;
+}
+
+/// Quantization box shared by all the meshes of the scene, so that they can be
+/// batched into a single Mesh.
+static PositionQuantization scenePositionQuantization(const aiScene *scene,
+                                                      aiMatrix4x4 transform) {
+  Float3 min = Float3::Constant(std::numeric_limits<float>::max());
+  Float3 max = -min;
+  for (Uint32 i = 0; i < scene->mNumMeshes; i++) {
+    const aiMesh *inMesh = scene->mMeshes[i];
+    for (Uint32 j = 0; j < inMesh->mNumVertices; j++) {
+      aiVector3D pos = transform * inMesh->mVertices[j];
+      min = min.cwiseMin(Float3::Map(&pos.x));
+      max = max.cwiseMax(Float3::Map(&pos.x));
+    }
+  }
+  return PositionQuantization::fromBounds(min, max);
+}
+
+/// Assimp post-processing steps, and components to strip from the imported
+/// meshes, for the attributes of \p layout. Stripping unused components lets
+/// aiProcess_JoinIdenticalVertices merge more vertices.
+static Uint32 postProcessFlagsFor(const MeshLayout &layout,
+                                  int &removeComponents) {
+  auto has = [&layout](VertexAttrib loc) {
+    return layout.getAttribute(loc) != nullptr;
+  };
+  const bool tangents =
+      has(VertexAttrib::Tangent) || has(VertexAttrib::Bitangent);
+  const bool normals = tangents || has(VertexAttrib::Normal);
+  const bool texCoords = tangents || has(VertexAttrib::TexCoord0);
+
+  Uint32 flags = aiProcess_Triangulate | aiProcess_SortByPType |
+                 aiProcess_JoinIdenticalVertices | aiProcess_RemoveComponent |
+                 aiProcess_FindDegenerates | aiProcess_PreTransformVertices |
+                 aiProcess_ImproveCacheLocality;
+  removeComponents = aiComponent_BONEWEIGHTS | aiComponent_ANIMATIONS |
+                     aiComponent_CAMERAS | aiComponent_LIGHTS;
+  if (normals)
+    flags |= aiProcess_GenSmoothNormals;
+  else
+    removeComponents |= aiComponent_NORMALS;
+  // tangents are computed from the texture coordinates
+  if (tangents)
+    flags |= aiProcess_CalcTangentSpace;
+  else
+    removeComponents |= aiComponent_TANGENTS_AND_BITANGENTS;
+  if (texCoords)
+    flags |= aiProcess_GenUVCoords;
+  else
+    removeComponents |= aiComponent_TEXCOORDS;
+  if (!has(VertexAttrib::Color0))
+    removeComponents |= aiComponent_COLORS;
+  return flags;
 }
 
 static void log_resource_failure(
@@ -58,19 +149,35 @@ static void log_resource_failure(
               loc.function_name(), err_message);
 }
 
-mesh_load_retc loadSceneMeshes(const char *path,
-                               std::vector<MeshData> &meshData) {
+void processMesh(MeshData &meshData, const MeshProcessOptions &options) {
+  if (options.lodLevels > 0)
+    generateLodChain(meshData, options.lodLevels);
+  if (!options.optimize)
+    return;
+  // the statistics cost two cache simulations: only run them when logged
+  const bool logStats = SDL_GetLogPriority(SDL_LOG_CATEGORY_APPLICATION) <=
+                        SDL_LOG_PRIORITY_DEBUG;
+  MeshOptimizationStats stats{};
+  optimizeMesh(meshData, logStats ? &stats : nullptr);
+  if (logStats && stats.after.acmr > 0.f)
+    SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION,
+                 "Optimized mesh (%u triangles): ACMR %.3f -> %.3f, ATVR %.3f "
+                 "-> %.3f",
+                 meshData.baseIndexCount() / 3, stats.before.acmr,
+                 stats.after.acmr, stats.before.atvr, stats.after.atvr);
+}
 
+static mesh_load_retc importSceneMeshes(const char *path,
+                                        std::vector<MeshData> &meshData,
+                                        const MeshLayout &layout,
+                                        const MeshProcessOptions &options) {
   ::Assimp::Importer import;
   // remove point primitives
   import.SetPropertyInteger(AI_CONFIG_PP_SBP_REMOVE,
                             aiPrimitiveType_LINE | aiPrimitiveType_POINT);
-  Uint32 pFlags = aiProcess_CalcTangentSpace | aiProcess_Triangulate |
-                  aiProcess_GenSmoothNormals | aiProcess_SortByPType |
-                  aiProcess_JoinIdenticalVertices | aiProcess_GenUVCoords |
-                  aiProcess_RemoveComponent | aiProcess_FindDegenerates |
-                  aiProcess_PreTransformVertices |
-                  aiProcess_ImproveCacheLocality;
+  int removeComponents;
+  Uint32 pFlags = postProcessFlagsFor(layout, removeComponents);
+  import.SetPropertyInteger(AI_CONFIG_PP_RVC_FLAGS, removeComponents);
   import.SetPropertyBool(AI_CONFIG_IMPORT_COLLADA_IGNORE_UP_DIRECTION, true);
   const aiScene *scene = import.ReadFile(path, pFlags);
   if (!scene) {
@@ -82,17 +189,67 @@ mesh_load_retc loadSceneMeshes(const char *path,
     return mesh_load_retc::NO_MESHES;
 
   aiMatrix4x4 transform = scene->mRootNode->mTransformation;
+  PositionQuantization quant;
+  auto posAttr = layout.getAttribute(VertexAttrib::Position);
+  if (posAttr && isNormalizedFormat(posAttr->format))
+    quant = scenePositionQuantization(scene, transform);
   for (std::size_t i = 0; i < scene->mNumMeshes; i++) {
     aiMesh *inMesh = scene->mMeshes[i];
-    MeshData &md = meshData.emplace_back(loadAiMesh(inMesh, transform));
+    MeshData &md =
+        meshData.emplace_back(loadAiMesh(inMesh, transform, layout, quant));
     Uint32 materialId = inMesh->mMaterialIndex;
     if (scene->HasMaterials()) {
       aiMaterial *material = scene->mMaterials[materialId];
       md.material = loadFromAssimpMaterial(material);
     }
+    processMesh(md, options);
   }
-
   return mesh_load_retc::OK;
 }
 
+mesh_load_retc loadSceneMeshes(const char *path,
+                               std::vector<MeshData> &meshData,
+                               const MeshLayout &layout,
+                               const MeshProcessOptions &options) {
+  if (!meshCacheFileEnabled())
+    return importSceneMeshes(path, meshData, layout, options);
+  std::shared_ptr<const MeshCacheFile> cacheFile;
+  const mesh_load_retc ret =
+      loadSceneMeshes(path, meshData, cacheFile, layout, options);
+  if (cacheFile)
+    cacheFile->toOwned(meshData);
+  return ret;
+}
+
+mesh_load_retc loadSceneMeshes(const char *path,
+                               std::vector<MeshData> &meshData,
+                               std::shared_ptr<const MeshCacheFile> &cacheFile,
+                               const MeshLayout &layout,
+                               const MeshProcessOptions &options) {
+  namespace fs = std::filesystem;
+  cacheFile.reset();
+
+  // Warm path: map the preprocessed meshes, skipping assimp entirely.
+  std::error_code ec;
+  const fs::path source = fs::canonical(path, ec);
+  if (ec || meshCacheDirectory().empty())
+    return importSceneMeshes(path, meshData, layout, options);
+  const fs::path cachePath = meshCacheFilePath(source, layout, options);
+  auto cached =
+      std::make_shared<MeshCacheFile>(cachePath, source, layout, options);
+  if (*cached) {
+    cacheFile = std::move(cached);
+    return mesh_load_retc::OK;
+  }
+
+  const size_t firstMesh = meshData.size();
+  const mesh_load_retc ret =
+      importSceneMeshes(path, meshData, layout, options);
+  if (ret == mesh_load_retc::OK) {
+    std::span<const MeshData> loaded{meshData};
+    writeMeshCacheFile(cachePath, source, loaded.subspan(firstMesh), options);
+  }
+  return ret;
+}
+
 } // namespace candlewick
@@ -1,11 +1,15 @@
 #pragma once
 
 #include "Utils.h"
+#include "../core/DefaultVertex.h"
 #include <SDL3/SDL_stdinc.h>
+#include <memory>
 #include <vector>
 
 namespace candlewick {
 
+class MeshCacheFile;
+
 /// Return codes for \ref loadSceneMeshes().
 enum class mesh_load_retc : Uint16 {
   FAILED_TO_LOAD = 1 << 0,
@@ -14,8 +18,57 @@ enum class mesh_load_retc : Uint16 {
   OK = 1 << 4,
 };
 
+/// \brief Processing of the meshes imported by loadSceneMeshes(), done before
+/// they are written to the preprocessed cache file, so that cached loads skip
+/// it too.
+struct MeshProcessOptions {
+  /// Number of coarser levels of detail to generate for the triangle meshes.
+  /// \sa generateLodChain()
+  Uint32 lodLevels = 0;
+  /// Reorder the triangle meshes for the vertex cache, overdraw and vertex
+  /// fetch. \sa optimizeMesh()
+  bool optimize = true;
+};
+
+/// \brief Apply \p options to a mesh, as loadSceneMeshes() does.
+void processMesh(MeshData &meshData, const MeshProcessOptions &options);
+
 /// \brief Load the meshes from the given path.
 /// This is implemented using the assimp library.
+///
+/// If the preprocessed mesh cache is enabled (see setMeshCacheFileEnabled()),
+/// the resulting meshes are written to a cache file on the first import of a
+/// file. Later calls copy them out of that file instead, as long as the source
+/// file is unchanged.
+///
+/// \param path Path to the mesh file.
+/// \param meshData Output; the loaded meshes are appended to it.
+/// \param layout Vertex layout of the loaded meshes. Only the attributes of
+/// the layout are imported and computed (e.g. tangents are only generated if
+/// the layout has them). Attributes missing from the file are zeroed (colors
+/// are set to white). Layouts with quantized
+/// positions share one quantization box across the file's meshes, see
+/// MeshData::positionDequant.
+/// \param options Processing of the imported meshes.
+/// \sa MeshCacheFile
+/// \sa setMeshCacheFileEnabled()
+/// \sa CompactVertex
+mesh_load_retc
+loadSceneMeshes(const char *path, std::vector<MeshData> &meshData,
+                const MeshLayout &layout = meshLayoutFor<DefaultVertex>(),
+                const MeshProcessOptions &options = {});
+
+/// \brief Load the meshes from the given path through the preprocessed mesh
+/// cache, whether or not meshCacheFileEnabled().
+///
+/// If the cache file of \p path is up to date, the meshes are not copied:
+/// \p cacheFile holds the memory-mapped file, whose MeshCacheFile::meshes()
+/// can be uploaded directly, and \p meshData is left untouched. Otherwise, the
+/// file is imported into \p meshData and written to the cache, and \p
+/// cacheFile is null.
 mesh_load_retc loadSceneMeshes(const char *path,
-                               std::vector<MeshData> &meshData);
+                               std::vector<MeshData> &meshData,
+                               std::shared_ptr<const MeshCacheFile> &cacheFile,
+                               const MeshLayout &layout,
+                               const MeshProcessOptions &options = {});
 } // namespace candlewick
@@ -0,0 +1,90 @@
+#include "MeshCache.h"
+#include "../core/Device.h"
+
+#include <SDL3/SDL_log.h>
+
+namespace candlewick {
+
+namespace fs = std::filesystem;
+
+static void hash_combine(size_t &seed, size_t value) {
+  seed ^= value + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+}
+
+size_t MeshCacheKeyHash::operator()(const MeshCacheKey &key) const noexcept {
+  size_t seed = std::hash<std::string>{}(key.path);
+  hash_combine(seed, std::hash<const void *>{}(key.device));
+  hash_combine(seed, std::hash<fs::file_time_type::rep>{}(
+                         key.mtime.time_since_epoch().count()));
+  for (Eigen::Index i = 0; i < 3; i++)
+    hash_combine(seed, std::hash<float>{}(key.scale[i]));
+  return seed;
+}
+
+std::optional<MeshCacheKey> makeMeshCacheKey(const Device &device,
+                                             const std::string &path,
+                                             const Float3 &scale,
+                                             const MeshLayout &layout,
+                                             bool positionStream,
+                                             Uint32 lodLevels) {
+  std::error_code ec;
+  fs::path resolved = fs::canonical(path, ec);
+  if (ec)
+    return std::nullopt;
+  auto mtime = fs::last_write_time(resolved, ec);
+  if (ec)
+    return std::nullopt;
+  return MeshCacheKey{
+      .device = device,
+      .path = resolved.string(),
+      .mtime = mtime,
+      .scale = scale,
+      .layout = layout,
+      .positionStream = positionStream,
+      .lodLevels = lodLevels,
+  };
+}
+
+MeshCache &MeshCache::instance() {
+  static MeshCache cache;
+  return cache;
+}
+
+auto MeshCache::find(const MeshCacheKey &key) -> AssetPtr {
+  std::lock_guard lock{m_mutex};
+  auto it = m_entries.find(key);
+  if (it == m_entries.end())
+    return nullptr;
+  return it->second.lock();
+}
+
+auto MeshCache::insert(const MeshCacheKey &key, Mesh &&mesh,
+                       std::vector<PbrMaterial> materials) -> AssetPtr {
+  std::lock_guard lock{m_mutex};
+  auto &entry = m_entries[key];
+  if (auto asset = entry.lock())
+    return asset;
+  auto asset = std::make_shared<const SharedMeshAsset>(
+      SharedMeshAsset{std::move(mesh), std::move(materials)});
+  entry = asset;
+  if (m_entries.size() > 2 * m_lastPrunedSize)
+    pruneUnlocked();
+  return asset;
+}
+
+void MeshCache::prune() {
+  std::lock_guard lock{m_mutex};
+  pruneUnlocked();
+}
+
+void MeshCache::pruneUnlocked() {
+  std::erase_if(m_entries, [](const auto &kv) { return kv.second.expired(); });
+  m_lastPrunedSize = m_entries.size();
+}
+
+size_t MeshCache::size() const {
+  std::lock_guard lock{m_mutex};
+  return m_entries.size();
+}
+
+} // namespace candlewick
@@ -0,0 +1,101 @@
+#pragma once
+
+#include "Utils.h"
+#include "../core/Mesh.h"
+#include "../core/MaterialUniform.h"
+#include "../core/math_types.h"
+
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace candlewick {
+
+/// \brief Key identifying a mesh asset loaded from a file.
+///
+/// Two keys compare equal when they point to the same (resolved) file, with the
+/// same modification time, loaded with the same scaling, on the same device.
+struct MeshCacheKey {
+  SDL_GPUDevice *device;
+  std::string path; //< Canonical path to the file.
+  std::filesystem::file_time_type mtime;
+  Float3 scale;
+  MeshLayout layout;   //< Vertex layout the file was loaded with.
+  bool positionStream; //< Whether the Mesh has a position-only stream.
+  Uint32 lodLevels;    //< Number of levels of detail generated at load.
+
+  bool operator==(const MeshCacheKey &other) const {
+    return device == other.device && path == other.path &&
+           mtime == other.mtime && scale == other.scale &&
+           layout == other.layout && positionStream == other.positionStream &&
+           lodLevels == other.lodLevels;
+  }
+};
+
+struct MeshCacheKeyHash {
+  size_t operator()(const MeshCacheKey &key) const noexcept;
+};
+
+/// \brief Build the cache key for a mesh file.
+/// \returns The key, or std::nullopt if the path could not be resolved.
+std::optional<MeshCacheKey> makeMeshCacheKey(const Device &device,
+                                             const std::string &path,
+                                             const Float3 &scale,
+                                             const MeshLayout &layout,
+                                             bool positionStream = false,
+                                             Uint32 lodLevels = 0);
+
+/// \brief Mesh uploaded to the GPU, along with its materials (one per view).
+struct SharedMeshAsset {
+  Mesh mesh;
+  std::vector<PbrMaterial> materials;
+};
+
+/// \brief Process-wide, content-addressed cache of GPU mesh assets.
+///
+/// The cache only holds weak references: an asset is released as soon as the
+/// last Mesh referencing it (see Mesh::share()) is released. This class is
+/// thread-safe.
+class MeshCache {
+public:
+  using AssetPtr = std::shared_ptr<const SharedMeshAsset>;
+
+  /// \brief Global instance of the cache.
+  static MeshCache &instance();
+
+  /// \brief Find a live asset for the given key.
+  /// \returns The asset, or nullptr on a cache miss.
+  AssetPtr find(const MeshCacheKey &key);
+
+  /// \brief Insert an asset into the cache.
+  /// \returns The inserted asset, or the live asset already stored for this
+  /// key (in which case \p mesh is released).
+  AssetPtr insert(const MeshCacheKey &key, Mesh &&mesh,
+                  std::vector<PbrMaterial> materials);
+
+  /// \brief Remove entries whose asset has been released.
+  void prune();
+
+  /// \brief Number of entries, including expired ones.
+  size_t size() const;
+
+private:
+  void pruneUnlocked();
+
+  mutable std::mutex m_mutex;
+  std::unordered_map<MeshCacheKey, std::weak_ptr<const SharedMeshAsset>,
+                     MeshCacheKeyHash>
+      m_entries;
+  size_t m_lastPrunedSize = 0;
+};
+
+/// \brief Create a Mesh sharing the buffers of a cached asset.
+inline Mesh shareMesh(const MeshCache::AssetPtr &asset) {
+  return Mesh::share(std::shared_ptr<const Mesh>(asset, &asset->mesh));
+}
+
+} // namespace candlewick
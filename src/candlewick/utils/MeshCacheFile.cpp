@@ -0,0 +1,428 @@
+#include "MeshCacheFile.h"
+#include "MeshData.h"
+
+#include <SDL3/SDL_log.h>
+
+#include <cstdlib>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define CANDLEWICK_HAS_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace candlewick {
+
+namespace fs = std::filesystem;
+
+MappedFile::MappedFile(const fs::path &path) {
+#ifdef CANDLEWICK_HAS_MMAP
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+    return;
+  struct stat st;
+  if (::fstat(fd, &st) == 0 && st.st_size > 0) {
+    void *ptr = ::mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_PRIVATE, fd,
+                       0);
+    if (ptr != MAP_FAILED) {
+      m_data = static_cast<const char *>(ptr);
+      m_size = size_t(st.st_size);
+    }
+  }
+  ::close(fd);
+#else
+  std::ifstream file{path, std::ios::binary | std::ios::ate};
+  if (!file)
+    return;
+  m_fallback.resize(size_t(file.tellg()));
+  file.seekg(0);
+  if (file.read(m_fallback.data(), std::streamsize(m_fallback.size()))) {
+    m_data = m_fallback.data();
+    m_size = m_fallback.size();
+  }
+#endif
+}
+
+MappedFile::MappedFile(MappedFile &&other) noexcept
+    : m_data(other.m_data), m_size(other.m_size),
+      m_fallback(std::move(other.m_fallback)) {
+  other.m_data = nullptr;
+  other.m_size = 0;
+}
+
+MappedFile::~MappedFile() noexcept {
+#ifdef CANDLEWICK_HAS_MMAP
+  if (m_data)
+    ::munmap(const_cast<char *>(m_data), m_size);
+#endif
+}
+
+// File layout. All sections start at 16-byte aligned offsets:
+//   FileHeader, source path
+//   for each mesh: MeshHeader, buffer descriptions, attributes, vertex blob,
+//   indices, levels of detail.
+namespace {
+  constexpr char kMagic[8] = {'C', 'W', 'M', 'E', 'S', 'H', '\0', '\0'};
+  // Bump when the file layout or the import post-processing changes.
+  constexpr Uint32 kVersion = 4;
+  constexpr Uint32 kByteOrderMark = 0x01020304;
+
+  struct FileHeader {
+    char magic[8];
+    Uint32 version;
+    Uint32 byteOrderMark;
+    Sint64 sourceMtime;
+    Uint64 sourceSize;
+    Uint32 numMeshes;
+    Uint32 pathLength;
+    /// MeshProcessOptions of the meshes.
+    Uint32 lodLevels;
+    Uint32 optimized;
+  };
+
+  struct MeshHeader {
+    Uint32 primitiveType;
+    Uint32 numBuffers;
+    Uint32 numAttributes;
+    Uint32 numVertices;
+    Uint32 numIndices;
+    Uint32 vertexSize;
+    Uint64 vertexBytes;
+    float baseColor[4];
+    float metalness;
+    float roughness;
+    float ao;
+    Uint32 numLods;
+    float positionDequant[16];
+  };
+
+  constexpr size_t alignUp(size_t n) { return (n + 15) & ~size_t(15); }
+
+  /// Bounds-checked cursor into the mapped file. The counts come from the
+  /// file, hence are checked without overflowing.
+  struct Reader {
+    std::span<const char> data;
+    size_t pos = 0;
+
+    size_t remaining() const {
+      return pos < data.size() ? data.size() - pos : 0;
+    }
+
+    /// Whether \p count elements of type \p T are left.
+    template <typename T> bool has(Uint64 count) const {
+      return count <= remaining() / sizeof(T);
+    }
+
+    template <typename T> const T *take(Uint64 count = 1) {
+      if (!has<T>(count))
+        return nullptr;
+      const size_t bytes = size_t(count) * sizeof(T);
+      const T *ptr = reinterpret_cast<const T *>(data.data() + pos);
+      pos = alignUp(pos + bytes);
+      return ptr;
+    }
+  };
+
+  /// Whether the sizes in \p mh match \p layout, checked before any data of
+  /// the mesh is read.
+  bool validMeshHeader(const MeshHeader &mh, const MeshLayout &layout) {
+    return mh.primitiveType <= Uint32(SDL_GPU_PRIMITIVETYPE_POINTLIST) &&
+           mh.numBuffers == layout.numBuffers() &&
+           mh.numAttributes == layout.numAttributes() &&
+           mh.vertexSize == layout.vertexSize() &&
+           Uint64(mh.numVertices) * mh.vertexSize == mh.vertexBytes;
+  }
+
+  bool validLod(const MeshLod &lod, Uint32 numIndices) {
+    return Uint64(lod.indexOffset) + lod.indexCount <= numIndices;
+  }
+
+  struct Writer {
+    std::ofstream &out;
+    size_t pos = 0;
+
+    void write(const void *src, size_t bytes) {
+      out.write(static_cast<const char *>(src), std::streamsize(bytes));
+      pos += bytes;
+      const size_t padding = alignUp(pos) - pos;
+      static constexpr char zeros[16]{};
+      out.write(zeros, std::streamsize(padding));
+      pos += padding;
+    }
+  };
+
+  bool sourceStamp(const fs::path &source, Sint64 &mtime, Uint64 &size) {
+    std::error_code ec;
+    auto time = fs::last_write_time(source, ec);
+    if (ec)
+      return false;
+    size = fs::file_size(source, ec);
+    if (ec)
+      return false;
+    mtime = Sint64(time.time_since_epoch().count());
+    return true;
+  }
+} // namespace
+
+MeshCacheFile::MeshCacheFile(const fs::path &cacheFile, const fs::path &source,
+                             const MeshLayout &layout,
+                             const MeshProcessOptions &options)
+    : m_file(cacheFile) {
+  if (!m_file)
+    return;
+
+  Sint64 mtime;
+  Uint64 size;
+  if (!sourceStamp(source, mtime, size))
+    return;
+
+  Reader reader{m_file.data()};
+  auto *header = reader.take<FileHeader>();
+  if (!header || SDL_memcmp(header->magic, kMagic, sizeof(kMagic)) != 0 ||
+      header->version != kVersion ||
+      header->byteOrderMark != kByteOrderMark ||
+      header->sourceMtime != mtime || header->sourceSize != size ||
+      header->lodLevels != options.lodLevels ||
+      header->optimized != Uint32(options.optimize))
+    return;
+
+  // guard against hash collisions in the cache file name
+  const std::string sourceStr = source.string();
+  auto *path = reader.take<char>(header->pathLength);
+  if (!path || std::string_view(path, header->pathLength) != sourceStr)
+    return;
+
+  if (!reader.has<MeshHeader>(header->numMeshes))
+    return;
+  m_meshes.reserve(header->numMeshes);
+  m_materials.reserve(header->numMeshes);
+  for (Uint32 i = 0; i < header->numMeshes; i++) {
+    auto *mh = reader.take<MeshHeader>();
+    if (!mh || !validMeshHeader(*mh, layout))
+      return;
+    auto *buffers =
+        reader.take<SDL_GPUVertexBufferDescription>(mh->numBuffers);
+    auto *attrs = reader.take<SDL_GPUVertexAttribute>(mh->numAttributes);
+    auto *vertices = reader.take<char>(mh->vertexBytes);
+    auto *indices = reader.take<MeshData::IndexType>(mh->numIndices);
+    auto *lods = reader.take<MeshLod>(mh->numLods);
+    if (!buffers || !attrs || !vertices || (mh->numIndices > 0 && !indices) ||
+        (mh->numLods > 0 && !lods))
+      return;
+    // out-of-range indices would be read out of the vertex buffer on the GPU
+    for (Uint32 j = 0; j < mh->numIndices; j++) {
+      if (indices[j] >= mh->numVertices)
+        return;
+    }
+    for (Uint32 j = 0; j < mh->numLods; j++) {
+      if (!validLod(lods[j], mh->numIndices))
+        return;
+    }
+
+    MeshLayout meshLayout;
+    for (Uint32 j = 0; j < mh->numBuffers; j++)
+      meshLayout.addBinding(buffers[j].slot, buffers[j].pitch);
+    for (Uint32 j = 0; j < mh->numAttributes; j++)
+      meshLayout.addAttribute(VertexAttrib(attrs[j].location),
+                              attrs[j].buffer_slot, attrs[j].format,
+                              attrs[j].offset);
+    if (!(meshLayout == layout))
+      return;
+
+    MeshDataView &view = m_meshes.emplace_back(
+        SDL_GPUPrimitiveType(mh->primitiveType), meshLayout,
+        std::span{vertices, mh->vertexBytes},
+        std::span{indices, mh->numIndices});
+    view.positionDequant = Mat4f::Map(mh->positionDequant);
+    view.lods = {lods, mh->numLods};
+    PbrMaterial &material = m_materials.emplace_back();
+    material.baseColor = Float4::Map(mh->baseColor);
+    material.metalness = mh->metalness;
+    material.roughness = mh->roughness;
+    material.ao = mh->ao;
+  }
+  m_valid = true;
+}
+
+void MeshCacheFile::toOwned(std::vector<MeshData> &meshData) const {
+  meshData.reserve(meshData.size() + m_meshes.size());
+  for (size_t i = 0; i < m_meshes.size(); i++) {
+    MeshData &md = meshData.emplace_back(m_meshes[i].toOwned());
+    md.material = m_materials[i];
+  }
+}
+
+namespace {
+  struct CacheSettings {
+    std::mutex mutex;
+    fs::path directory;
+    bool enabled;
+
+    CacheSettings() {
+      const char *env = std::getenv("CANDLEWICK_MESH_CACHE_DIR");
+      if (env)
+        directory = env;
+      else
+        directory = userCacheDirectory();
+      // opt-in: the cache writes to the user's file system
+      enabled = env && *env;
+    }
+
+    /// Per-user cache directory of the platform: the cache must not be
+    /// shared with other users, who could plant files in it.
+    static fs::path userCacheDirectory() {
+      fs::path base;
+#if defined(_WIN32)
+      if (const char *local = std::getenv("LOCALAPPDATA"))
+        base = local;
+#elif defined(__APPLE__)
+      if (const char *home = std::getenv("HOME"))
+        base = fs::path(home) / "Library" / "Caches";
+#else
+      if (const char *xdg = std::getenv("XDG_CACHE_HOME"); xdg && *xdg)
+        base = xdg;
+      else if (const char *home = std::getenv("HOME"))
+        base = fs::path(home) / ".cache";
+#endif
+      if (base.empty())
+        return {};
+      return base / "candlewick" / "meshes";
+    }
+  };
+
+  CacheSettings &cacheSettings() {
+    static CacheSettings settings;
+    return settings;
+  }
+} // namespace
+
+fs::path meshCacheDirectory() {
+  auto &settings = cacheSettings();
+  std::lock_guard lock{settings.mutex};
+  return settings.directory;
+}
+
+void setMeshCacheDirectory(fs::path dir) {
+  auto &settings = cacheSettings();
+  std::lock_guard lock{settings.mutex};
+  settings.directory = std::move(dir);
+}
+
+void setMeshCacheFileEnabled(bool enabled) {
+  auto &settings = cacheSettings();
+  std::lock_guard lock{settings.mutex};
+  settings.enabled = enabled;
+}
+
+bool meshCacheFileEnabled() {
+  auto &settings = cacheSettings();
+  std::lock_guard lock{settings.mutex};
+  return settings.enabled;
+}
+
+fs::path meshCacheFilePath(const fs::path &source, const MeshLayout &layout,
+                           const MeshProcessOptions &options) {
+  // the same source is cached separately for each requested layout and
+  // processing
+  std::string key = source.string();
+  key.append(reinterpret_cast<const char *>(layout.m_bufferDescs.data()),
+             layout.numBuffers() * sizeof(SDL_GPUVertexBufferDescription));
+  key.append(reinterpret_cast<const char *>(layout.m_attrs.data()),
+             layout.numAttributes() * sizeof(SDL_GPUVertexAttribute));
+  const Uint32 processing[2]{options.lodLevels, Uint32(options.optimize)};
+  key.append(reinterpret_cast<const char *>(processing), sizeof(processing));
+  const size_t hash = std::hash<std::string>{}(key);
+  char name[32];
+  SDL_snprintf(name, sizeof(name), "%016zx.cwmesh", hash);
+  return meshCacheDirectory() / name;
+}
+
+bool writeMeshCacheFile(const fs::path &cacheFile, const fs::path &source,
+                        std::span<const MeshData> meshData,
+                        const MeshProcessOptions &options) {
+  FileHeader header;
+  SDL_memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kVersion;
+  header.byteOrderMark = kByteOrderMark;
+  if (!sourceStamp(source, header.sourceMtime, header.sourceSize))
+    return false;
+  const std::string sourceStr = source.string();
+  header.numMeshes = Uint32(meshData.size());
+  header.pathLength = Uint32(sourceStr.size());
+  header.lodLevels = options.lodLevels;
+  header.optimized = Uint32(options.optimize);
+
+  std::error_code ec;
+  fs::create_directories(cacheFile.parent_path(), ec);
+  if (ec)
+    return false;
+
+  // unique temporary name, as several threads may import the same file
+  std::ostringstream suffix;
+  suffix << ".tmp." << std::this_thread::get_id();
+  fs::path tmpFile = cacheFile;
+  tmpFile += suffix.str();
+  {
+    std::ofstream out{tmpFile, std::ios::binary | std::ios::trunc};
+    if (!out) {
+      fs::remove(tmpFile, ec);
+      return false;
+    }
+    Writer writer{out};
+    writer.write(&header, sizeof(header));
+    writer.write(sourceStr.data(), sourceStr.size());
+    for (const MeshData &md : meshData) {
+      const MeshLayout &layout = md.layout;
+      const PbrMaterial &material = md.material;
+      MeshHeader mh{
+          .primitiveType = Uint32(md.primitiveType),
+          .numBuffers = layout.numBuffers(),
+          .numAttributes = layout.numAttributes(),
+          .numVertices = md.numVertices(),
+          .numIndices = md.numIndices(),
+          .vertexSize = layout.vertexSize(),
+          .vertexBytes = md.vertexBytes(),
+          .baseColor = {material.baseColor[0], material.baseColor[1],
+                        material.baseColor[2], material.baseColor[3]},
+          .metalness = material.metalness,
+          .roughness = material.roughness,
+          .ao = material.ao,
+          .numLods = Uint32(md.lods.size()),
+      };
+      Mat4f::Map(mh.positionDequant) = md.positionDequant;
+      writer.write(&mh, sizeof(mh));
+      writer.write(layout.m_bufferDescs.data(),
+                   layout.numBuffers() *
+                       sizeof(SDL_GPUVertexBufferDescription));
+      writer.write(layout.m_attrs.data(),
+                   layout.numAttributes() * sizeof(SDL_GPUVertexAttribute));
+      writer.write(md.vertexData().data(), md.vertexBytes());
+      writer.write(md.indexData.data(),
+                   md.numIndices() * sizeof(MeshData::IndexType));
+      writer.write(md.lods.data(), md.lods.size() * sizeof(MeshLod));
+    }
+    out.close();
+    if (!out) {
+      // e.g. a full disk: do not leave a partial file behind
+      fs::remove(tmpFile, ec);
+      return false;
+    }
+  }
+  fs::rename(tmpFile, cacheFile, ec);
+  if (ec) {
+    SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION,
+                "Failed to write mesh cache file %s: %s",
+                cacheFile.string().c_str(), ec.message().c_str());
+    fs::remove(tmpFile, ec);
+    return false;
+  }
+  return true;
+}
+
+} // namespace candlewick
@@ -0,0 +1,99 @@
+#pragma once
+
+#include "Utils.h"
+#include "LoadMesh.h"
+#include "MeshDataView.h"
+
+#include <filesystem>
+#include <span>
+#include <vector>
+
+namespace candlewick {
+
+/// \brief Read-only memory mapping of a file.
+///
+/// Falls back to reading the file into memory on platforms without \c mmap.
+class MappedFile {
+public:
+  explicit MappedFile(const std::filesystem::path &path);
+  MappedFile(const MappedFile &) = delete;
+  MappedFile(MappedFile &&other) noexcept;
+  MappedFile &operator=(const MappedFile &) = delete;
+  MappedFile &operator=(MappedFile &&other) = delete;
+  ~MappedFile() noexcept;
+
+  /// \brief Whether the file was successfully mapped.
+  explicit operator bool() const { return m_data != nullptr; }
+  std::span<const char> data() const { return {m_data, m_size}; }
+
+private:
+  const char *m_data = nullptr;
+  size_t m_size = 0;
+  std::vector<char> m_fallback;
+};
+
+/// \brief Preprocessed mesh cache file, memory-mapped.
+///
+/// The file holds the GPU-ready output of loadSceneMeshes() for a given source
+/// file and processing: mesh layouts, vertex blobs, indices (including those
+/// of the levels of detail), levels of detail and materials. The meshes are
+/// exposed as views into the mapping, and can be copied into MeshData or
+/// directly into upload buffers.
+///
+/// \sa loadSceneMeshes()
+class MeshCacheFile {
+public:
+  /// \brief Map a cache file and validate it against its source file, the
+  /// requested mesh layout and processing. On failure (missing, stale or
+  /// corrupt file), the object is empty.
+  MeshCacheFile(const std::filesystem::path &cacheFile,
+                const std::filesystem::path &source, const MeshLayout &layout,
+                const MeshProcessOptions &options = {});
+
+  explicit operator bool() const { return m_valid; }
+  std::span<const MeshDataView> meshes() const { return m_meshes; }
+  std::span<const PbrMaterial> materials() const { return m_materials; }
+
+  /// \brief Copy the meshes out into owned MeshData objects.
+  void toOwned(std::vector<MeshData> &meshData) const;
+
+private:
+  MappedFile m_file;
+  std::vector<MeshDataView> m_meshes;
+  std::vector<PbrMaterial> m_materials;
+  bool m_valid = false;
+};
+
+/// \brief Directory where preprocessed mesh files are stored.
+///
+/// Defaults to the \c CANDLEWICK_MESH_CACHE_DIR environment variable if set,
+/// otherwise to a subdirectory of the user's cache directory (\c
+/// XDG_CACHE_HOME or \c ~/.cache, \c ~/Library/Caches on macOS, \c
+/// LOCALAPPDATA on Windows). If none is found, meshes are never cached.
+std::filesystem::path meshCacheDirectory();
+void setMeshCacheDirectory(std::filesystem::path dir);
+
+/// \brief Enable or disable the preprocessed mesh cache in loadSceneMeshes().
+/// It is disabled by default, unless the \c CANDLEWICK_MESH_CACHE_DIR
+/// environment variable is set to a non-empty path.
+void setMeshCacheFileEnabled(bool enabled);
+bool meshCacheFileEnabled();
+
+/// \brief Path to the cache file for a given (canonical) source path, loaded
+/// with the given mesh layout and processing.
+std::filesystem::path
+meshCacheFilePath(const std::filesystem::path &source, const MeshLayout &layout,
+                  const MeshProcessOptions &options = {});
+
+/// \brief Write a preprocessed mesh cache file for \p source.
+///
+/// The file is written to a temporary file and then renamed, so that
+/// concurrent readers and writers never observe a partially written file.
+/// \returns Whether the file was successfully written.
+/// \param options Processing the meshes went through, checked on load.
+bool writeMeshCacheFile(const std::filesystem::path &cacheFile,
+                        const std::filesystem::path &source,
+                        std::span<const MeshData> meshData,
+                        const MeshProcessOptions &options = {});
+
+} // namespace candlewick
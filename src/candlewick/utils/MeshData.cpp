@@ -1,9 +1,15 @@
 #include "MeshData.h"
+#include "MeshDataView.h"
+#include "MeshTransforms.h"
 #include "../core/Device.h"
 #include "../core/Mesh.h"
+#include "../core/MeshArena.h"
 #include "../core/CommandBuffer.h"
+#include "../core/CompactVertex.h"
+#include "../core/errors.h"
 
 #include <SDL3/SDL_log.h>
+#include <type_traits>
 
 namespace candlewick {
 
@@ -18,6 +24,87 @@ MeshData::MeshData(SDL_GPUPrimitiveType primitiveType, const MeshLayout &layout,
   m_numVertices = static_cast<Uint32>(m_vertexData.size()) / m_vertexSize;
 }
 
+namespace {
+  /// Add the levels of detail of a batch of mesh data to the Mesh created from
+  /// it. Elements of the batch with fewer levels repeat their coarsest one.
+  template <typename MeshDataT>
+  void addLodViews(Mesh &mesh, std::span<const MeshDataT> meshDatas) {
+    size_t numLods = 0;
+    for (auto &data : meshDatas)
+      numLods = std::max(numLods, data.lods.size());
+    for (size_t l = 0; l < numLods; l++) {
+      float error = 0.f;
+      for (auto &data : meshDatas) {
+        if (!data.lods.empty())
+          error = std::max(
+              error, data.lods[std::min(l, data.lods.size() - 1)].error);
+      }
+      mesh.addLod(error);
+      Uint32 indexOffset = 0;
+      for (size_t i = 0; i < meshDatas.size(); i++) {
+        const auto &lods = meshDatas[i].lods;
+        if (l < lods.size())
+          mesh.setLodView(i, indexOffset + lods[l].indexOffset,
+                          lods[l].indexCount);
+        indexOffset += meshDatas[i].numIndices();
+      }
+    }
+  }
+
+  /// Set the bounds of the views of the Mesh created from a batch of mesh
+  /// data.
+  template <typename MeshDataT>
+  void addViewBounds(Mesh &mesh, std::span<const MeshDataT> meshDatas) {
+    for (size_t i = 0; i < meshDatas.size(); i++)
+      mesh.setViewBounds(i, computeBounds(meshDatas[i]));
+  }
+
+  /// Add the meshlets of a batch of MeshData to the views of the Mesh created
+  /// from it. Mesh data views carry no meshlets.
+  template <typename MeshDataT>
+  void addMeshlets(Mesh &mesh, std::span<const MeshDataT> meshDatas) {
+    if constexpr (std::is_same_v<MeshDataT, MeshData>) {
+      for (size_t i = 0; i < meshDatas.size(); i++) {
+        if (!meshDatas[i].meshlets.empty())
+          mesh.setMeshlets(i, meshDatas[i].meshlets);
+      }
+    }
+  }
+
+  /// Add one view per element of a batch of mesh data, laid out one after the
+  /// other in the Mesh's buffers.
+  template <typename MeshDataT>
+  void addBatchViews(Mesh &mesh, std::span<const MeshDataT> meshDatas) {
+    Uint32 vertexOffset = 0, indexOffset = 0;
+    for (size_t i = 0; i < meshDatas.size(); i++) {
+      mesh.addView(vertexOffset, meshDatas[i].numVertices(), indexOffset,
+                   meshDatas[i].baseIndexCount());
+      vertexOffset += meshDatas[i].numVertices();
+      indexOffset += meshDatas[i].numIndices();
+    }
+    addLodViews(mesh, meshDatas);
+    addMeshlets(mesh, meshDatas);
+    addViewBounds(mesh, meshDatas);
+  }
+} // namespace
+
+AABBf computeBounds(const MeshData &meshData) {
+  return computeBounds(MeshDataView{meshData});
+}
+
+AABBf computeBounds(const MeshDataView &meshData) {
+  AABBf box;
+  auto posAttr = meshData.layout.getAttribute(VertexAttrib::Position);
+  if (!posAttr)
+    return box;
+  const Uint32 stride = meshData.layout.vertexSize();
+  for (Uint32 i = 0; i < meshData.numVertices(); i++) {
+    const char *vertex = meshData.vertexData.data() + size_t(i) * stride;
+    box.extend(decodeVertexAttribute(vertex, *posAttr).head<3>());
+  }
+  return box;
+}
+
 Mesh createMesh(const Device &device, const MeshData &meshData, bool upload) {
   auto &layout = meshData.layout;
   SDL_GPUBufferCreateInfo vtxInfo{.usage = SDL_GPU_BUFFERUSAGE_VERTEX,
@@ -25,23 +112,26 @@ Mesh createMesh(const Device &device, const MeshData &meshData, bool upload) {
                                           layout.vertexSize(),
                                   .props = 0};
 
+  const SDL_GPUIndexElementSize indexElementSize = meshData.indexElementSize();
   SDL_GPUBuffer *vertexBuffer = SDL_CreateGPUBuffer(device, &vtxInfo);
   SDL_GPUBuffer *indexBuffer = NULL;
   if (meshData.isIndexed()) {
-    SDL_GPUBufferCreateInfo indexInfo{.usage = SDL_GPU_BUFFERUSAGE_INDEX,
-                                      .size = meshData.numIndices() *
-                                              layout.indexSize(),
-                                      .props = 0};
+    SDL_GPUBufferCreateInfo indexInfo{
+        .usage = SDL_GPU_BUFFERUSAGE_INDEX,
+        .size = meshData.numIndices() * indexElementBytes(indexElementSize),
+        .props = 0};
     indexBuffer = SDL_CreateGPUBuffer(device, &indexInfo);
   }
-  Mesh mesh = createMesh(device, meshData, vertexBuffer, indexBuffer);
+  Mesh mesh = createMesh(device, meshData, vertexBuffer, indexBuffer,
+                         indexElementSize);
   if (upload)
     uploadMeshToDevice(device, mesh, meshData);
   return mesh;
 }
 
 Mesh createMesh(const Device &device, const MeshData &meshData,
-                SDL_GPUBuffer *vertexBuffer, SDL_GPUBuffer *indexBuffer) {
+                SDL_GPUBuffer *vertexBuffer, SDL_GPUBuffer *indexBuffer,
+                SDL_GPUIndexElementSize indexElementSize) {
   Mesh mesh{device, meshData.layout};
 
   mesh.bindVertexBuffer(0, vertexBuffer);
@@ -49,121 +139,285 @@ Mesh createMesh(const Device &device, const MeshData &meshData,
   mesh.indexCount = meshData.numIndices();
   if (meshData.isIndexed()) {
     mesh.setIndexBuffer(indexBuffer);
+    mesh.indexElementSize = indexElementSize;
   }
-  mesh.addView(0u, mesh.vertexCount, 0u, mesh.indexCount);
+  mesh.positionDequant = meshData.positionDequant;
+  mesh.addView(0u, mesh.vertexCount, 0u, meshData.baseIndexCount());
+  const std::span<const MeshData> batch{&meshData, 1};
+  addLodViews(mesh, batch);
+  addMeshlets(mesh, batch);
+  addViewBounds(mesh, batch);
   return mesh;
 }
 
+namespace {
+  template <typename MeshDataT>
+  Mesh createBatchMesh(const Device &device,
+                       std::span<const MeshDataT> meshDatas, bool upload) {
+    // index type size, in bytes
+    assert(meshDatas.size() > 0);
+    auto &layout = meshDatas[0].layout;
+
+    Uint32 numVertices = 0, numIndices = 0;
+    for (auto &data : meshDatas) {
+      // views of a Mesh are drawn with the same dequantization transform
+      assert(data.positionDequant == meshDatas[0].positionDequant);
+      numVertices += data.numVertices();
+      numIndices += data.numIndices();
+    }
+    Mesh mesh{device, meshDatas[0].layout};
+    assert(mesh.numVertexBuffers() == 1);
+    mesh.positionDequant = meshDatas[0].positionDequant;
+
+    SDL_GPUBufferCreateInfo vtxInfo{
+        .usage = SDL_GPU_BUFFERUSAGE_VERTEX,
+        .size = Uint32(layout.vertexSize() * numVertices),
+        .props = 0};
+
+    SDL_GPUBufferCreateInfo idxInfo;
+    mesh.indexElementSize = batchIndexElementSize(meshDatas);
+
+    if (numIndices > 0) {
+      idxInfo = {.usage = SDL_GPU_BUFFERUSAGE_INDEX,
+                 .size = numIndices * mesh.indexSize(),
+                 .props = 0};
+    }
+
+    auto masterVertexBuffer = SDL_CreateGPUBuffer(device, &vtxInfo);
+    auto masterIndexBuffer =
+        (numIndices > 0) ? SDL_CreateGPUBuffer(device, &idxInfo) : NULL;
+    mesh.vertexCount = numVertices;
+    mesh.indexCount = numIndices;
+    mesh.bindVertexBuffer(0, masterVertexBuffer)
+        .setIndexBuffer(masterIndexBuffer);
+
+    addBatchViews(mesh, meshDatas);
+    if (upload)
+      uploadMeshesToDevice(device, mesh.views(), meshDatas);
+    return mesh;
+  }
+
+  template <typename MeshDataT>
+  Mesh createBatchMesh(const Device &device, MeshArena &arena,
+                       std::span<const MeshDataT> meshDatas, bool upload) {
+    assert(meshDatas.size() > 0);
+    Uint32 numVertices = 0, numIndices = 0;
+    for (auto &data : meshDatas) {
+      assert(data.layout == arena.layout());
+      assert(data.positionDequant == meshDatas[0].positionDequant);
+      numVertices += data.numVertices();
+      numIndices += data.numIndices();
+    }
+    if (numIndices > 0 &&
+        indexElementBytes(batchIndexElementSize(meshDatas)) >
+            indexElementBytes(arena.indexElementSize()))
+      throw std::runtime_error("MeshArena index elements are too small.");
+    std::optional<Mesh> mesh = arena.allocate(numVertices, numIndices);
+    if (!mesh)
+      throw std::runtime_error("MeshArena is out of space.");
+    mesh->positionDequant = meshDatas[0].positionDequant;
+
+    addBatchViews(*mesh, meshDatas);
+    if (upload)
+      uploadMeshesToDevice(device, mesh->views(), meshDatas);
+    return std::move(*mesh);
+  }
+} // namespace
+
 Mesh createMeshFromBatch(const Device &device,
                          std::span<const MeshData> meshDatas, bool upload) {
-  // index type size, in bytes
-  assert(meshDatas.size() > 0);
-  auto &layout = meshDatas[0].layout;
+  return createBatchMesh(device, meshDatas, upload);
+}
+
+Mesh createMeshFromBatch(const Device &device,
+                         std::span<const MeshDataView> meshDatas, bool upload) {
+  return createBatchMesh(device, meshDatas, upload);
+}
 
-  Uint32 numVertices = 0, numIndices = 0;
-  for (auto &data : meshDatas) {
-    numVertices += data.numVertices();
-    numIndices += data.numIndices();
+Mesh createMeshFromBatch(const Device &device,
+                         std::vector<MeshData> &&meshDatas, bool upload,
+                         bool optimize) {
+  if (optimize) {
+    for (MeshData &data : meshDatas)
+      optimizeMesh(data);
   }
-  Mesh mesh{device, meshDatas[0].layout};
-  assert(mesh.numVertexBuffers() == 1);
+  return createBatchMesh(device, std::span<const MeshData>{meshDatas},
+                         upload);
+}
 
-  SDL_GPUBufferCreateInfo vtxInfo{.usage = SDL_GPU_BUFFERUSAGE_VERTEX,
-                                  .size =
-                                      Uint32(layout.vertexSize() * numVertices),
-                                  .props = 0};
+Mesh createMesh(const Device &device, MeshArena &arena,
+                const MeshData &meshData, bool upload) {
+  return createMeshFromBatch(device, arena, std::span{&meshData, 1}, upload);
+}
 
-  SDL_GPUBufferCreateInfo idxInfo;
+Mesh createMeshFromBatch(const Device &device, MeshArena &arena,
+                         std::span<const MeshData> meshDatas, bool upload) {
+  return createBatchMesh(device, arena, meshDatas, upload);
+}
+
+Mesh createMeshFromBatch(const Device &device, MeshArena &arena,
+                         std::span<const MeshDataView> meshDatas, bool upload) {
+  return createBatchMesh(device, arena, meshDatas, upload);
+}
 
-  if (numIndices > 0) {
-    idxInfo = {.usage = SDL_GPU_BUFFERUSAGE_INDEX,
-               .size = numIndices * layout.indexSize(),
-               .props = 0};
+namespace {
+  /// Write indices to staging memory, narrowing them to 16 bits if required.
+  void copyIndices(std::byte *dst, std::span<const MeshData::IndexType> indices,
+                   SDL_GPUIndexElementSize elementSize) {
+    if (elementSize == SDL_GPU_INDEXELEMENTSIZE_32BIT) {
+      SDL_memcpy(dst, indices.data(), indices.size_bytes());
+      return;
+    }
+    Uint16 *out = reinterpret_cast<Uint16 *>(dst);
+    for (size_t i = 0; i < indices.size(); i++) {
+      SDL_assert(indices[i] <= 0xFFFFu);
+      out[i] = Uint16(indices[i]);
+    }
   }
 
-  auto masterVertexBuffer = SDL_CreateGPUBuffer(device, &vtxInfo);
-  auto masterIndexBuffer =
-      (numIndices > 0) ? SDL_CreateGPUBuffer(device, &idxInfo) : NULL;
-  mesh.vertexCount = numVertices;
-  mesh.indexCount = numIndices;
-  mesh.bindVertexBuffer(0, masterVertexBuffer)
-      .setIndexBuffer(masterIndexBuffer);
+  /// Gather the vertex positions to staging memory, tightly packed, for the
+  /// position-only stream.
+  void copyPositions(std::byte *dst, std::span<const char> vertexData,
+                     const MeshLayout &layout) {
+    const SDL_GPUVertexAttribute *pos =
+        layout.getAttribute(VertexAttrib::Position);
+    SDL_assert(pos);
+    const Uint32 stride = layout.vertexSize();
+    const Uint64 size = vertexElementSize(pos->format);
+    const size_t count = vertexData.size() / stride;
+    for (size_t i = 0; i < count; i++)
+      SDL_memcpy(dst + i * size, vertexData.data() + i * stride + pos->offset,
+                 size);
+  }
 
-  Uint32 vertexOffset = 0, indexOffset = 0;
-  for (size_t i = 0; i < meshDatas.size(); i++) {
-    auto &view = mesh.addView(vertexOffset, meshDatas[i].numVertices(),
-                              indexOffset, meshDatas[i].numIndices());
-    vertexOffset += meshDatas[i].numVertices();
-    indexOffset += meshDatas[i].numIndices();
-    if (upload)
-      uploadMeshToDevice(device, view, meshDatas[i]);
+  Uint32 positionStreamSize(const MeshLayout &layout, Uint32 numVertices) {
+    return positionStreamLayout(layout).vertexSize() * numVertices;
   }
-  return mesh;
-}
+} // namespace
 
-void uploadMeshToDevice(const Device &device, const MeshView &meshView,
-                        const MeshData &meshData) {
+void uploadMeshesToDevice(const Device &device,
+                          std::span<const MeshView> meshViews,
+                          std::span<const MeshDataView> meshDatas) {
+  SDL_assert(meshViews.size() == meshDatas.size());
+  const size_t count = meshViews.size();
+  if (count == 0)
+    return;
 
-  SDL_GPUTransferBuffer *transfer_buffer;
-  SDL_GPUCopyPass *copy_pass;
+  // Pack all payloads in a single staging allocation. Each region starts at a
+  // 16-byte aligned offset.
+  struct Region {
+    Uint32 vertexSrc, vertexSize;
+    Uint32 indexSrc, indexSize;
+    Uint32 positionSrc, positionSize;
+  };
+  std::vector<Region> regions(count);
+  Uint32 total_payload_size = 0;
+  for (size_t i = 0; i < count; i++) {
+    const MeshDataView &data = meshDatas[i];
+    Region &r = regions[i];
+    r.vertexSrc = total_payload_size;
+    r.vertexSize = Uint32(data.vertexData.size());
+    total_payload_size = math::roundUpTo16(r.vertexSrc + r.vertexSize);
+    r.indexSrc = total_payload_size;
+    r.indexSize = meshViews[i].isIndexed()
+                      ? data.numIndices() * indexElementBytes(
+                                                meshViews[i].indexElementSize)
+                      : 0u;
+    total_payload_size = math::roundUpTo16(r.indexSrc + r.indexSize);
+    r.positionSrc = total_payload_size;
+    r.positionSize = meshViews[i].positionBuffer
+                         ? positionStreamSize(data.layout, data.numVertices())
+                         : 0u;
+    total_payload_size = math::roundUpTo16(r.positionSrc + r.positionSize);
+  }
 
+  UploadRing &ring = device.uploadRing();
   CommandBuffer upload_command_buffer{device};
-  copy_pass = SDL_BeginGPUCopyPass(upload_command_buffer);
+  StagingAllocation staging =
+      ring.allocate(upload_command_buffer, total_payload_size);
+  for (size_t i = 0; i < count; i++) {
+    const MeshDataView &data = meshDatas[i];
+    const Region &r = regions[i];
+    SDL_memcpy(staging.data + r.vertexSrc, data.vertexData.data(),
+               r.vertexSize);
+    if (r.indexSize > 0)
+      copyIndices(staging.data + r.indexSrc, data.indexData,
+                  meshViews[i].indexElementSize);
+    if (r.positionSize > 0)
+      copyPositions(staging.data + r.positionSrc, data.vertexData,
+                    data.layout);
+  }
+  ring.unmap(staging);
 
-  auto &layout = meshData.layout;
-  const Uint32 vertex_payload_size =
-      meshData.numVertices() * layout.vertexSize();
-  const Uint32 index_payload_size = meshData.numIndices() * layout.indexSize();
-  const Uint32 total_payload_size = vertex_payload_size + index_payload_size;
-
-  SDL_GPUTransferBufferCreateInfo transfer_buffer_desc{
-      .usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD,
-      .size = total_payload_size,
-      .props = 0,
-  };
-  transfer_buffer = SDL_CreateGPUTransferBuffer(device, &transfer_buffer_desc);
-  {
-    std::byte *map =
-        (std::byte *)SDL_MapGPUTransferBuffer(device, transfer_buffer, false);
+  SDL_GPUCopyPass *copy_pass = SDL_BeginGPUCopyPass(upload_command_buffer);
+  for (size_t i = 0; i < count; i++) {
+    const MeshView &meshView = meshViews[i];
+    const MeshLayout &layout = meshDatas[i].layout;
+    const Region &r = regions[i];
     // copy vertices
     {
-      SDL_memcpy(map, meshData.vertexData().data(), vertex_payload_size);
       SDL_GPUTransferBufferLocation src_location{
-          .transfer_buffer = transfer_buffer,
-          .offset = 0,
+          .transfer_buffer = staging.buffer,
+          .offset = staging.offset + r.vertexSrc,
       };
       SDL_GPUBufferRegion dst_region{
           .buffer = meshView.vertexBuffers[0],
           .offset = meshView.vertexOffset * layout.vertexSize(),
-          .size = vertex_payload_size,
+          .size = r.vertexSize,
       };
       SDL_UploadToGPUBuffer(copy_pass, &src_location, &dst_region, false);
     }
     // copy indices
-    if (meshView.isIndexed()) {
-      SDL_memcpy(map + vertex_payload_size, meshData.indexData.data(),
-                 index_payload_size);
+    if (r.indexSize > 0) {
       SDL_GPUTransferBufferLocation src_location{
-          .transfer_buffer = transfer_buffer,
-          .offset = vertex_payload_size,
+          .transfer_buffer = staging.buffer,
+          .offset = staging.offset + r.indexSrc,
       };
       SDL_GPUBufferRegion dst_region{
           .buffer = meshView.indexBuffer,
-          .offset = meshView.indexOffset * layout.indexSize(),
-          .size = index_payload_size,
+          .offset = meshView.indexOffset *
+                    indexElementBytes(meshView.indexElementSize),
+          .size = r.indexSize,
+      };
+      SDL_UploadToGPUBuffer(copy_pass, &src_location, &dst_region, false);
+    }
+    // copy the position-only stream
+    if (r.positionSize > 0) {
+      SDL_GPUTransferBufferLocation src_location{
+          .transfer_buffer = staging.buffer,
+          .offset = staging.offset + r.positionSrc,
+      };
+      SDL_GPUBufferRegion dst_region{
+          .buffer = meshView.positionBuffer,
+          .offset = positionStreamSize(layout, meshView.vertexOffset),
+          .size = r.positionSize,
       };
       SDL_UploadToGPUBuffer(copy_pass, &src_location, &dst_region, false);
     }
-    SDL_UnmapGPUTransferBuffer(device, transfer_buffer);
   }
-  SDL_ReleaseGPUTransferBuffer(device, transfer_buffer);
   SDL_EndGPUCopyPass(copy_pass);
-  if (!upload_command_buffer.submit()) {
-    SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
-                 "%s: Failed to submit command buffer: %s", __FILE__,
-                 SDL_GetError());
-    assert(false);
-  }
+  [[maybe_unused]] const bool submitted = ring.submit(upload_command_buffer);
+  assert(submitted);
+}
+
+void uploadMeshesToDevice(const Device &device,
+                          std::span<const MeshView> meshViews,
+                          std::span<const MeshData> meshDatas) {
+  std::vector<MeshDataView> views;
+  views.reserve(meshDatas.size());
+  for (const MeshData &data : meshDatas)
+    views.emplace_back(data);
+  uploadMeshesToDevice(device, meshViews, views);
+}
+
+void uploadMeshToDevice(const Device &device, const MeshView &meshView,
+                        const MeshDataView &meshData) {
+  uploadMeshesToDevice(device, {&meshView, 1}, {&meshData, 1});
+}
+
+void uploadMeshToDevice(const Device &device, const MeshView &meshView,
+                        const MeshData &meshData) {
+  uploadMeshToDevice(device, meshView, MeshDataView{meshData});
 }
 
 void uploadMeshToDevice(const Device &device, const Mesh &mesh,
@@ -173,4 +427,117 @@ void uploadMeshToDevice(const Device &device, const Mesh &mesh,
   uploadMeshToDevice(device, mesh.view(0), meshData);
 }
 
+namespace {
+  /// Record a copy of staged data to a buffer range.
+  void copyStagingToBuffer(CommandBuffer &command_buffer,
+                           const StagingAllocation &staging,
+                           SDL_GPUBuffer *buffer, Uint32 offset, Uint32 size,
+                           bool cycle) {
+    SDL_GPUCopyPass *copy_pass = SDL_BeginGPUCopyPass(command_buffer);
+    SDL_GPUTransferBufferLocation src_location{
+        .transfer_buffer = staging.buffer,
+        .offset = staging.offset,
+    };
+    SDL_GPUBufferRegion dst_region{
+        .buffer = buffer,
+        .offset = offset,
+        .size = size,
+    };
+    SDL_UploadToGPUBuffer(copy_pass, &src_location, &dst_region, cycle);
+    SDL_EndGPUCopyPass(copy_pass);
+  }
+
+  /// Grow the bounds of the views of \p mesh to the vertices \p vertexData
+  /// written from \p firstVertex on.
+  void growViewBounds(Mesh &mesh, Uint32 firstVertex,
+                      std::span<const char> vertexData) {
+    const MeshLayout &layout = mesh.layout();
+    auto posAttr = layout.getAttribute(VertexAttrib::Position);
+    if (!posAttr)
+      return;
+    const Uint32 stride = layout.vertexSize();
+    const Uint32 endVertex = firstVertex + Uint32(vertexData.size() / stride);
+    for (size_t i = 0; i < mesh.numViews(); i++) {
+      // vertex range of the view, relative to the Mesh
+      const MeshView &view = mesh.view(i);
+      const Uint32 viewBegin = view.vertexOffset - mesh.baseVertex();
+      const Uint32 begin = std::max(viewBegin, firstVertex);
+      const Uint32 end = std::min(viewBegin + view.vertexCount, endVertex);
+      if (begin >= end)
+        continue;
+      AABBf box = mesh.viewBounds(i);
+      for (Uint32 v = begin; v < end; v++) {
+        const char *vertex =
+            vertexData.data() + size_t(v - firstVertex) * stride;
+        box.extend(decodeVertexAttribute(vertex, *posAttr).head<3>());
+      }
+      mesh.setViewBounds(i, box);
+    }
+  }
+} // namespace
+
+void updateMeshVertices(const Device &device, CommandBuffer &command_buffer,
+                        Mesh &mesh, Uint32 firstVertex,
+                        std::span<const char> vertexData) {
+  SDL_assert(mesh.numVertexBuffers() == 1);
+  if (vertexData.empty())
+    return;
+  const Uint32 vertexSize = mesh.layout().vertexSize();
+  SDL_assert(vertexData.size() % vertexSize == 0);
+  const Uint32 count = Uint32(vertexData.size() / vertexSize);
+  SDL_assert(firstVertex + count <= mesh.vertexCount);
+
+  UploadRing &ring = device.uploadRing();
+  const Uint32 size = Uint32(vertexData.size());
+  StagingAllocation staging = ring.allocate(command_buffer, size);
+  SDL_memcpy(staging.data, vertexData.data(), size);
+  ring.unmap(staging);
+
+  // Cycling gives the buffer new storage with undefined contents: only do so
+  // when it is rewritten entirely, and is not shared with other meshes.
+  const bool cycle = !mesh.isArenaAllocated() && firstVertex == 0 &&
+                     count == mesh.vertexCount;
+  copyStagingToBuffer(command_buffer, staging, mesh.vertexBuffers[0],
+                      (mesh.baseVertex() + firstVertex) * vertexSize, size,
+                      cycle);
+
+  if (mesh.hasPositionStream()) {
+    const MeshLayout &layout = mesh.layout();
+    const Uint32 posSize = positionStreamSize(layout, count);
+    StagingAllocation posStaging = ring.allocate(command_buffer, posSize);
+    copyPositions(posStaging.data, vertexData, layout);
+    ring.unmap(posStaging);
+    copyStagingToBuffer(
+        command_buffer, posStaging, mesh.positionBuffer,
+        positionStreamSize(layout, mesh.baseVertex() + firstVertex), posSize,
+        cycle);
+  }
+
+  // the culling must not use the bounds of the previous vertices
+  growViewBounds(mesh, firstVertex, vertexData);
+  mesh.clearMeshlets();
+}
+
+void updateMeshIndices(const Device &device, CommandBuffer &command_buffer,
+                       const Mesh &mesh, Uint32 firstIndex,
+                       std::span<const MeshData::IndexType> indexData) {
+  SDL_assert(mesh.isIndexed());
+  if (indexData.empty())
+    return;
+  const Uint32 count = Uint32(indexData.size());
+  SDL_assert(firstIndex + count <= mesh.indexCount);
+
+  UploadRing &ring = device.uploadRing();
+  const Uint32 size = count * mesh.indexSize();
+  StagingAllocation staging = ring.allocate(command_buffer, size);
+  copyIndices(staging.data, indexData, mesh.indexElementSize);
+  ring.unmap(staging);
+
+  const bool cycle =
+      !mesh.isArenaAllocated() && firstIndex == 0 && count == mesh.indexCount;
+  copyStagingToBuffer(command_buffer, staging, mesh.indexBuffer,
+                      (mesh.baseIndex() + firstIndex) * mesh.indexSize(), size,
+                      cycle);
+}
+
 } // namespace candlewick
@@ -3,8 +3,10 @@
 #include "Utils.h"
 #include "../core/MeshLayout.h"
 #include "../core/MaterialUniform.h"
+#include "../core/Meshlet.h"
 #include "../core/Tags.h"
 
+#include <algorithm>
 #include <span>
 #include <SDL3/SDL_assert.h>
 #include <SDL3/SDL_gpu.h>
@@ -21,6 +23,30 @@ template <typename Derived> struct MeshDataBase {
     return static_cast<Uint32>(derived().indexData.size());
   }
   bool isIndexed() const { return numIndices() > 0; }
+  /// \brief Number of indices of the full-detail mesh, i.e. excluding those of
+  /// the coarser levels of detail.
+  Uint32 baseIndexCount() const {
+    const auto &lods = derived().lods;
+    return lods.empty() ? numIndices() : lods[0].indexOffset;
+  }
+
+  /// \brief Index element size of the GPU index buffer for this data. Indices
+  /// are stored as 32-bit integers on the CPU, and narrowed on upload.
+  SDL_GPUIndexElementSize indexElementSize() const {
+    return minimalIndexElementSize(numVertices());
+  }
+};
+
+/// \brief A coarser level of detail of a MeshData, drawn over the same
+/// vertices. Its indices are stored in MeshData::indexData, after those of the
+/// full-detail mesh.
+/// \sa generateLodChain()
+struct MeshLod {
+  Uint32 indexOffset; //< Offset of the level's indices, in elements.
+  Uint32 indexCount;  //< Number of indices of the level.
+  /// Simplification error of the level, as a distance, in the units of the
+  /// (dequantized) vertex positions.
+  float error;
 };
 
 class MeshData : public MeshDataBase<MeshData> {
@@ -33,6 +59,15 @@ public:
   MeshLayout layout;                  //< %Mesh layout.
   std::vector<IndexType> indexData;   //< Indices for indexed mesh. Optional.
   PbrMaterial material;               //< PBR material
+  /// Transform from the stored to the actual vertex positions, for layouts
+  /// with quantized positions. \sa PositionQuantization
+  Mat4f positionDequant = Mat4f::Identity();
+  /// Coarser levels of detail, from finest to coarsest. Empty if no LOD chain
+  /// was generated.
+  std::vector<MeshLod> lods;
+  /// Partition of the full-detail triangles into meshlets, in index order.
+  /// Empty if the mesh was not partitioned. \sa buildMeshlets()
+  std::vector<Meshlet> meshlets;
 
   explicit MeshData(NoInitT);
 
@@ -58,7 +93,6 @@ public:
   Uint32 vertexSize() const noexcept { return m_vertexSize; }
   /// \brief Size of the vertex data, in bytes.
   Uint64 vertexBytes() const noexcept { return m_vertexData.size(); }
-
   template <typename U> std::span<const U> viewAs() const {
     const U *begin = reinterpret_cast<const U *>(m_vertexData.data());
     return std::span<const U>(begin, m_numVertices);
@@ -106,6 +140,12 @@ MeshData::MeshData(SDL_GPUPrimitiveType primitiveType,
                                                           vertexData.size())},
                std::move(indexData)) {}
 
+/// \brief Bounding box of the vertex positions of the mesh data, as stored:
+/// quantized positions are left normalized, before MeshData::positionDequant.
+/// Empty if the layout has no position attribute.
+AABBf computeBounds(const MeshData &meshData);
+AABBf computeBounds(const MeshDataView &meshData);
+
 /// \brief Convert MeshData to a GPU Mesh object. This creates the
 /// required vertex buffer and index buffer (if required).
 /// \warning This does *not* upload the mesh data to the vertex and index
@@ -116,10 +156,24 @@ MeshData::MeshData(SDL_GPUPrimitiveType primitiveType,
 
 /// \brief Create a Mesh object from given mesh data, as a view into existing
 /// vertex and index buffers.
+/// \param indexElementSize Size of the elements of \p indexBuffer.
 /// \warning The constructed Mesh will **take ownership** of the buffers.
-[[nodiscard]] Mesh createMesh(const Device &device, const MeshData &meshData,
-                              SDL_GPUBuffer *vertexBuffer,
-                              SDL_GPUBuffer *indexBuffer);
+[[nodiscard]] Mesh
+createMesh(const Device &device, const MeshData &meshData,
+           SDL_GPUBuffer *vertexBuffer, SDL_GPUBuffer *indexBuffer,
+           SDL_GPUIndexElementSize indexElementSize =
+               SDL_GPU_INDEXELEMENTSIZE_32BIT);
+
+/// \brief Index element size for a batch of MeshData drawn as the views of a
+/// single Mesh. Indices of each view are relative to its first vertex, so this
+/// only depends on the largest element of the batch.
+inline SDL_GPUIndexElementSize
+batchIndexElementSize(std::span<const MeshData> meshDatas) {
+  Uint32 maxVertices = 0;
+  for (auto &data : meshDatas)
+    maxVertices = std::max(maxVertices, data.numVertices());
+  return minimalIndexElementSize(maxVertices);
+}
 
 /// \brief Create a Mesh from a batch of MeshData.
 /// \param[in] device GPU device
@@ -131,15 +185,114 @@ MeshData::MeshData(SDL_GPUPrimitiveType primitiveType,
                                        std::span<const MeshData> meshDatas,
                                        bool upload);
 
+/// \copydoc createMeshFromBatch(const Device &, std::span<const MeshData>,
+/// bool)
+[[nodiscard]] Mesh createMeshFromBatch(const Device &device,
+                                       std::span<const MeshDataView> meshDatas,
+                                       bool upload);
+
+/// \brief Create a Mesh from a batch of MeshData, which is first reordered
+/// for the vertex cache, overdraw and vertex fetch (see optimizeMesh()).
+///
+/// This overload is picked for temporaries and moved batches.
+/// \param[in] meshDatas Batch of meshes, released on return: unless
+/// \p upload is true, the Mesh is left for the caller to fill.
+/// \param[in] optimize Whether to optimize the meshes.
+[[nodiscard]] Mesh createMeshFromBatch(const Device &device,
+                                       std::vector<MeshData> &&meshDatas,
+                                       bool upload, bool optimize = true);
+
+/// \brief Create a Mesh from given mesh data, allocated from a MeshArena.
+/// \throws std::runtime_error if the arena does not have enough room left.
+/// \sa createMeshFromBatch(const Device &, MeshArena &, std::span<const
+/// MeshData>, bool)
+[[nodiscard]] Mesh createMesh(const Device &device, MeshArena &arena,
+                              const MeshData &meshData, bool upload = false);
+
+/// \brief Create a Mesh from a batch of MeshData, allocated from a MeshArena.
+/// All mesh data must have the arena's layout.
+/// \throws std::runtime_error if the arena does not have enough room left.
+[[nodiscard]] Mesh createMeshFromBatch(const Device &device, MeshArena &arena,
+                                       std::span<const MeshData> meshDatas,
+                                       bool upload);
+
+/// \copydoc createMeshFromBatch(const Device &, MeshArena &, std::span<const
+/// MeshData>, bool)
+[[nodiscard]] Mesh createMeshFromBatch(const Device &device, MeshArena &arena,
+                                       std::span<const MeshDataView> meshDatas,
+                                       bool upload);
+
 /// \brief Upload the contents of a single, individual mesh to the GPU device.
 ///
 /// This will upload the mesh data through a MeshView.
 void uploadMeshToDevice(const Device &device, const MeshView &meshView,
                         const MeshData &meshData);
 
+/// \brief Upload the contents of a mesh data view to the GPU device.
+///
+/// The data is copied straight from the view (e.g. a memory-mapped
+/// MeshCacheFile) into the transfer buffer.
+void uploadMeshToDevice(const Device &device, const MeshView &meshView,
+                        const MeshDataView &meshData);
+
 void uploadMeshToDevice(const Device &device, const Mesh &mesh,
                         const MeshData &meshData);
 
+/// \brief Upload a batch of meshes to the GPU device.
+///
+/// All payloads are packed into a single transfer buffer, copied in a single
+/// copy pass and submitted once.
+/// \param device GPU device
+/// \param meshViews Destination views, one for each element of \p meshDatas.
+/// \param meshDatas Source mesh data.
+void uploadMeshesToDevice(const Device &device,
+                          std::span<const MeshView> meshViews,
+                          std::span<const MeshDataView> meshDatas);
+
+/// \copydoc uploadMeshesToDevice()
+void uploadMeshesToDevice(const Device &device,
+                          std::span<const MeshView> meshViews,
+                          std::span<const MeshData> meshDatas);
+
+/// \brief Update a range of the vertices of a Mesh, e.g. for deformable or
+/// streamed geometry, without recreating it.
+///
+/// The data is staged through the device's UploadRing, and the copy is
+/// recorded in a copy pass of \p command_buffer, whose submission guards the
+/// staging memory (see CommandBuffer::submit()). When the whole vertex buffer
+/// is rewritten, it is cycled, so that the update does not wait on draws still
+/// reading from it.
+/// \param device GPU device
+/// \param command_buffer Command buffer to record the copy in, usually that of
+/// the current frame.
+///
+/// The culling bounds of the views which hold the updated vertices, and those
+/// of the Mesh, are grown to contain them: they never shrink, so that a Mesh
+/// whose vertices move back and forth keeps bounds of its whole range of
+/// motion. Recreate the Mesh to tighten them. The meshlets of the Mesh are
+/// dropped, as their bounding spheres and normal cones no longer hold.
+/// \param mesh Destination Mesh. It must have a single vertex buffer.
+/// \param firstVertex First vertex to update, relative to the Mesh.
+/// \param vertexData Vertex data, in the Mesh's layout.
+void updateMeshVertices(const Device &device, CommandBuffer &command_buffer,
+                        Mesh &mesh, Uint32 firstVertex,
+                        std::span<const char> vertexData);
+
+template <IsVertexType VertexT>
+void updateMeshVertices(const Device &device, CommandBuffer &command_buffer,
+                        Mesh &mesh, Uint32 firstVertex,
+                        std::span<const VertexT> vertices) {
+  updateMeshVertices(device, command_buffer, mesh, firstVertex,
+                     {reinterpret_cast<const char *>(vertices.data()),
+                      vertices.size_bytes()});
+}
+
+/// \brief Update a range of the indices of an indexed Mesh.
+/// \sa updateMeshVertices()
+void updateMeshIndices(const Device &device, CommandBuffer &command_buffer,
+                       const Mesh &mesh, Uint32 firstIndex,
+                       std::span<const MeshData::IndexType> indexData);
+
 inline std::vector<PbrMaterial>
 extractMaterials(std::span<const MeshData> meshDatas) {
   std::vector<PbrMaterial> out;
@@ -6,7 +6,8 @@ MeshDataView::MeshDataView(const MeshData &meshData)
     : primitiveType{meshData.primitiveType}, layout{meshData.layout},
       vertexData{meshData.vertexData().data(),
                  meshData.numVertices() * layout.vertexSize()},
-      indexData{meshData.indexData} {}
+      indexData{meshData.indexData},
+      positionDequant{meshData.positionDequant}, lods{meshData.lods} {}
 
 MeshDataView::MeshDataView(SDL_GPUPrimitiveType primitiveType,
                            const MeshLayout &layout,
@@ -18,7 +19,10 @@ MeshDataView::MeshDataView(SDL_GPUPrimitiveType primitiveType,
 MeshData MeshDataView::toOwned() const {
   std::vector<char> vtxOut{vertexData.begin(), vertexData.end()};
   std::vector<IndexType> idxOut{indexData.begin(), indexData.end()};
-  return MeshData{primitiveType, layout, std::move(vtxOut), std::move(idxOut)};
+  MeshData out{primitiveType, layout, std::move(vtxOut), std::move(idxOut)};
+  out.positionDequant = positionDequant;
+  out.lods.assign(lods.begin(), lods.end());
+  return out;
 }
 
 } // namespace candlewick
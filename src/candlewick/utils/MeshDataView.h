@@ -10,6 +10,10 @@ struct MeshDataView : MeshDataBase<MeshDataView> {
   MeshLayout layout;
   std::span<const char> vertexData;
   std::span<const IndexType> indexData;
+  /// \copydoc MeshData::positionDequant
+  Mat4f positionDequant = Mat4f::Identity();
+  /// \copydoc MeshData::lods
+  std::span<const MeshLod> lods;
 
   explicit MeshDataView(const MeshData &meshData);
 
@@ -25,6 +29,10 @@ struct MeshDataView : MeshDataBase<MeshDataView> {
                std::span<const char> vertices,
                std::span<const IndexType> indices = {});
 
+  Uint32 numVertices() const noexcept {
+    return Uint32(vertexData.size() / layout.vertexSize());
+  }
+
   MeshData toOwned() const;
 };
 
@@ -44,4 +52,13 @@ MeshDataView::MeshDataView(SDL_GPUPrimitiveType primitiveType,
     : MeshDataView(primitiveType, std::span<const V>{vertices},
                    std::span<const IndexType>{indices}) {}
 
+/// \copydoc batchIndexElementSize(std::span<const MeshData>)
+inline SDL_GPUIndexElementSize
+batchIndexElementSize(std::span<const MeshDataView> meshDatas) {
+  Uint32 maxVertices = 0;
+  for (auto &data : meshDatas)
+    maxVertices = std::max(maxVertices, data.numVertices());
+  return minimalIndexElementSize(maxVertices);
+}
+
 } // namespace candlewick
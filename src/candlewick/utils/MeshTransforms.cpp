@@ -1,8 +1,12 @@
 #include "MeshData.h"
 #include "MeshTransforms.h"
+#include "../core/CompactVertex.h"
 
 #include <SDL3/SDL_assert.h>
+#include <limits>
 #include <numeric>
+#include <queue>
+#include <unordered_map>
 
 namespace candlewick {
 
@@ -11,26 +15,677 @@ void apply3DTransformInPlace(MeshData &meshData, const Eigen::Affine3f &tr) {
   const MeshLayout &layout = meshData.layout;
 
   if (auto posAttr = layout.getAttribute(VertexAttrib::Position)) {
-    for (Uint64 i = 0; i < meshData.numVertices(); i++) {
-      Float3 &pos = meshData.getAttribute<Float3>(i, *posAttr);
-      pos = tr * pos;
+    if (isNormalizedFormat(posAttr->format)) {
+      // quantized positions: fold the transform into the dequantization
+      meshData.positionDequant = tr.matrix() * meshData.positionDequant;
+    } else {
+      for (Uint64 i = 0; i < meshData.numVertices(); i++) {
+        Float3 &pos = meshData.getAttribute<Float3>(i, *posAttr);
+        pos = tr * pos;
+      }
     }
   }
 
+  // simplification errors are distances: scale them by the largest stretch
+  if (!meshData.lods.empty()) {
+    const float stretch =
+        Eigen::JacobiSVD<Eigen::Matrix3f>(tr.linear()).singularValues()[0];
+    for (MeshLod &lod : meshData.lods)
+      lod.error *= stretch;
+  }
+
   Eigen::Matrix3f normalMatrix = tr.linear().inverse().transpose();
-  if (auto normAttr = layout.getAttribute(VertexAttrib::Normal)) {
+  auto transformDirections = [&](const SDL_GPUVertexAttribute &attr) {
+    if (attr.format == SDL_GPU_VERTEXELEMENTFORMAT_FLOAT3) {
+      for (Uint64 i = 0; i < meshData.numVertices(); i++) {
+        Float3 &dir = meshData.getAttribute<Float3>(i, attr);
+        dir.applyOnTheLeft(normalMatrix);
+      }
+      return;
+    }
+    // octahedral-encoded: decode, transform and re-encode
+    SDL_assert(attr.format == SDL_GPU_VERTEXELEMENTFORMAT_SHORT2_NORM);
     for (Uint64 i = 0; i < meshData.numVertices(); i++) {
-      Float3 &normal = meshData.getAttribute<Float3>(i, *normAttr);
-      normal.applyOnTheLeft(normalMatrix);
+      char *dst = &meshData.getAttribute<char>(i, attr);
+      Float3 dir =
+          octahedralDecode(readVertexElement(dst, attr.format).head<2>());
+      Float4 value;
+      value << octahedralEncode((normalMatrix * dir).normalized()), 0.f, 0.f;
+      writeVertexElement(dst, attr.format, value);
+    }
+  };
+
+  if (auto normAttr = layout.getAttribute(VertexAttrib::Normal))
+    transformDirections(*normAttr);
+
+  if (auto tangAttr = layout.getAttribute(VertexAttrib::Tangent))
+    transformDirections(*tangAttr);
+
+  const float scale = tr.linear().colwise().norm().maxCoeff();
+
+  // a non-uniform scaling changes the angles between normals, so it
+  // invalidates the normal cones
+  const Float3 scales = tr.linear().colwise().norm();
+  const bool uniform = scales.maxCoeff() - scales.minCoeff() <= 1e-4f * scale;
+  for (Meshlet &m : meshData.meshlets) {
+    m.center = tr * m.center;
+    m.radius *= scale;
+    if (uniform && m.coneCutoff < 1.f) {
+      m.coneAxis = (normalMatrix * m.coneAxis).normalized();
+    } else {
+      m.coneAxis.setZero();
+      m.coneCutoff = 1.f;
     }
   }
+}
 
-  if (auto tangAttr = layout.getAttribute(VertexAttrib::Tangent)) {
-    for (Uint64 i = 0; i < meshData.numVertices(); i++) {
-      Float3 &tang = meshData.getAttribute<Float3>(i, *tangAttr);
-      tang.applyOnTheLeft(normalMatrix);
+MeshData convertToLayout(const MeshData &meshData, const MeshLayout &layout) {
+  if (meshData.layout == layout)
+    return MeshData::copy(meshData);
+
+  const MeshLayout &srcLayout = meshData.layout;
+  const Uint32 srcStride = srcLayout.vertexSize();
+  const Uint32 dstStride = layout.vertexSize();
+  const Uint32 numVertices = meshData.numVertices();
+  auto srcVertex = [&](Uint32 i) {
+    return meshData.vertexData().data() + size_t(i) * srcStride;
+  };
+
+  PositionQuantization quant;
+  auto srcPos = srcLayout.getAttribute(VertexAttrib::Position);
+  auto dstPos = layout.getAttribute(VertexAttrib::Position);
+  const bool quantized = dstPos && isNormalizedFormat(dstPos->format);
+  if (srcPos && quantized) {
+    Float3 min = Float3::Constant(std::numeric_limits<float>::max());
+    Float3 max = -min;
+    for (Uint32 i = 0; i < numVertices; i++) {
+      Float3 pos = decodeVertexAttribute(srcVertex(i), *srcPos,
+                                         meshData.positionDequant)
+                       .head<3>();
+      min = min.cwiseMin(pos);
+      max = max.cwiseMax(pos);
+    }
+    quant = PositionQuantization::fromBounds(min, max);
+  }
+
+  std::vector<char> vertexData(size_t(numVertices) * dstStride);
+  for (Uint32 i = 0; i < numVertices; i++) {
+    char *dst = vertexData.data() + size_t(i) * dstStride;
+    for (const SDL_GPUVertexAttribute &attr : layout.m_attrs) {
+      const VertexAttrib loc = VertexAttrib(attr.location);
+      Float4 value;
+      if (auto srcAttr = srcLayout.getAttribute(loc)) {
+        value = decodeVertexAttribute(srcVertex(i), *srcAttr,
+                                      meshData.positionDequant);
+      } else if (loc == VertexAttrib::Color0) {
+        value = Float4::Ones();
+      } else {
+        continue;
+      }
+      encodeVertexAttribute(dst, attr, value, quant);
+    }
+  }
+
+  MeshData out{meshData.primitiveType, layout, std::move(vertexData),
+               meshData.indexData};
+  out.material = meshData.material;
+  out.lods = meshData.lods;
+  out.meshlets = meshData.meshlets;
+  if (quantized)
+    out.positionDequant = quant.dequantMatrix();
+  return out;
+}
+
+namespace {
+  /// Error quadric: sum of the squared distances to a set of planes.
+  using Quadric = Eigen::Matrix4d;
+
+  double quadricError(const Quadric &q, const Float3 &p) {
+    const Eigen::Vector4d v{p.x(), p.y(), p.z(), 1.0};
+    return std::max(v.dot(q * v), 0.0);
+  }
+
+  /// Candidate collapse of vertex \c from onto vertex \c to. It is stale if
+  /// either vertex changed since it was queued.
+  struct EdgeCollapse {
+    double cost;
+    Uint32 from, to;
+    Uint32 fromStamp, toStamp;
+
+    bool operator>(const EdgeCollapse &other) const {
+      return cost > other.cost;
+    }
+  };
+
+  Uint64 edgeKey(Uint32 a, Uint32 b) {
+    return (Uint64(std::min(a, b)) << 32) | std::max(a, b);
+  }
+} // namespace
+
+std::vector<Uint32> simplifyMeshIndices(const MeshData &meshData,
+                                        std::span<const Uint32> indices,
+                                        Uint32 targetIndexCount, float &error) {
+  SDL_assert(meshData.primitiveType == SDL_GPU_PRIMITIVETYPE_TRIANGLELIST);
+  SDL_assert(indices.size() % 3 == 0);
+  error = 0.f;
+  const Uint32 numVertices = meshData.numVertices();
+  const Uint32 numTris = Uint32(indices.size() / 3);
+  auto posAttr = meshData.layout.getAttribute(VertexAttrib::Position);
+  if (!posAttr || indices.size() <= targetIndexCount)
+    return {indices.begin(), indices.end()};
+
+  const Uint32 stride = meshData.vertexSize();
+  std::vector<Float3> positions(numVertices);
+  for (Uint32 i = 0; i < numVertices; i++) {
+    const char *vertex = meshData.vertexData().data() + size_t(i) * stride;
+    positions[i] =
+        decodeVertexAttribute(vertex, *posAttr, meshData.positionDequant)
+            .head<3>();
+  }
+
+  std::vector<Uint32> tris{indices.begin(), indices.end()};
+  std::vector<bool> triAlive(numTris, true);
+  std::vector<std::vector<Uint32>> vertexTris(numVertices);
+  std::vector<Quadric> quadrics(numVertices, Quadric::Zero());
+  std::unordered_map<Uint64, Uint32> edgeUses;
+  for (Uint32 t = 0; t < numTris; t++) {
+    const Uint32 *tri = &tris[3 * t];
+    const Float3 &p0 = positions[tri[0]];
+    Float3 n = (positions[tri[1]] - p0).cross(positions[tri[2]] - p0);
+    if (n.squaredNorm() > 0.f)
+      n.normalize();
+    Eigen::Vector4d plane;
+    plane << n.cast<double>(), -double(n.dot(p0));
+    const Quadric q = plane * plane.transpose();
+    for (Uint32 k = 0; k < 3; k++) {
+      quadrics[tri[k]] += q;
+      vertexTris[tri[k]].push_back(t);
+      edgeUses[edgeKey(tri[k], tri[(k + 1) % 3])]++;
+    }
+  }
+
+  // Moving border or seam vertices would open cracks in the surface.
+  std::vector<bool> locked(numVertices, false);
+  for (auto [key, uses] : edgeUses) {
+    if (uses == 1) {
+      locked[Uint32(key >> 32)] = true;
+      locked[Uint32(key)] = true;
+    }
+  }
+  {
+    std::unordered_map<Uint64, Uint32> firstAt;
+    for (Uint32 i = 0; i < numVertices; i++) {
+      // positions are bit-identical on seams, hash the coordinates' bits
+      Uint32 bits[3];
+      SDL_memcpy(bits, positions[i].data(), sizeof(bits));
+      const Uint64 h = (Uint64(bits[0]) * 73856093u) ^
+                       (Uint64(bits[1]) * 19349663u) ^
+                       (Uint64(bits[2]) * 83492791u);
+      auto [it, inserted] = firstAt.try_emplace(h, i);
+      if (!inserted && positions[it->second] == positions[i])
+        locked[i] = locked[it->second] = true;
+    }
+  }
+
+  std::vector<Uint32> stamp(numVertices, 0u);
+  std::vector<bool> removed(numVertices, false);
+  std::priority_queue<EdgeCollapse, std::vector<EdgeCollapse>,
+                      std::greater<EdgeCollapse>>
+      queue;
+  auto pushCollapse = [&](Uint32 from, Uint32 to) {
+    if (locked[from])
+      return;
+    const double cost =
+        quadricError(quadrics[from] + quadrics[to], positions[to]);
+    queue.push({cost, from, to, stamp[from], stamp[to]});
+  };
+  for (Uint32 t = 0; t < numTris; t++) {
+    for (Uint32 k = 0; k < 3; k++) {
+      pushCollapse(tris[3 * t + k], tris[3 * t + (k + 1) % 3]);
+      pushCollapse(tris[3 * t + (k + 1) % 3], tris[3 * t + k]);
+    }
+  }
+
+  auto triNormal = [&](const Float3 &a, const Float3 &b, const Float3 &c) {
+    return Float3{(b - a).cross(c - a)};
+  };
+
+  Uint32 liveIndices = numTris * 3;
+  double maxCost = 0.0;
+  while (liveIndices > targetIndexCount && !queue.empty()) {
+    const EdgeCollapse c = queue.top();
+    queue.pop();
+    if (removed[c.from] || removed[c.to] || stamp[c.from] != c.fromStamp ||
+        stamp[c.to] != c.toStamp)
+      continue;
+
+    // the edge must still exist, and moving its vertex must not flip any of
+    // the remaining triangles
+    bool adjacent = false, flips = false;
+    for (Uint32 t : vertexTris[c.from]) {
+      if (!triAlive[t])
+        continue;
+      const Uint32 *tri = &tris[3 * t];
+      if (tri[0] == c.to || tri[1] == c.to || tri[2] == c.to) {
+        adjacent = true;
+        continue;
+      }
+      Float3 p[3], q[3];
+      for (Uint32 k = 0; k < 3; k++) {
+        p[k] = positions[tri[k]];
+        q[k] = tri[k] == c.from ? positions[c.to] : p[k];
+      }
+      if (triNormal(p[0], p[1], p[2]).dot(triNormal(q[0], q[1], q[2])) <= 0.f)
+        flips = true;
+    }
+    if (!adjacent || flips)
+      continue;
+
+    std::vector<Uint32> &toTris = vertexTris[c.to];
+    for (Uint32 t : vertexTris[c.from]) {
+      if (!triAlive[t])
+        continue;
+      Uint32 *tri = &tris[3 * t];
+      if (tri[0] == c.to || tri[1] == c.to || tri[2] == c.to) {
+        triAlive[t] = false;
+        liveIndices -= 3;
+        continue;
+      }
+      std::replace(tri, tri + 3, c.from, c.to);
+      toTris.push_back(t);
+    }
+    std::erase_if(toTris, [&](Uint32 t) { return !triAlive[t]; });
+    vertexTris[c.from].clear();
+    removed[c.from] = true;
+    quadrics[c.to] += quadrics[c.from];
+    maxCost = std::max(maxCost, c.cost);
+
+    stamp[c.to]++;
+    for (Uint32 t : toTris) {
+      for (Uint32 k = 0; k < 3; k++) {
+        const Uint32 w = tris[3 * t + k];
+        if (w == c.to)
+          continue;
+        pushCollapse(w, c.to);
+        pushCollapse(c.to, w);
+      }
+    }
+  }
+
+  std::vector<Uint32> out;
+  out.reserve(liveIndices);
+  for (Uint32 t = 0; t < numTris; t++) {
+    if (triAlive[t])
+      out.insert(out.end(), &tris[3 * t], &tris[3 * t] + 3);
+  }
+  error = float(std::sqrt(maxCost));
+  return out;
+}
+
+void generateLodChain(MeshData &meshData, Uint32 maxLevels, float reduction,
+                      Uint32 minIndexCount) {
+  SDL_assert(meshData.lods.empty());
+  if (meshData.primitiveType != SDL_GPU_PRIMITIVETYPE_TRIANGLELIST ||
+      !meshData.isIndexed())
+    return;
+
+  std::vector<Uint32> level = meshData.indexData;
+  float error = 0.f;
+  for (Uint32 l = 0; l < maxLevels; l++) {
+    const Uint32 target = Uint32(float(level.size()) * reduction) / 3 * 3;
+    if (target < minIndexCount)
+      break;
+    float levelError;
+    std::vector<Uint32> coarser =
+        simplifyMeshIndices(meshData, level, target, levelError);
+    // locked vertices keep the mesh from being simplified further
+    if (coarser.empty() || float(coarser.size()) > 0.9f * float(level.size()))
+      break;
+    // errors of successive simplifications add up
+    error += levelError;
+    meshData.lods.push_back(
+        {meshData.numIndices(), Uint32(coarser.size()), error});
+    meshData.indexData.insert(meshData.indexData.end(), coarser.begin(),
+                              coarser.end());
+    level = std::move(coarser);
+  }
+}
+
+VertexCacheStats analyzeVertexCache(std::span<const Uint32> indices,
+                                    Uint32 numVertices, Uint32 cacheSize) {
+  // a vertex stays in the cache until cacheSize other vertices were loaded
+  std::vector<Uint32> loadedAt(numVertices, 0u);
+  std::vector<bool> referenced(numVertices, false);
+  Uint32 time = cacheSize + 1;
+  Uint32 misses = 0, numReferenced = 0;
+  for (Uint32 v : indices) {
+    if (!referenced[v]) {
+      referenced[v] = true;
+      numReferenced++;
+    }
+    if (time - loadedAt[v] > cacheSize) {
+      loadedAt[v] = time++;
+      misses++;
+    }
+  }
+  const Uint32 numTris = Uint32(indices.size() / 3);
+  return {
+      .acmr = numTris ? float(misses) / float(numTris) : 0.f,
+      .atvr = numReferenced ? float(misses) / float(numReferenced) : 0.f,
+  };
+}
+
+void optimizeVertexCache(std::span<Uint32> indices, Uint32 numVertices,
+                         Uint32 cacheSize, std::vector<Uint32> *clusterStarts) {
+  SDL_assert(indices.size() % 3 == 0);
+  const Uint32 numTris = Uint32(indices.size() / 3);
+  if (clusterStarts)
+    clusterStarts->assign(1, 0u);
+  if (numTris == 0)
+    return;
+
+  // vertex -> triangles adjacency, in compressed form
+  std::vector<Uint32> liveTris(numVertices, 0u);
+  for (Uint32 v : indices)
+    liveTris[v]++;
+  std::vector<Uint32> adjOffsets(numVertices + 1, 0u);
+  std::partial_sum(liveTris.begin(), liveTris.end(), adjOffsets.begin() + 1);
+  std::vector<Uint32> adjacency(indices.size());
+  {
+    std::vector<Uint32> fill{adjOffsets.begin(), adjOffsets.end() - 1};
+    for (Uint32 i = 0; i < indices.size(); i++)
+      adjacency[fill[indices[i]]++] = i / 3;
+  }
+
+  std::vector<Uint32> cachedAt(numVertices, 0u);
+  std::vector<bool> emitted(numTris, false);
+  std::vector<Uint32> deadEnd;
+  std::vector<Uint32> candidates;
+  std::vector<Uint32> out;
+  out.reserve(indices.size());
+  Uint32 time = cacheSize + 1;
+  Uint32 cursor = 0;
+
+  auto skipDeadEnd = [&]() -> Sint64 {
+    while (!deadEnd.empty()) {
+      const Uint32 d = deadEnd.back();
+      deadEnd.pop_back();
+      if (liveTris[d] > 0)
+        return d;
+    }
+    for (; cursor < numVertices; cursor++) {
+      if (liveTris[cursor] > 0)
+        return cursor;
+    }
+    return -1;
+  };
+
+  Sint64 fan = 0;
+  while (liveTris[fan] == 0)
+    fan++;
+  while (fan >= 0) {
+    candidates.clear();
+    for (Uint32 k = adjOffsets[fan]; k < adjOffsets[fan + 1]; k++) {
+      const Uint32 t = adjacency[k];
+      if (emitted[t])
+        continue;
+      emitted[t] = true;
+      for (Uint32 c = 0; c < 3; c++) {
+        const Uint32 v = indices[3 * t + c];
+        out.push_back(v);
+        deadEnd.push_back(v);
+        candidates.push_back(v);
+        liveTris[v]--;
+        if (time - cachedAt[v] > cacheSize)
+          cachedAt[v] = time++;
+      }
+    }
+
+    // next fanning vertex: the one which stays in the cache the longest while
+    // its remaining triangles are emitted
+    Sint64 next = -1;
+    Sint64 best = -1;
+    for (Uint32 v : candidates) {
+      if (liveTris[v] == 0)
+        continue;
+      Sint64 priority = 0;
+      if (time - cachedAt[v] + 2 * liveTris[v] <= cacheSize)
+        priority = time - cachedAt[v];
+      if (priority > best) {
+        best = priority;
+        next = v;
+      }
+    }
+    if (next < 0) {
+      // dead end: the next triangles cannot reuse the cache
+      next = skipDeadEnd();
+      if (clusterStarts && next >= 0)
+        clusterStarts->push_back(Uint32(out.size()));
+    }
+    fan = next;
+  }
+  SDL_assert(out.size() == indices.size());
+  std::copy(out.begin(), out.end(), indices.begin());
+}
+
+void optimizeOverdraw(const MeshData &meshData, std::span<Uint32> indices,
+                      std::span<const Uint32> clusterStarts) {
+  auto posAttr = meshData.layout.getAttribute(VertexAttrib::Position);
+  if (!posAttr || clusterStarts.size() < 2)
+    return;
+  const Uint32 stride = meshData.vertexSize();
+  auto position = [&](Uint32 v) -> Float3 {
+    const char *vertex = meshData.vertexData().data() + size_t(v) * stride;
+    return decodeVertexAttribute(vertex, *posAttr, meshData.positionDequant)
+        .head<3>();
+  };
+
+  struct Cluster {
+    Uint32 begin, end;
+    Float3 centroid, normal;
+    float area;
+    float sortKey;
+  };
+  std::vector<Cluster> clusters;
+  clusters.reserve(clusterStarts.size());
+  Float3 meshCentroid = Float3::Zero();
+  float meshArea = 0.f;
+  for (size_t c = 0; c < clusterStarts.size(); c++) {
+    Cluster cl{clusterStarts[c],
+               c + 1 < clusterStarts.size() ? clusterStarts[c + 1]
+                                            : Uint32(indices.size()),
+               Float3::Zero(),
+               Float3::Zero(),
+               0.f,
+               0.f};
+    for (Uint32 i = cl.begin; i < cl.end; i += 3) {
+      const Float3 p0 = position(indices[i]);
+      const Float3 p1 = position(indices[i + 1]);
+      const Float3 p2 = position(indices[i + 2]);
+      const Float3 n = (p1 - p0).cross(p2 - p0);
+      const float area = 0.5f * n.norm();
+      cl.centroid += area * (p0 + p1 + p2) / 3.f;
+      cl.normal += n;
+      cl.area += area;
     }
+    meshCentroid += cl.centroid;
+    meshArea += cl.area;
+    if (cl.area > 0.f)
+      cl.centroid /= cl.area;
+    if (cl.normal.squaredNorm() > 0.f)
+      cl.normal.normalize();
+    clusters.push_back(cl);
   }
+  if (meshArea > 0.f)
+    meshCentroid /= meshArea;
+
+  // clusters which face away from the center of the mesh are likely to occlude
+  // the others: draw them first
+  for (Cluster &cl : clusters)
+    cl.sortKey = (cl.centroid - meshCentroid).dot(cl.normal);
+  std::stable_sort(clusters.begin(), clusters.end(),
+                   [](const Cluster &a, const Cluster &b) {
+                     return a.sortKey > b.sortKey;
+                   });
+
+  std::vector<Uint32> out;
+  out.reserve(indices.size());
+  for (const Cluster &cl : clusters)
+    out.insert(out.end(), indices.begin() + cl.begin, indices.begin() + cl.end);
+  std::copy(out.begin(), out.end(), indices.begin());
+}
+
+void optimizeVertexFetch(MeshData &meshData) {
+  if (!meshData.isIndexed())
+    return;
+  const Uint32 numVertices = meshData.numVertices();
+  const Uint32 stride = meshData.vertexSize();
+  constexpr Uint32 kUnused = std::numeric_limits<Uint32>::max();
+  std::vector<Uint32> remap(numVertices, kUnused);
+  Uint32 next = 0;
+  for (Uint32 &v : meshData.indexData) {
+    if (remap[v] == kUnused)
+      remap[v] = next++;
+    v = remap[v];
+  }
+  for (Uint32 &r : remap) {
+    if (r == kUnused)
+      r = next++;
+  }
+
+  std::span<const char> src = meshData.vertexData();
+  std::vector<char> vertexData(src.size());
+  for (Uint32 i = 0; i < numVertices; i++)
+    SDL_memcpy(vertexData.data() + size_t(remap[i]) * stride,
+               src.data() + size_t(i) * stride, stride);
+
+  MeshData out{meshData.primitiveType, meshData.layout, std::move(vertexData),
+               std::move(meshData.indexData)};
+  out.material = meshData.material;
+  out.positionDequant = meshData.positionDequant;
+  out.lods = std::move(meshData.lods);
+  out.meshlets = std::move(meshData.meshlets);
+  meshData = std::move(out);
+}
+
+void optimizeMesh(MeshData &meshData, MeshOptimizationStats *stats) {
+  const Uint32 numVertices = meshData.numVertices();
+  std::span<Uint32> base{meshData.indexData.data(), meshData.baseIndexCount()};
+  if (meshData.primitiveType != SDL_GPU_PRIMITIVETYPE_TRIANGLELIST ||
+      !meshData.isIndexed())
+    return;
+  if (stats)
+    stats->before = analyzeVertexCache(base, numVertices);
+
+  // reordering the triangles invalidates the meshlets
+  meshData.meshlets.clear();
+  std::vector<Uint32> clusterStarts;
+  auto optimizeRange = [&](std::span<Uint32> indices) {
+    optimizeVertexCache(indices, numVertices, 16, &clusterStarts);
+    optimizeOverdraw(meshData, indices, clusterStarts);
+  };
+  optimizeRange(base);
+  for (const MeshLod &lod : meshData.lods) {
+    optimizeRange(
+        {meshData.indexData.data() + lod.indexOffset, lod.indexCount});
+  }
+  optimizeVertexFetch(meshData);
+  if (stats)
+    stats->after = analyzeVertexCache(
+        {meshData.indexData.data(), meshData.baseIndexCount()}, numVertices);
+}
+
+void buildMeshlets(MeshData &meshData, Uint32 maxVertices,
+                   Uint32 maxTriangles) {
+  SDL_assert(maxVertices >= 3 && maxTriangles > 0);
+  meshData.meshlets.clear();
+  auto posAttr = meshData.layout.getAttribute(VertexAttrib::Position);
+  if (meshData.primitiveType != SDL_GPU_PRIMITIVETYPE_TRIANGLELIST ||
+      !meshData.isIndexed() || !posAttr)
+    return;
+
+  const Uint32 numVertices = meshData.numVertices();
+  const Uint32 stride = meshData.vertexSize();
+  std::vector<Float3> positions(numVertices);
+  for (Uint32 i = 0; i < numVertices; i++) {
+    const char *vertex = meshData.vertexData().data() + size_t(i) * stride;
+    positions[i] =
+        decodeVertexAttribute(vertex, *posAttr, meshData.positionDequant)
+            .head<3>();
+  }
+
+  const std::span<const Uint32> indices{meshData.indexData.data(),
+                                        meshData.baseIndexCount()};
+  constexpr Uint32 kNone = std::numeric_limits<Uint32>::max();
+  // last meshlet each vertex was added to
+  std::vector<Uint32> vertexMeshlet(numVertices, kNone);
+  std::vector<Uint32> vertices;
+  vertices.reserve(maxVertices);
+
+  auto emitMeshlet = [&](Uint32 begin, Uint32 end) {
+    Meshlet m{begin, end - begin, Float3::Zero(), 0.f, Float3::Zero(), 1.f};
+    Eigen::AlignedBox3f box;
+    for (Uint32 v : vertices)
+      box.extend(positions[v]);
+    m.center = box.center();
+    for (Uint32 v : vertices)
+      m.radius = std::max(m.radius, (positions[v] - m.center).norm());
+
+    // the cone axis is the average of the triangle normals, and its angle
+    // the widest deviation from it
+    std::vector<Float3> normals;
+    normals.reserve((end - begin) / 3);
+    Float3 axis = Float3::Zero();
+    for (Uint32 i = begin; i < end; i += 3) {
+      const Float3 &p0 = positions[indices[i]];
+      Float3 n = (positions[indices[i + 1]] - p0)
+                     .cross(positions[indices[i + 2]] - p0);
+      const float area = n.norm();
+      if (area <= 0.f)
+        continue;
+      n /= area;
+      normals.push_back(n);
+      axis += n;
+    }
+    const float axisNorm = axis.norm();
+    if (axisNorm > 0.f) {
+      axis /= axisNorm;
+      float minDot = 1.f;
+      for (const Float3 &n : normals)
+        minDot = std::min(minDot, n.dot(axis));
+      // past ~85 degrees, the cone would hardly ever cull the meshlet
+      if (minDot > 0.1f) {
+        m.coneAxis = axis;
+        m.coneCutoff = std::sqrt(1.f - minDot * minDot);
+      }
+    }
+    meshData.meshlets.push_back(m);
+  };
+
+  Uint32 begin = 0;
+  for (Uint32 i = 0; i < Uint32(indices.size()); i += 3) {
+    const Uint32 current = Uint32(meshData.meshlets.size());
+    const Uint32 a = indices[i], b = indices[i + 1], c = indices[i + 2];
+    const Uint32 newVertices = Uint32(vertexMeshlet[a] != current) +
+                               Uint32(vertexMeshlet[b] != current && b != a) +
+                               Uint32(vertexMeshlet[c] != current && c != a &&
+                                      c != b);
+    if (vertices.size() + newVertices > maxVertices ||
+        (i - begin) / 3 >= maxTriangles) {
+      emitMeshlet(begin, i);
+      begin = i;
+      vertices.clear();
+    }
+    const Uint32 id = Uint32(meshData.meshlets.size());
+    for (Uint32 v : {a, b, c}) {
+      if (vertexMeshlet[v] != id) {
+        vertexMeshlet[v] = id;
+        vertices.push_back(v);
+      }
+    }
+  }
+  if (begin < indices.size())
+    emitMeshlet(begin, Uint32(indices.size()));
 }
 
 void triangleStripGenerateIndices(Uint32 vertexCount,
@@ -87,7 +742,10 @@ MeshData mergeMeshes(std::span<const MeshData> meshes) {
   for (const MeshData &m : meshes) {
     assert(m.primitiveType == primitiveType);
     assert(m.layout == layout);
+    assert(m.positionDequant == meshes[0].positionDequant);
+    assert(m.lods.empty());
   }
+  std::vector<Meshlet> meshlets;
   auto [indexCount, vertexCount] = detail::mergeCalcIndexVertexCount(meshes);
   std::vector<char> vertexData;
   vertexData.resize(vertexCount * layout.vertexSize());
@@ -111,6 +769,10 @@ MeshData mergeMeshes(std::span<const MeshData> meshes) {
 
       for (Uint32 &index : dst)
         index += vtxOffset;
+      for (Meshlet m : mesh.meshlets) {
+        m.indexOffset += indexOffset - mesh.numIndices();
+        meshlets.push_back(m);
+      }
     } else if (!indexData.empty()) {
       std::iota(indexData.begin() + indexOffset,
                 indexData.begin() + indexOffset + Uint32(mesh.numIndices()),
@@ -124,8 +786,11 @@ MeshData mergeMeshes(std::span<const MeshData> meshes) {
     vtxOffset += mesh.numVertices();
   }
 
-  return MeshData{primitiveType, meshes[0].layout, std::move(vertexData),
-                  std::move(indexData)};
+  MeshData out{primitiveType, meshes[0].layout, std::move(vertexData),
+               std::move(indexData)};
+  out.positionDequant = meshes[0].positionDequant;
+  out.meshlets = std::move(meshlets);
+  return out;
 }
 
 MeshData mergeMeshes(std::vector<MeshData> &&meshes) {
@@ -4,13 +4,121 @@
 #include <Eigen/Geometry>
 #include <SDL3/SDL_stdinc.h>
 #include <span>
+#include <vector>
 
 namespace candlewick {
 
 /// \brief Apply an \c Eigen::Affine3f 3D transform to a mesh in-place,
 /// transforming its vertices.
+///
+/// For quantized positions, the transform is folded into
+/// MeshData::positionDequant instead. The errors of the levels of detail are
+/// scaled by the largest stretch of the transform.
 void apply3DTransformInPlace(MeshData &meshData, const Eigen::Affine3f &tr);
 
+/// \brief Convert mesh data to another vertex layout, e.g. a compact layout
+/// such as CompactVertex.
+///
+/// Attributes are matched by location, and attributes missing from the source
+/// are zeroed (colors are set to white). Positions are quantized to the
+/// bounding box of the mesh if the target layout calls for it.
+MeshData convertToLayout(const MeshData &meshData, const MeshLayout &layout);
+
+/// \brief Simplify an indexed triangle mesh using quadric error metrics, by
+/// collapsing edges onto one of their vertices.
+///
+/// The vertices are left untouched: the output indexes into the vertices of
+/// \p meshData, so that the simplified mesh can be drawn from the same vertex
+/// buffer. Vertices on the mesh borders, and vertices sharing their position
+/// with another (e.g. on UV or normal seams), are never moved.
+/// \param meshData Source mesh, with triangle list topology.
+/// \param indices Triangles to simplify, e.g. a previous level of detail.
+/// \param targetIndexCount Number of indices to stop at. The result may have
+/// more indices, if no more edges can be collapsed.
+/// \param[out] error Approximate distance between the input and the simplified
+/// surfaces, in the units of the dequantized positions.
+std::vector<Uint32> simplifyMeshIndices(const MeshData &meshData,
+                                        std::span<const Uint32> indices,
+                                        Uint32 targetIndexCount, float &error);
+
+/// \brief Generate a chain of coarser levels of detail for an indexed triangle
+/// mesh, stored in MeshData::lods.
+///
+/// Each level is simplified from the previous one by simplifyMeshIndices().
+/// The chain stops early when a level would have less than \p minIndexCount
+/// indices, or when the mesh cannot be simplified further.
+/// \param maxLevels Maximum number of levels, besides the full-detail mesh.
+/// \param reduction Ratio of index counts between successive levels.
+/// \warning Meshes with other topologies are left as-is.
+void generateLodChain(MeshData &meshData, Uint32 maxLevels = 3,
+                      float reduction = 0.5f, Uint32 minIndexCount = 3 * 64);
+
+/// \brief Post-transform vertex cache statistics of a triangle list, for a
+/// FIFO cache.
+struct VertexCacheStats {
+  /// Average cache miss ratio: vertex shader invocations per triangle. At best
+  /// 0.5 for a regular mesh, at worst 3.
+  float acmr;
+  /// Average transformed vertex ratio: vertex shader invocations per
+  /// referenced vertex. At best 1.
+  float atvr;
+};
+
+/// \brief Vertex cache statistics of the full-detail mesh, before and after
+/// optimizeMesh().
+struct MeshOptimizationStats {
+  VertexCacheStats before;
+  VertexCacheStats after;
+};
+
+/// \brief Simulate a FIFO post-transform vertex cache of \p cacheSize entries
+/// over a triangle list.
+VertexCacheStats analyzeVertexCache(std::span<const Uint32> indices,
+                                    Uint32 numVertices, Uint32 cacheSize = 16);
+
+/// \brief Reorder the triangles of a triangle list for the post-transform
+/// vertex cache, using Tipsify (Sander et al., 2007).
+/// \param[out] clusterStarts If not null, receives the offsets (in indices)
+/// of the clusters of triangles which start after a cache flush, for
+/// optimizeOverdraw().
+void optimizeVertexCache(std::span<Uint32> indices, Uint32 numVertices,
+                         Uint32 cacheSize = 16,
+                         std::vector<Uint32> *clusterStarts = nullptr);
+
+/// \brief Reorder clusters of triangles so that outward-facing ones are drawn
+/// first, to reduce overdraw.
+///
+/// The order of triangles within each cluster is kept, so that this preserves
+/// most of the vertex cache efficiency of optimizeVertexCache().
+/// \param meshData Mesh the indices refer to, for its vertex positions.
+/// \param clusterStarts Cluster offsets from optimizeVertexCache().
+void optimizeOverdraw(const MeshData &meshData, std::span<Uint32> indices,
+                      std::span<const Uint32> clusterStarts);
+
+/// \brief Reorder the vertices of an indexed mesh in the order they are first
+/// referenced by its indices (including those of its levels of detail), to
+/// make vertex fetches more coherent. Unreferenced vertices are moved last.
+void optimizeVertexFetch(MeshData &meshData);
+
+/// \brief Run the vertex cache, overdraw and vertex fetch optimizations on an
+/// indexed triangle mesh. Each level of detail is reordered on its own, and
+/// the meshlets are cleared.
+/// \param[out] stats If not null, receives the vertex cache statistics of the
+/// full-detail mesh, which are only simulated when requested.
+/// \warning Meshes with other topologies are left as-is, as is \p stats.
+void optimizeMesh(MeshData &meshData, MeshOptimizationStats *stats = nullptr);
+
+/// \brief Partition the full-detail triangles of an indexed triangle mesh into
+/// meshlets, stored in MeshData::meshlets, each with at most \p maxVertices
+/// unique vertices and \p maxTriangles triangles.
+///
+/// Meshlets are runs of consecutive triangles, and the indices are left as-is:
+/// run this after optimizeMesh(), whose triangle order keeps the meshlets
+/// compact.
+/// \warning Meshes with other topologies are left without meshlets.
+void buildMeshlets(MeshData &meshData, Uint32 maxVertices = 64,
+                   Uint32 maxTriangles = 124);
+
 void triangleStripGenerateIndices(Uint32 vertexCount,
                                   std::vector<Uint32> &indices);
 
@@ -27,6 +135,7 @@ namespace detail {
 } // namespace detail
 
 /// \brief Merge meshes down to a single mesh with consistent indexing.
+/// \warning The meshes must not have levels of detail yet.
 MeshData mergeMeshes(std::span<const MeshData> meshes);
 
 /// \copybrief mergeMeshes().
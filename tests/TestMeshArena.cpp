@@ -0,0 +1,111 @@
+#include "candlewick/core/MeshArena.h"
+#include <gtest/gtest.h>
+#include <vector>
+
+using namespace candlewick;
+
+GTEST_TEST(TestFreeListAllocator, first_fit) {
+  FreeListAllocator alloc{100};
+  EXPECT_EQ(alloc.capacity(), 100u);
+  EXPECT_EQ(alloc.freeCount(), 100u);
+
+  EXPECT_EQ(alloc.allocate(10), 0u);
+  EXPECT_EQ(alloc.allocate(20), 10u);
+  EXPECT_EQ(alloc.allocate(30), 30u);
+  EXPECT_EQ(alloc.freeCount(), 40u);
+  EXPECT_EQ(alloc.numFreeBlocks(), 1u);
+
+  // the first free block large enough is used
+  alloc.free(10, 20);
+  EXPECT_EQ(alloc.numFreeBlocks(), 2u);
+  EXPECT_EQ(alloc.allocate(25), 60u);
+  EXPECT_EQ(alloc.allocate(5), 10u);
+  EXPECT_EQ(alloc.allocate(15), 15u);
+  EXPECT_EQ(alloc.freeCount(), 15u);
+  EXPECT_EQ(alloc.numFreeBlocks(), 1u);
+}
+
+GTEST_TEST(TestFreeListAllocator, exhaustion) {
+  FreeListAllocator alloc{64};
+  EXPECT_EQ(alloc.allocate(65), std::nullopt);
+  EXPECT_EQ(alloc.allocate(64), 0u);
+  EXPECT_EQ(alloc.allocate(1), std::nullopt);
+  // empty allocations always succeed
+  EXPECT_EQ(alloc.allocate(0), 0u);
+
+  // enough free elements, but not contiguous
+  alloc.free(0, 16);
+  alloc.free(32, 16);
+  EXPECT_EQ(alloc.freeCount(), 32u);
+  EXPECT_EQ(alloc.allocate(32), std::nullopt);
+  EXPECT_EQ(alloc.allocate(16), 0u);
+
+  FreeListAllocator empty{0};
+  EXPECT_EQ(empty.numFreeBlocks(), 0u);
+  EXPECT_EQ(empty.allocate(1), std::nullopt);
+}
+
+GTEST_TEST(TestFreeListAllocator, coalesce) {
+  FreeListAllocator alloc{40};
+  const Uint32 a = *alloc.allocate(10);
+  const Uint32 b = *alloc.allocate(10);
+  const Uint32 c = *alloc.allocate(10);
+  const Uint32 d = *alloc.allocate(10);
+  EXPECT_EQ(alloc.numFreeBlocks(), 0u);
+
+  alloc.free(a, 10);
+  alloc.free(c, 10);
+  EXPECT_EQ(alloc.numFreeBlocks(), 2u);
+  // with the preceding and following blocks
+  alloc.free(b, 10);
+  EXPECT_EQ(alloc.numFreeBlocks(), 1u);
+  EXPECT_EQ(alloc.allocate(30), 0u);
+  alloc.free(0, 30);
+  // with the preceding block only
+  alloc.free(d, 10);
+  EXPECT_EQ(alloc.numFreeBlocks(), 1u);
+  EXPECT_EQ(alloc.freeCount(), 40u);
+  EXPECT_EQ(alloc.allocate(40), 0u);
+}
+
+GTEST_TEST(TestFreeListAllocator, random_allocations) {
+  // allocated blocks never overlap, and freeing all of them restores a
+  // single free block
+  FreeListAllocator alloc{1000};
+  std::vector<std::pair<Uint32, Uint32>> blocks;
+  std::vector<bool> used(1000, false);
+  Uint32 seed = 12345;
+  auto next = [&seed] {
+    seed = seed * 1664525u + 1013904223u;
+    return seed >> 8;
+  };
+  for (int i = 0; i < 2000; i++) {
+    if (blocks.empty() || next() % 3 != 0) {
+      const Uint32 count = 1 + next() % 50;
+      auto offset = alloc.allocate(count);
+      if (!offset)
+        continue;
+      for (Uint32 j = *offset; j < *offset + count; j++) {
+        ASSERT_FALSE(used[j]);
+        used[j] = true;
+      }
+      blocks.emplace_back(*offset, count);
+    } else {
+      const size_t k = next() % blocks.size();
+      auto [offset, count] = blocks[k];
+      for (Uint32 j = offset; j < offset + count; j++)
+        used[j] = false;
+      alloc.free(offset, count);
+      blocks.erase(blocks.begin() + std::ptrdiff_t(k));
+    }
+  }
+  for (auto [offset, count] : blocks)
+    alloc.free(offset, count);
+  EXPECT_EQ(alloc.freeCount(), 1000u);
+  EXPECT_EQ(alloc.numFreeBlocks(), 1u);
+}
+
+int main(int argc, char **argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
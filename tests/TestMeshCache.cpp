@@ -0,0 +1,266 @@
+#include "candlewick/core/CompactVertex.h"
+#include "candlewick/core/DefaultVertex.h"
+#include "candlewick/core/Mesh.h"
+#include "candlewick/utils/LoadMesh.h"
+#include "candlewick/utils/MeshCache.h"
+#include "candlewick/utils/MeshCacheFile.h"
+#include "candlewick/utils/MeshData.h"
+#include <gtest/gtest.h>
+#include <fstream>
+
+using namespace candlewick;
+
+static MeshCacheKey makeKey(const std::string &path) {
+  return MeshCacheKey{
+      .device = nullptr,
+      .path = path,
+      .mtime = {},
+      .scale = Float3::Ones(),
+      .layout = meshLayoutFor<DefaultVertex>(),
+      .positionStream = false,
+      .lodLevels = 0,
+  };
+}
+
+GTEST_TEST(TestMeshCache, key_equality) {
+  const MeshCacheKey key = makeKey("/meshes/link.stl");
+  const MeshCacheKeyHash hash;
+  MeshCacheKey same = makeKey("/meshes/link.stl");
+  EXPECT_TRUE(key == same);
+  EXPECT_EQ(hash(key), hash(same));
+
+  MeshCacheKey other = key;
+  other.path = "/meshes/base.stl";
+  EXPECT_FALSE(key == other);
+  other = key;
+  other.scale = {1.f, 2.f, 1.f};
+  EXPECT_FALSE(key == other);
+  other = key;
+  other.mtime += std::chrono::seconds(1);
+  EXPECT_FALSE(key == other);
+  other = key;
+  other.layout = meshLayoutFor<CompactVertex>();
+  EXPECT_FALSE(key == other);
+  other = key;
+  other.positionStream = true;
+  EXPECT_FALSE(key == other);
+  other = key;
+  other.lodLevels = 3;
+  EXPECT_FALSE(key == other);
+}
+
+GTEST_TEST(TestMeshCache, find_insert) {
+  MeshCache cache;
+  const MeshCacheKey key = makeKey("/meshes/link.stl");
+  EXPECT_EQ(cache.find(key), nullptr);
+
+  MeshCache::AssetPtr asset = cache.insert(key, Mesh{NoInit}, {PbrMaterial{}});
+  ASSERT_NE(asset, nullptr);
+  EXPECT_EQ(asset->materials.size(), 1u);
+  EXPECT_EQ(cache.find(key), asset);
+  EXPECT_EQ(cache.find(makeKey("/meshes/base.stl")), nullptr);
+
+  // a live asset is kept, and the inserted mesh dropped
+  MeshCache::AssetPtr again = cache.insert(key, Mesh{NoInit}, {});
+  EXPECT_EQ(again, asset);
+  EXPECT_EQ(again->materials.size(), 1u);
+  EXPECT_EQ(cache.size(), 1u);
+}
+
+GTEST_TEST(TestMeshCache, weak_expiry) {
+  MeshCache cache;
+  const MeshCacheKey key = makeKey("/meshes/link.stl");
+  {
+    MeshCache::AssetPtr asset = cache.insert(key, Mesh{NoInit}, {});
+    Mesh shared = shareMesh(asset);
+    EXPECT_TRUE(shared.isShared());
+    asset.reset();
+    // the shared Mesh keeps the asset alive
+    EXPECT_NE(cache.find(key), nullptr);
+  }
+  // the cache only holds a weak reference
+  EXPECT_EQ(cache.find(key), nullptr);
+  EXPECT_EQ(cache.size(), 1u);
+  cache.prune();
+  EXPECT_EQ(cache.size(), 0u);
+
+  // an expired entry is replaced on insert
+  MeshCache::AssetPtr asset = cache.insert(key, Mesh{NoInit}, {});
+  EXPECT_EQ(cache.find(key), asset);
+}
+
+namespace fs = std::filesystem;
+
+/// Source file, cache file and meshes of a mesh cache file test.
+struct CacheFileFixture {
+  fs::path dir;
+  fs::path source;
+  fs::path cacheFile;
+  std::vector<MeshData> meshes;
+
+  explicit CacheFileFixture(const char *name) {
+    dir = fs::temp_directory_path() / "candlewick-test-mesh-cache" / name;
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    source = dir / "mesh.obj";
+    std::ofstream{source} << "o mesh\n";
+    cacheFile = dir / "mesh.cwmesh";
+
+    std::vector<DefaultVertex> vertices(4);
+    for (Uint32 i = 0; i < 4; i++)
+      vertices[i].pos = Float3{float(i), float(i % 2), 0.f};
+    MeshData &md = meshes.emplace_back(SDL_GPU_PRIMITIVETYPE_TRIANGLELIST,
+                                       std::move(vertices),
+                                       std::vector<Uint32>{0, 1, 2, 2, 1, 3});
+    md.material.baseColor = {0.5f, 0.25f, 1.f, 1.f};
+    md.material.roughness = 0.3f;
+  }
+  ~CacheFileFixture() { fs::remove_all(dir); }
+
+  MeshCacheFile read() const {
+    return MeshCacheFile{cacheFile, source, meshLayoutFor<DefaultVertex>()};
+  }
+
+  std::vector<char> bytes() const {
+    std::ifstream in{cacheFile, std::ios::binary};
+    return {std::istreambuf_iterator<char>(in), {}};
+  }
+
+  void overwrite(const std::vector<char> &data) const {
+    std::ofstream out{cacheFile, std::ios::binary | std::ios::trunc};
+    out.write(data.data(), std::streamsize(data.size()));
+  }
+};
+
+GTEST_TEST(TestMeshCacheFile, round_trip) {
+  CacheFileFixture f{"round_trip"};
+  ASSERT_TRUE(writeMeshCacheFile(f.cacheFile, f.source, f.meshes));
+  MeshCacheFile cached = f.read();
+  ASSERT_TRUE(cached);
+  ASSERT_EQ(cached.meshes().size(), 1u);
+
+  std::vector<MeshData> loaded;
+  cached.toOwned(loaded);
+  const MeshData &expected = f.meshes[0];
+  const MeshData &md = loaded[0];
+  EXPECT_EQ(md.primitiveType, expected.primitiveType);
+  EXPECT_TRUE(md.layout == expected.layout);
+  EXPECT_EQ(md.numVertices(), expected.numVertices());
+  EXPECT_TRUE(std::ranges::equal(md.vertexData(), expected.vertexData()));
+  EXPECT_EQ(md.indexData, expected.indexData);
+  EXPECT_TRUE(md.material.baseColor == expected.material.baseColor);
+  EXPECT_EQ(md.material.roughness, expected.material.roughness);
+
+  // another layout, or a modified source, misses the cache
+  EXPECT_FALSE((MeshCacheFile{f.cacheFile, f.source,
+                              meshLayoutFor<PosNormalVertex>()}));
+  std::ofstream{f.source, std::ios::app} << "v 0 0 0\n";
+  EXPECT_FALSE(f.read());
+}
+
+GTEST_TEST(TestMeshCacheFile, processed_meshes) {
+  CacheFileFixture f{"processed_meshes"};
+  MeshData &md = f.meshes[0];
+  md.indexData.insert(md.indexData.end(), {0, 1, 3});
+  md.lods.push_back({.indexOffset = 6, .indexCount = 3, .error = 0.5f});
+  const MeshProcessOptions options{.lodLevels = 1, .optimize = true};
+  ASSERT_TRUE(writeMeshCacheFile(f.cacheFile, f.source, f.meshes, options));
+
+  const MeshLayout layout = meshLayoutFor<DefaultVertex>();
+  MeshCacheFile cached{f.cacheFile, f.source, layout, options};
+  ASSERT_TRUE(cached);
+  std::vector<MeshData> loaded;
+  cached.toOwned(loaded);
+  ASSERT_EQ(loaded[0].lods.size(), 1u);
+  EXPECT_EQ(loaded[0].lods[0].indexOffset, 6u);
+  EXPECT_EQ(loaded[0].lods[0].indexCount, 3u);
+  EXPECT_EQ(loaded[0].lods[0].error, 0.5f);
+  EXPECT_EQ(loaded[0].baseIndexCount(), 6u);
+
+  // meshes processed otherwise miss the cache
+  EXPECT_FALSE(f.read());
+  EXPECT_FALSE((MeshCacheFile{f.cacheFile, f.source, layout,
+                              {.lodLevels = 2, .optimize = true}}));
+  EXPECT_NE(meshCacheFilePath(f.source, layout, options),
+            meshCacheFilePath(f.source, layout));
+
+  // levels of detail out of the indices
+  md.lods[0].indexCount = 6;
+  ASSERT_TRUE(writeMeshCacheFile(f.cacheFile, f.source, f.meshes, options));
+  EXPECT_FALSE((MeshCacheFile{f.cacheFile, f.source, layout, options}));
+}
+
+GTEST_TEST(TestMeshCacheFile, truncated) {
+  CacheFileFixture f{"truncated"};
+  ASSERT_TRUE(writeMeshCacheFile(f.cacheFile, f.source, f.meshes));
+  const std::vector<char> data = f.bytes();
+  // the last section is padded by at most 15 bytes
+  for (size_t size : {size_t(0), size_t(16), data.size() / 2,
+                      data.size() - 16}) {
+    f.overwrite({data.begin(), data.begin() + std::ptrdiff_t(size)});
+    EXPECT_FALSE(f.read()) << "file truncated to " << size << " bytes";
+  }
+}
+
+GTEST_TEST(TestMeshCacheFile, corrupted) {
+  CacheFileFixture f{"corrupted"};
+  ASSERT_TRUE(writeMeshCacheFile(f.cacheFile, f.source, f.meshes));
+  const std::vector<char> data = f.bytes();
+
+  // huge mesh count, in the header after the magic, version, byte order mark
+  // and source stamp
+  std::vector<char> corrupt = data;
+  const Uint32 numMeshes = 0xffffffff;
+  SDL_memcpy(corrupt.data() + 32, &numMeshes, sizeof(numMeshes));
+  f.overwrite(corrupt);
+  EXPECT_FALSE(f.read());
+
+  // any flipped byte either misses the cache or reads a valid mesh
+  for (size_t i = 0; i < data.size(); i++) {
+    corrupt = data;
+    corrupt[i] = char(~corrupt[i]);
+    f.overwrite(corrupt);
+    MeshCacheFile cached = f.read();
+    if (!cached)
+      continue;
+    for (const MeshDataView &view : cached.meshes())
+      for (Uint32 index : view.indexData)
+        EXPECT_LT(index, view.numVertices()) << "flipped byte " << i;
+  }
+}
+
+GTEST_TEST(TestMeshCacheFile, out_of_range_index) {
+  CacheFileFixture f{"out_of_range_index"};
+  f.meshes[0].indexData.back() = f.meshes[0].numVertices();
+  ASSERT_TRUE(writeMeshCacheFile(f.cacheFile, f.source, f.meshes));
+  EXPECT_FALSE(f.read());
+}
+
+GTEST_TEST(TestMeshCacheFile, load_views) {
+  CacheFileFixture f{"load_views"};
+  const fs::path previousDir = meshCacheDirectory();
+  setMeshCacheDirectory(f.dir);
+  const auto layout = meshLayoutFor<DefaultVertex>();
+  const fs::path source = fs::canonical(f.source);
+  ASSERT_TRUE(
+      writeMeshCacheFile(meshCacheFilePath(source, layout), source, f.meshes));
+
+  // a cache hit hands out the mapped file, without copying the meshes
+  std::vector<MeshData> meshData;
+  std::shared_ptr<const MeshCacheFile> cacheFile;
+  EXPECT_EQ(loadSceneMeshes(f.source.string().c_str(), meshData, cacheFile,
+                            layout),
+            mesh_load_retc::OK);
+  setMeshCacheDirectory(previousDir);
+  ASSERT_TRUE(cacheFile);
+  EXPECT_TRUE(meshData.empty());
+  ASSERT_EQ(cacheFile->meshes().size(), 1u);
+  const MeshDataView &view = cacheFile->meshes()[0];
+  EXPECT_TRUE(std::ranges::equal(view.vertexData, f.meshes[0].vertexData()));
+  EXPECT_TRUE(std::ranges::equal(view.indexData, f.meshes[0].indexData));
+}
+
+int main(int argc, char **argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
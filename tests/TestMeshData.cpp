@@ -1,6 +1,10 @@
 #include "candlewick/core/DefaultVertex.h"
+#include "candlewick/core/CompactVertex.h"
+#include "candlewick/core/Mesh.h"
 #include "candlewick/utils/MeshData.h"
+#include "candlewick/utils/MeshTransforms.h"
 #include <gtest/gtest.h>
+#include <random>
 
 using namespace candlewick;
 
@@ -94,6 +98,322 @@ GTEST_TEST(TestErasedBlob, custom_vertex) {
   }
 }
 
+GTEST_TEST(TestMeshData, index_element_size) {
+  auto makeData = [](Uint32 numVertices) {
+    return MeshData{SDL_GPU_PRIMITIVETYPE_TRIANGLELIST,
+                    std::vector<DefaultVertex>(numVertices)};
+  };
+  EXPECT_EQ(makeData(3).indexElementSize(), SDL_GPU_INDEXELEMENTSIZE_16BIT);
+  EXPECT_EQ(makeData(0xFFFF).indexElementSize(),
+            SDL_GPU_INDEXELEMENTSIZE_16BIT);
+  EXPECT_EQ(makeData(0x10000).indexElementSize(),
+            SDL_GPU_INDEXELEMENTSIZE_32BIT);
+
+  // indices of each view are relative to its first vertex
+  std::vector<MeshData> batch;
+  batch.push_back(makeData(0xFFFF));
+  batch.push_back(makeData(0xFFFF));
+  EXPECT_EQ(batchIndexElementSize(batch), SDL_GPU_INDEXELEMENTSIZE_16BIT);
+  batch.push_back(makeData(0x10000));
+  EXPECT_EQ(batchIndexElementSize(batch), SDL_GPU_INDEXELEMENTSIZE_32BIT);
+}
+
+GTEST_TEST(TestMeshData, compact_vertex) {
+  EXPECT_EQ(meshLayoutFor<CompactVertex>().vertexSize(), 16u);
+  EXPECT_TRUE(hasOctahedralNormals(meshLayoutFor<CompactVertex>()));
+  EXPECT_FALSE(hasOctahedralNormals(meshLayoutFor<DefaultVertex>()));
+
+  for (int i = 0; i < 100; i++) {
+    Float3 n = Float3::Random().normalized();
+    EXPECT_TRUE(octahedralDecode(octahedralEncode(n)).isApprox(n, 1e-5f));
+  }
+
+  std::vector<DefaultVertex> vertexData;
+  for (int i = 0; i < 10; i++) {
+    vertexData.push_back({10.f * Float3::Random(),
+                          Float3::Random().normalized(), Float4::Ones()});
+  }
+  MeshData data(SDL_GPU_PRIMITIVETYPE_TRIANGLELIST, vertexData);
+  MeshData compact = convertToLayout(data, meshLayoutFor<CompactVertex>());
+  EXPECT_EQ(compact.vertexBytes(), 16u * vertexData.size());
+
+  auto posAttr = compact.layout.getAttribute(VertexAttrib::Position);
+  auto normAttr = compact.layout.getAttribute(VertexAttrib::Normal);
+  const char *vertices = compact.vertexData().data();
+  for (size_t i = 0; i < vertexData.size(); i++) {
+    const char *vertex = vertices + 16 * i;
+    Float3 pos =
+        decodeVertexAttribute(vertex, *posAttr, compact.positionDequant)
+            .head<3>();
+    Float3 normal = decodeVertexAttribute(vertex, *normAttr).head<3>();
+    EXPECT_LT((pos - vertexData[i].pos).norm(), 1e-3f);
+    EXPECT_LT((normal - vertexData[i].normal).norm(), 1e-3f);
+  }
+}
+
+GTEST_TEST(TestMeshData, lod_chain) {
+  // height field over a regular grid
+  const Uint32 n = 48;
+  auto makeGrid = [n](float amplitude) {
+    std::vector<DefaultVertex> vertexData;
+    for (Uint32 j = 0; j < n; j++) {
+      for (Uint32 i = 0; i < n; i++) {
+        const float x = float(i) / float(n - 1), y = float(j) / float(n - 1);
+        const float z = amplitude * std::sin(6.f * x) * std::cos(4.f * y);
+        vertexData.push_back({{x, y, z}, Float3::UnitZ(), Float4::Ones()});
+      }
+    }
+    std::vector<Uint32> indexData;
+    for (Uint32 j = 0; j + 1 < n; j++) {
+      for (Uint32 i = 0; i + 1 < n; i++) {
+        const Uint32 v = j * n + i;
+        indexData.insert(indexData.end(), {v, v + 1, v + n + 1});
+        indexData.insert(indexData.end(), {v, v + n + 1, v + n});
+      }
+    }
+    return MeshData{SDL_GPU_PRIMITIVETYPE_TRIANGLELIST, vertexData,
+                    indexData};
+  };
+
+  MeshData flat = makeGrid(0.f);
+  const Uint32 baseCount = flat.numIndices();
+  generateLodChain(flat, 3, 0.5f);
+  ASSERT_FALSE(flat.lods.empty());
+  EXPECT_EQ(flat.baseIndexCount(), baseCount);
+  EXPECT_NEAR(flat.lods[0].error, 0.f, 1e-4f);
+
+  MeshData bumpy = makeGrid(0.1f);
+  generateLodChain(bumpy, 3, 0.5f);
+  ASSERT_EQ(bumpy.lods.size(), 3u);
+  Uint32 offset = baseCount;
+  Uint32 prevCount = baseCount;
+  float prevError = 0.f;
+  for (const MeshLod &lod : bumpy.lods) {
+    EXPECT_EQ(lod.indexOffset, offset);
+    EXPECT_EQ(lod.indexCount % 3, 0u);
+    EXPECT_LT(lod.indexCount, prevCount);
+    EXPECT_GE(lod.error, prevError);
+    for (Uint32 i = 0; i < lod.indexCount; i++)
+      EXPECT_LT(bumpy.indexData[lod.indexOffset + i], bumpy.numVertices());
+    offset += lod.indexCount;
+    prevCount = lod.indexCount;
+    prevError = lod.error;
+  }
+  EXPECT_EQ(offset, bumpy.numIndices());
+  EXPECT_GT(bumpy.lods.back().error, 0.f);
+  EXPECT_LT(bumpy.lods.back().error, 0.1f);
+}
+
+GTEST_TEST(TestMeshData, lod_error_transform) {
+  std::vector<DefaultVertex> vertexData{
+      {{0.f, 0.f, 0.f}, Float3::UnitZ(), Float4::Ones()},
+      {{1.f, 0.f, 0.f}, Float3::UnitZ(), Float4::Ones()},
+      {{0.f, 1.f, 0.f}, Float3::UnitZ(), Float4::Ones()},
+  };
+  std::vector<Uint32> indexData{0, 1, 2, 0, 1, 2};
+  MeshData data{SDL_GPU_PRIMITIVETYPE_TRIANGLELIST, vertexData, indexData};
+  data.lods = {{3, 3, 0.5f}};
+
+  // the errors are distances: they scale once, like the positions
+  Eigen::Affine3f T = Eigen::Affine3f::Identity();
+  T.scale(1e-3f);
+  apply3DTransformInPlace(data, T);
+  EXPECT_FLOAT_EQ(data.lods[0].error, 0.5e-3f);
+
+  // by the largest stretch of a non-uniform scale
+  T.setIdentity();
+  T.scale(Float3{2e3f, 500.f, 1e3f});
+  apply3DTransformInPlace(data, T);
+  EXPECT_FLOAT_EQ(data.lods[0].error, 1.f);
+}
+
+GTEST_TEST(TestMeshData, optimize_mesh) {
+  const Uint32 n = 64;
+  std::vector<DefaultVertex> vertexData;
+  for (Uint32 j = 0; j < n; j++) {
+    for (Uint32 i = 0; i < n; i++) {
+      const Float3 pos{float(i), float(j), 0.f};
+      vertexData.push_back({pos, Float3::UnitZ(), Float4::Ones()});
+    }
+  }
+  std::vector<std::array<Uint32, 3>> tris;
+  for (Uint32 j = 0; j + 1 < n; j++) {
+    for (Uint32 i = 0; i + 1 < n; i++) {
+      const Uint32 v = j * n + i;
+      tris.push_back({v, v + 1, v + n + 1});
+      tris.push_back({v, v + n + 1, v + n});
+    }
+  }
+  std::mt19937 rng{42};
+  std::shuffle(tris.begin(), tris.end(), rng);
+  std::vector<Uint32> indexData;
+  for (auto &tri : tris)
+    indexData.insert(indexData.end(), tri.begin(), tri.end());
+
+  MeshData data{SDL_GPU_PRIMITIVETYPE_TRIANGLELIST, vertexData, indexData};
+  const VertexCacheStats before = analyzeVertexCache(indexData, n * n);
+  MeshOptimizationStats stats;
+  optimizeMesh(data, &stats);
+  const VertexCacheStats after = analyzeVertexCache(data.indexData, n * n);
+  EXPECT_EQ(stats.before.acmr, before.acmr);
+  EXPECT_EQ(stats.after.acmr, after.acmr);
+  EXPECT_EQ(stats.after.atvr, after.atvr);
+  EXPECT_GT(before.acmr, 2.f);
+  EXPECT_LT(after.acmr, 1.f);
+  EXPECT_LT(after.atvr, 2.f);
+  EXPECT_EQ(data.numIndices(), indexData.size());
+
+  // same triangles, up to the vertex reordering
+  auto positionsOf = [](const MeshData &md) {
+    std::vector<std::array<float, 6>> out;
+    for (Uint32 t = 0; t < md.numIndices(); t += 3) {
+      std::array<float, 6> key;
+      for (Uint32 c = 0; c < 3; c++) {
+        const Float3 &p = md.viewAs<DefaultVertex>()[md.indexData[t + c]].pos;
+        key[2 * c] = p.x();
+        key[2 * c + 1] = p.y();
+      }
+      out.push_back(key);
+    }
+    std::sort(out.begin(), out.end());
+    return out;
+  };
+  MeshData ref{SDL_GPU_PRIMITIVETYPE_TRIANGLELIST, vertexData, indexData};
+  EXPECT_EQ(positionsOf(data), positionsOf(ref));
+
+  // vertices are in the order of their first use
+  Uint32 maxSeen = 0;
+  for (Uint32 v : data.indexData) {
+    EXPECT_LE(v, maxSeen + 1);
+    maxSeen = std::max(maxSeen, v);
+  }
+}
+
+GTEST_TEST(TestMeshData, meshlets) {
+  // flat grid in the z = 0 plane, facing +z
+  const Uint32 n = 64;
+  std::vector<DefaultVertex> vertexData;
+  for (Uint32 j = 0; j < n; j++) {
+    for (Uint32 i = 0; i < n; i++) {
+      const Float3 pos{float(i), float(j), 0.f};
+      vertexData.push_back({pos, Float3::UnitZ(), Float4::Ones()});
+    }
+  }
+  std::vector<Uint32> indexData;
+  for (Uint32 j = 0; j + 1 < n; j++) {
+    for (Uint32 i = 0; i + 1 < n; i++) {
+      const Uint32 v = j * n + i;
+      indexData.insert(indexData.end(), {v, v + 1, v + n + 1});
+      indexData.insert(indexData.end(), {v, v + n + 1, v + n});
+    }
+  }
+  MeshData data{SDL_GPU_PRIMITIVETYPE_TRIANGLELIST, vertexData, indexData};
+  optimizeMesh(data);
+  buildMeshlets(data);
+  ASSERT_GT(data.meshlets.size(), 1u);
+
+  // meshlets cover the indices in order, within the size limits
+  Uint32 offset = 0;
+  for (const Meshlet &m : data.meshlets) {
+    EXPECT_EQ(m.indexOffset, offset);
+    EXPECT_LE(m.indexCount / 3, 124u);
+    std::vector<Uint32> vertices{data.indexData.begin() + m.indexOffset,
+                                 data.indexData.begin() + m.indexOffset +
+                                     m.indexCount};
+    std::sort(vertices.begin(), vertices.end());
+    vertices.erase(std::unique(vertices.begin(), vertices.end()),
+                   vertices.end());
+    EXPECT_LE(vertices.size(), 64u);
+    for (Uint32 k = m.indexOffset; k < m.indexOffset + m.indexCount; k++) {
+      const Float3 p =
+          data.getAttribute<Float3>(data.indexData[k], VertexAttrib::Position);
+      EXPECT_LE((p - m.center).norm(), m.radius + 1e-4f);
+    }
+    EXPECT_NEAR(m.coneAxis.dot(Float3::UnitZ()), 1.f, 1e-4f);
+    offset += m.indexCount;
+  }
+  EXPECT_EQ(offset, data.numIndices());
+
+  const Float3 below{32.f, 32.f, -100.f}, above{32.f, 32.f, 100.f};
+  for (const Meshlet &m : data.meshlets) {
+    EXPECT_TRUE(isMeshletBackfacing(m, below));
+    EXPECT_FALSE(isMeshletBackfacing(m, above));
+  }
+
+  // clip volume around the corner x, y in [-8, 8]
+  Mat4f clip = Mat4f::Identity();
+  clip.topLeftCorner<2, 2>() /= 8.f;
+  clip(2, 3) = 0.5f;
+  const FrustumPlanes frustum = FrustumPlanes::fromClipMatrix(clip);
+  std::vector<std::pair<Uint32, Uint32>> runs;
+  const Uint32 numVisible = cullMeshlets(data.meshlets, frustum, &above, runs);
+  EXPECT_GT(numVisible, 0u);
+  EXPECT_LT(numVisible, data.meshlets.size());
+  EXPECT_LE(runs.size(), numVisible);
+  EXPECT_EQ(cullMeshlets(data.meshlets, frustum, &below, runs), 0u);
+  EXPECT_TRUE(runs.empty());
+}
+
+GTEST_TEST(TestMeshData, frustum_culling) {
+  // clip volume x, y in [-8, 8], z in [-0.5, 0.5]
+  Mat4f clip = Mat4f::Identity();
+  clip.topLeftCorner<2, 2>() /= 8.f;
+  clip(2, 3) = 0.5f;
+  const FrustumPlanes frustum = FrustumPlanes::fromClipMatrix(clip);
+
+  // a row of unit boxes, plus an empty (unbounded) one, over an odd count to
+  // exercise the padding
+  AabbBatch batch;
+  std::vector<AABBf> boxes;
+  for (int i = -10; i <= 10; i++) {
+    const Float3 lo{float(i), 0.f, 0.f};
+    boxes.emplace_back(lo, lo + Float3::Ones());
+  }
+  boxes.emplace_back();
+  for (const AABBf &box : boxes)
+    batch.push(box);
+  ASSERT_EQ(batch.size(), boxes.size());
+
+  std::vector<Uint8> visible;
+  batch.cull(frustum, visible);
+  ASSERT_EQ(visible.size(), boxes.size());
+  for (size_t i = 0; i < boxes.size(); i++)
+    EXPECT_EQ(bool(visible[i]), frustum.intersectsBox(boxes[i])) << i;
+  EXPECT_FALSE(visible[0]);  // [-10, -9]
+  EXPECT_TRUE(visible[10]);  // [0, 1]
+  EXPECT_TRUE(visible[18]);  // [8, 9] touches the plane x = 8
+  EXPECT_FALSE(visible[19]); // [9, 10]
+  EXPECT_TRUE(visible.back());
+
+  // rotation by 90 degrees about z, and translation
+  Mat4f tr = Mat4f::Identity();
+  tr.topLeftCorner<3, 3>() =
+      Eigen::AngleAxisf(0.5f * constants::Pif, Float3::UnitZ())
+          .toRotationMatrix();
+  tr.topRightCorner<3, 1>() = Float3{0.f, 0.f, 5.f};
+  const AABBf box = transformBox(boxes[12], tr); // [2, 3] x [0, 1] x [0, 1]
+  EXPECT_TRUE(box.min().isApprox(Float3{-1.f, 2.f, 5.f}, 1e-5f));
+  EXPECT_TRUE(box.max().isApprox(Float3{0.f, 3.f, 6.f}, 1e-5f));
+  EXPECT_TRUE(transformBox(AABBf{}, tr).isEmpty());
+}
+
+GTEST_TEST(TestMeshData, frustum_from_corners) {
+  // box [-1, 3] x [-2, 2] x [0, 5], with corners ordered by their index bits
+  FrustumCornersType corners;
+  for (Uint8 i = 0; i < 8; i++)
+    corners[i] = {i & 1 ? 3.f : -1.f, i & 2 ? 2.f : -2.f, i & 4 ? 5.f : 0.f};
+  const FrustumPlanes frustum = FrustumPlanes::fromCorners(corners);
+  const Float4 expected[6] = {{1.f, 0.f, 0.f, 1.f},  {-1.f, 0.f, 0.f, 3.f},
+                              {0.f, 1.f, 0.f, 2.f},  {0.f, -1.f, 0.f, 2.f},
+                              {0.f, 0.f, 1.f, 0.f},  {0.f, 0.f, -1.f, 5.f}};
+  for (size_t i = 0; i < 6; i++)
+    EXPECT_TRUE(frustum.planes[i].isApprox(expected[i], 1e-5f)) << i;
+  const AABBf inside{Float3{2.f, 1.f, 4.f}, Float3{4.f, 3.f, 6.f}};
+  const AABBf outside{Float3{3.5f, 0.f, 1.f}, Float3{4.f, 1.f, 2.f}};
+  EXPECT_TRUE(frustum.intersectsBox(inside));
+  EXPECT_FALSE(frustum.intersectsBox(outside));
+}
+
 int main(int argc, char **argv) {
   testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();
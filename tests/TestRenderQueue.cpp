@@ -0,0 +1,162 @@
+#include "candlewick/core/Mesh.h"
+#include "candlewick/core/RenderQueue.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstdint>
+
+using namespace candlewick;
+
+template <typename T> static T *fakeHandle(std::uintptr_t id) {
+  return reinterpret_cast<T *>(id);
+}
+
+/// Mesh with fake buffers and two views, which is never bound: a Mesh without
+/// a device does not release its buffers.
+static Mesh makeMesh(std::uintptr_t id) {
+  Mesh mesh{NoInit};
+  mesh.vertexBuffers = {fakeHandle<SDL_GPUBuffer>(id)};
+  mesh.indexBuffer = fakeHandle<SDL_GPUBuffer>(id + 1);
+  mesh.vertexCount = 8;
+  mesh.indexCount = 12;
+  mesh.addView(0, 4, 0, 6);
+  mesh.addView(4, 4, 6, 6);
+  return mesh;
+}
+
+static PbrMaterial makeMaterial(float roughness) {
+  PbrMaterial material;
+  material.roughness = roughness;
+  return material;
+}
+
+GTEST_TEST(TestRenderQueue, key_ordering) {
+  // pipeline > mesh > material > depth
+  EXPECT_LT(RenderQueue::makeKey(0, 9, 9, 1000),
+            RenderQueue::makeKey(1, 0, 0, 0));
+  EXPECT_LT(RenderQueue::makeKey(0, 0, 9, 1000),
+            RenderQueue::makeKey(0, 1, 0, 0));
+  EXPECT_LT(RenderQueue::makeKey(0, 0, 0, 1000),
+            RenderQueue::makeKey(0, 0, 1, 0));
+  EXPECT_LT(RenderQueue::makeKey(0, 0, 0, 1), RenderQueue::makeKey(0, 0, 0, 2));
+
+  // fields are clamped, and do not spill into the next ones
+  EXPECT_EQ(RenderQueue::makeKey(0, 0, 0, 1u << 20),
+            RenderQueue::makeKey(0, 0, 0, (1u << RenderQueue::kDepthBits) - 1));
+  EXPECT_LT(RenderQueue::makeKey(0, 0, 0, 1u << 20),
+            RenderQueue::makeKey(0, 0, 1, 0));
+  EXPECT_LT(RenderQueue::makeKey(0, 0, 1u << 30, 0),
+            RenderQueue::makeKey(0, 1, 0, 0));
+  EXPECT_LT(RenderQueue::makeKey(0, 1u << 30, 0, 0),
+            RenderQueue::makeKey(1, 0, 0, 0));
+}
+
+GTEST_TEST(TestRenderQueue, depth_bucket) {
+  EXPECT_EQ(RenderQueue::depthBucket(0.f), 0u);
+  EXPECT_EQ(RenderQueue::depthBucket(-1.f), 0u);
+  EXPECT_LT(RenderQueue::depthBucket(1.f), RenderQueue::depthBucket(2.f));
+  EXPECT_LT(RenderQueue::depthBucket(10.f), RenderQueue::depthBucket(11.f));
+  EXPECT_EQ(RenderQueue::depthBucket(1e30f),
+            (1u << RenderQueue::kDepthBits) - 1);
+}
+
+GTEST_TEST(TestRenderQueue, sort_groups_state) {
+  auto *pipeline = fakeHandle<SDL_GPUGraphicsPipeline>(0x100);
+  const Mesh meshA = makeMesh(0x1000);
+  const Mesh meshB = makeMesh(0x2000);
+  const PbrMaterial material = makeMaterial(0.5f);
+  RenderQueue queue;
+  // interleaved meshes, pushed far to near
+  for (Uint32 i = 0; i < 8; i++) {
+    const Mesh &mesh = i % 2 ? meshB : meshA;
+    queue.push(pipeline, mesh, 0, 0, material, i, 100.f - 10.f * float(i));
+  }
+  queue.sort();
+
+  const auto packets = queue.packets();
+  ASSERT_EQ(packets.size(), 8u);
+  EXPECT_TRUE(std::ranges::is_sorted(packets, {}, &DrawPacket::key));
+  // one mesh change over the whole queue, whatever the depths
+  for (size_t i = 0; i < 4; i++) {
+    EXPECT_EQ(packets[i].mesh, &meshA);
+    EXPECT_EQ(packets[i + 4].mesh, &meshB);
+  }
+  // front to back within each mesh
+  for (size_t i = 1; i < 4; i++) {
+    EXPECT_GT(packets[i - 1].object, packets[i].object);
+    EXPECT_GT(packets[i + 3].object, packets[i + 4].object);
+  }
+}
+
+GTEST_TEST(TestRenderQueue, sort_stability) {
+  auto *pipeline = fakeHandle<SDL_GPUGraphicsPipeline>(0x100);
+  const Mesh mesh = makeMesh(0x1000);
+  const PbrMaterial materials[] = {makeMaterial(0.1f), makeMaterial(0.2f),
+                                   makeMaterial(0.3f)};
+  RenderQueue queue;
+  // few distinct keys, over several bytes of the key
+  const float depths[] = {1.f, 1000.f};
+  for (Uint32 i = 0; i < 300; i++)
+    queue.push(pipeline, mesh, 0, 0, materials[i % 3], i, depths[i % 2]);
+  queue.sort();
+
+  const auto packets = queue.packets();
+  ASSERT_EQ(packets.size(), 300u);
+  for (size_t i = 1; i < packets.size(); i++) {
+    ASSERT_LE(packets[i - 1].key, packets[i].key);
+    // draws with equal keys keep the order they were pushed in
+    if (packets[i - 1].key == packets[i].key)
+      EXPECT_LT(packets[i - 1].object, packets[i].object);
+  }
+}
+
+GTEST_TEST(TestRenderQueue, merge_instances) {
+  auto *pipeline = fakeHandle<SDL_GPUGraphicsPipeline>(0x100);
+  auto *instanced = fakeHandle<SDL_GPUGraphicsPipeline>(0x200);
+  const Mesh mesh = makeMesh(0x1000);
+  const PbrMaterial red = makeMaterial(0.1f);
+  const PbrMaterial blue = makeMaterial(0.9f);
+  RenderQueue queue;
+  queue.push(pipeline, mesh, 0, 0, red, 10, 30.f);
+  queue.push(pipeline, mesh, 0, 0, red, 11, 2.f);
+  queue.push(pipeline, mesh, 0, 0, red, 12, 20.f);
+  // another view, material or a payload keep their draws apart
+  queue.push(pipeline, mesh, 0, 1, red, 13, 5.f);
+  queue.push(pipeline, mesh, 0, 0, blue, 14, 5.f);
+  queue.push(pipeline, mesh, 0, 0, red, 15, 5.f, 1);
+  queue.mergeInstances(instanced, 2);
+  queue.sort();
+
+  const auto packets = queue.packets();
+  ASSERT_EQ(packets.size(), 4u);
+  auto it = std::ranges::find_if(packets, &DrawPacket::isInstanced);
+  ASSERT_NE(it, packets.end());
+  EXPECT_EQ(std::ranges::count_if(packets, &DrawPacket::isInstanced), 1);
+  EXPECT_EQ(it->pipeline, instanced);
+  EXPECT_EQ(it->viewIndex, 0u);
+  EXPECT_EQ(it->object, RenderQueue::kInstancedObject | it->firstInstance);
+  ASSERT_EQ(it->instanceCount, 3u);
+  const auto objects =
+      queue.instanceObjects().subspan(it->firstInstance, it->instanceCount);
+  EXPECT_TRUE(std::ranges::equal(objects, std::vector<Uint32>{10, 11, 12}));
+  // keyed on the nearest object
+  EXPECT_EQ(it->key & ((1u << RenderQueue::kDepthBits) - 1),
+            RenderQueue::depthBucket(2.f));
+
+  for (const DrawPacket &packet : packets) {
+    if (!packet.isInstanced())
+      EXPECT_EQ(packet.pipeline, pipeline);
+  }
+
+  // groups below the minimum stay as they are
+  RenderQueue small;
+  small.push(pipeline, mesh, 0, 0, red, 0, 1.f);
+  small.push(pipeline, mesh, 0, 0, red, 1, 1.f);
+  small.mergeInstances(instanced, 3);
+  EXPECT_EQ(small.size(), 2u);
+  EXPECT_TRUE(small.instanceObjects().empty());
+}
+
+int main(int argc, char **argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
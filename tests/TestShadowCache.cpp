@@ -0,0 +1,109 @@
+#include "candlewick/core/DepthAndShadowPass.h"
+#include <gtest/gtest.h>
+#include <vector>
+
+using namespace candlewick;
+
+static OpaqueCastable makeCastable(const Mesh &mesh, const Mat4f &transform,
+                                   bool isStatic) {
+  return {.ent = entt::entity{},
+          .mesh = mesh,
+          .transform = transform,
+          .isStatic = isStatic};
+}
+
+static Mat4f translation(float x) {
+  Mat4f T = Mat4f::Identity();
+  T(0, 3) = x;
+  return T;
+}
+
+/// Cache after a first render of \p castables, with both layers drawn.
+static ShadowPassInfo::Cache
+renderedCache(const Mat4f &viewProj,
+              std::span<const OpaqueCastable> castables) {
+  ShadowPassInfo::Cache cache;
+  cache.update(viewProj, castables);
+  EXPECT_FALSE(cache.staticValid);
+  EXPECT_FALSE(cache.valid);
+  cache.staticValid = cache.valid = true;
+  return cache;
+}
+
+GTEST_TEST(TestShadowCache, idle_scene) {
+  Mesh ground{NoInit}, robot{NoInit};
+  const Mat4f viewProj = Mat4f::Identity();
+  std::vector castables{makeCastable(ground, Mat4f::Identity(), true),
+                        makeCastable(robot, translation(1.f), false)};
+  auto cache = renderedCache(viewProj, castables);
+
+  for (int frame = 0; frame < 3; frame++) {
+    cache.update(viewProj, castables);
+    EXPECT_TRUE(cache.staticValid);
+    EXPECT_TRUE(cache.valid);
+  }
+}
+
+GTEST_TEST(TestShadowCache, moved_caster) {
+  Mesh ground{NoInit}, robot{NoInit};
+  const Mat4f viewProj = Mat4f::Identity();
+  std::vector castables{makeCastable(ground, Mat4f::Identity(), true),
+                        makeCastable(robot, translation(1.f), false)};
+  auto cache = renderedCache(viewProj, castables);
+
+  // a dynamic caster only invalidates the shadow map
+  castables[1].transform = translation(2.f);
+  cache.update(viewProj, castables);
+  EXPECT_TRUE(cache.staticValid);
+  EXPECT_FALSE(cache.valid);
+  cache.valid = true;
+
+  // a static caster invalidates its layer too
+  castables[0].transform = translation(-1.f);
+  cache.update(viewProj, castables);
+  EXPECT_FALSE(cache.staticValid);
+  EXPECT_TRUE(cache.valid);
+}
+
+GTEST_TEST(TestShadowCache, changed_light) {
+  Mesh ground{NoInit}, robot{NoInit};
+  const Mat4f viewProj = Mat4f::Identity();
+  std::vector castables{makeCastable(ground, Mat4f::Identity(), true),
+                        makeCastable(robot, translation(1.f), false)};
+  auto cache = renderedCache(viewProj, castables);
+
+  const Mat4f newViewProj = translation(0.5f);
+  cache.update(newViewProj, castables);
+  EXPECT_FALSE(cache.staticValid);
+  EXPECT_FALSE(cache.valid);
+  EXPECT_EQ(cache.viewProj, newViewProj);
+}
+
+GTEST_TEST(TestShadowCache, changed_caster_count) {
+  Mesh ground{NoInit}, robot{NoInit}, tool{NoInit};
+  const Mat4f viewProj = Mat4f::Identity();
+  std::vector castables{makeCastable(ground, Mat4f::Identity(), true),
+                        makeCastable(robot, translation(1.f), false)};
+  auto cache = renderedCache(viewProj, castables);
+
+  castables.push_back(makeCastable(tool, translation(3.f), false));
+  cache.update(viewProj, castables);
+  EXPECT_TRUE(cache.staticValid);
+  EXPECT_FALSE(cache.valid);
+  EXPECT_EQ(cache.dynamicCasters.size(), 2u);
+  cache.valid = true;
+
+  // castables hold a reference: they are copied rather than erased
+  const std::vector withoutRobot{castables[0], castables[2]};
+  cache.update(viewProj, withoutRobot);
+  EXPECT_TRUE(cache.staticValid);
+  EXPECT_FALSE(cache.valid);
+  EXPECT_EQ(cache.dynamicCasters.size(), 1u);
+  cache.valid = true;
+
+  const std::vector withoutGround{castables[2]};
+  cache.update(viewProj, withoutGround);
+  EXPECT_FALSE(cache.staticValid);
+  EXPECT_TRUE(cache.valid);
+  EXPECT_TRUE(cache.staticCasters.empty());
+}